@@ -0,0 +1,467 @@
+#include "harness.hpp"
+#include <josa/visitor.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Single and double dispatch: ns/visit of josa::visitor::dispatcher against the usual
+//  alternatives, which are
+//
+//      accept          a classic visitor, with a virtual accept in the classes and a virtual visit
+//                      per concrete type in the visitor (for double dispatch, a visitor per
+//                      concrete type of the first object visits the second)
+//      std::visit      objects held by value in a std::variant of the concrete types
+//      dynamic_cast    an if-chain of dynamic_casts, one per concrete type, in the style of
+//                      makeConcatenation in test/example-regex.cpp
+//
+//  for hierarchies of increasing size. Each is measured over objects in sorted type order, where
+//  consecutive visits share a type, and in random type order; with warm caches, running over the
+//  same objects repeatedly, and with cold caches, evicted before each run; and, warm and random,
+//  with 2 and more threads each visiting their own objects, up to the hardware thread count.
+//  The results are printed and written as JSON, by default to bench-baselines.json:
+//
+//      bench-baselines [output.json]
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t object_count = 1 << 12;
+
+    //  The classic visitor: the interface has a pure virtual visit per concrete type, and each
+    //  class accepts a visitor by calling the visit for its type. The interface declares one visit
+    //  per level of single inheritance, so that, as when written out by hand, it has one vtable.
+    //
+    template <typename TypeList> struct visit_each;
+
+    template <typename T>
+    struct visit_each<josa::meta::list<T>>
+    {
+        virtual ~visit_each() = default;
+        virtual auto visit(const T& obj) const -> std::size_t = 0;
+    };
+
+    template <typename T, typename... Ts>
+    struct visit_each<josa::meta::list<T, Ts...>> : visit_each<josa::meta::list<Ts...>>
+    {
+        using visit_each<josa::meta::list<Ts...>>::visit;
+        virtual auto visit(const T& obj) const -> std::size_t = 0;
+    };
+
+    template <std::size_t N, std::size_t I> struct leaf;
+
+    template <std::size_t N, typename IS = std::make_index_sequence<N>> struct visitor_of;
+
+    template <std::size_t N, std::size_t... I>
+    struct visitor_of<N, std::index_sequence<I...>> { using type = visit_each<josa::meta::list<leaf<N, I>...>>; };
+
+    template <std::size_t N>
+    using visitor = typename visitor_of<N>::type;
+
+    template <std::size_t N>
+    struct node
+    {
+        virtual ~node() = default;
+        virtual auto accept(const visitor<N>& v) const -> std::size_t = 0;
+
+        std::size_t payload = 0;
+    };
+
+    template <std::size_t N, std::size_t I>
+    struct leaf final : node<N>
+    {
+        auto accept(const visitor<N>& v) const -> std::size_t override { return v.visit(*this); }
+    };
+
+    //  Overrides the visit for each type of the list by calling Impl::apply, one type per level.
+    //
+    template <typename Impl, typename Interface, typename TypeList> struct implement;
+
+    template <typename Impl, typename Interface>
+    struct implement<Impl, Interface, josa::meta::list<>> : Interface {};
+
+    template <typename Impl, typename Interface, typename T, typename... Ts>
+    struct implement<Impl, Interface, josa::meta::list<T, Ts...>> : implement<Impl, Interface, josa::meta::list<Ts...>>
+    {
+        auto visit(const T& obj) const -> std::size_t override { return static_cast<const Impl&>(*this).apply(obj); }
+    };
+
+    template <std::size_t N, std::size_t I> struct value_leaf { std::size_t payload = 0; };
+
+    template <std::size_t N, std::size_t I>
+    auto leaf_value(const leaf<N, I>& obj) -> std::size_t { return I + obj.payload; }
+
+    template <std::size_t N, std::size_t I>
+    auto leaf_value(const value_leaf<N, I>& obj) -> std::size_t { return I + obj.payload; }
+
+    struct single_handler
+    {
+        template <typename T>
+        auto operator () (const T& obj) const -> std::size_t { return leaf_value(obj); }
+    };
+
+    struct double_handler
+    {
+        template <typename T1, typename T2>
+        auto operator () (const T1& a, const T2& b) const -> std::size_t { return leaf_value(a) * 31 + leaf_value(b); }
+    };
+
+    //  The types, and each way of dispatching, for a hierarchy of N concrete types.
+    //
+    template <std::size_t N, typename IS = std::make_index_sequence<N>> struct family;
+
+    template <std::size_t N, std::size_t... I>
+    struct family<N, std::index_sequence<I...>>
+    {
+        using base_t = node<N>;
+        using concretes_t = josa::meta::list<leaf<N, I>...>;
+        using hierarchy_t = jv::hierarchy<jv::base_type<base_t>, jv::concrete_types<leaf<N, I>...>>;
+        using variant_t = std::variant<value_leaf<N, I>...>;
+
+        static auto make(const std::size_t type, const std::size_t payload) -> std::unique_ptr<base_t>
+        {
+            using factory_t = std::unique_ptr<base_t>(*)();
+            static constexpr std::array<factory_t, N> factories =
+                {+[]() -> std::unique_ptr<base_t> { return std::make_unique<leaf<N, I>>(); }...};
+
+            auto p = factories[type]();
+            p->payload = payload;
+            return p;
+        }
+
+        static auto make_value(const std::size_t type, const std::size_t payload) -> variant_t
+        {
+            using factory_t = variant_t(*)(std::size_t);
+            static constexpr std::array<factory_t, N> factories =
+                {+[](const std::size_t p) -> variant_t { return value_leaf<N, I>{p}; }...};
+
+            return factories[type](payload);
+        }
+
+        struct single_visitor : implement<single_visitor, visitor<N>, concretes_t>
+        {
+            template <typename T>
+            auto apply(const T& obj) const -> std::size_t { return single_handler{}(obj); }
+        };
+
+        template <typename First>
+        struct second_visitor : implement<second_visitor<First>, visitor<N>, concretes_t>
+        {
+            explicit second_visitor(const First& first) : first{first} {}
+
+            template <typename T>
+            auto apply(const T& obj) const -> std::size_t { return double_handler{}(first, obj); }
+
+            const First& first;
+        };
+
+        struct first_visitor : implement<first_visitor, visitor<N>, concretes_t>
+        {
+            explicit first_visitor(const base_t& second) : second{second} {}
+
+            template <typename T>
+            auto apply(const T& obj) const -> std::size_t { return second.accept(second_visitor<T>{obj}); }
+
+            const base_t& second;
+        };
+
+        template <typename T, typename G>
+        static auto try_cast(const base_t& obj, G&& g, std::size_t& result) -> bool
+        {
+            if (const auto* p = dynamic_cast<const T*>(&obj))
+            {
+                result = g(*p);
+                return true;
+            }
+
+            return false;
+        }
+
+        template <typename G>
+        static auto dynamic_cast_chain(const base_t& obj, G&& g) -> std::size_t
+        {
+            auto result = std::size_t{0};
+
+            if (!(try_cast<leaf<N, I>>(obj, g, result) || ...))
+                throw jv::unhandled_type{"not a leaf"};
+
+            return result;
+        }
+
+        static auto visit_accept(const base_t& obj) -> std::size_t { return obj.accept(single_visitor{}); }
+        static auto visit_accept(const base_t& a, const base_t& b) -> std::size_t { return a.accept(first_visitor{b}); }
+
+        static auto visit_dynamic_cast(const base_t& obj) -> std::size_t
+        {
+            return dynamic_cast_chain(obj, single_handler{});
+        }
+
+        static auto visit_dynamic_cast(const base_t& a, const base_t& b) -> std::size_t
+        {
+            return dynamic_cast_chain(a, [&b](const auto& a2) {
+                return dynamic_cast_chain(b, [&a2](const auto& b2) { return double_handler{}(a2, b2); }); });
+        }
+    };
+
+    enum class method { josa, accept, std_visit, dynamic_cast_chain };
+    enum class order { sorted, random };
+
+    constexpr std::array<method, 4> methods = {method::josa, method::accept, method::std_visit, method::dynamic_cast_chain};
+
+    auto name_of(const method m) -> const char*
+    {
+        switch (m)
+        {
+            case method::josa:                  return "dispatcher::visit";
+            case method::accept:                return "accept";
+            case method::std_visit:             return "std::visit";
+            case method::dynamic_cast_chain:    return "dynamic_cast";
+        }
+
+        return "";
+    }
+
+    auto name_of(const order o) -> const char*
+    {
+        return o == order::sorted ? "sorted" : "random";
+    }
+
+    //  The concrete types of object_count objects: in blocks of one type, or drawn at random.
+    //
+    auto type_sequence(const std::size_t n, const order o, const unsigned seed) -> std::vector<std::size_t>
+    {
+        auto types = std::vector<std::size_t>(object_count);
+        auto rng = std::mt19937{seed};
+        auto dist = std::uniform_int_distribution<std::size_t>{0, n - 1};
+
+        for (std::size_t i = 0; i < object_count; ++i)
+            types[i] = o == order::sorted ? i * n / object_count : dist(rng);
+
+        return types;
+    }
+
+    //  The objects one thread visits, with the same types both as pointers to the hierarchy and as
+    //  variants. Double dispatch visits the i-th object of each sequence together.
+    //
+    template <std::size_t N, std::size_t Arity>
+    struct workload
+    {
+        using family_t = family<N>;
+
+        workload(const order o, const unsigned seed)
+        {
+            for (std::size_t k = 0; k < Arity; ++k)
+            {
+                for (const auto type : type_sequence(N, o, seed + static_cast<unsigned>(k)))
+                {
+                    objs[k].push_back(family_t::make(type, objs[k].size()));
+                    values[k].push_back(family_t::make_value(type, values[k].size()));
+                }
+            }
+        }
+
+        //  The method is switched on per visit, the same for every method, so that the loop is not
+        //  specialized for one of them; the branch is perfectly predicted.
+        //
+        auto run(const method m) const -> std::size_t
+        {
+            using dispatcher_t = std::conditional_t<Arity == 1,
+                jv::dispatcher<typename family_t::hierarchy_t>,
+                jv::dispatcher<typename family_t::hierarchy_t, typename family_t::hierarchy_t>>;
+
+            auto sum = std::size_t{0};
+
+            for (std::size_t i = 0; i < object_count; ++i)
+            {
+                if constexpr (Arity == 1)
+                {
+                    switch (m)
+                    {
+                        case method::josa:                  sum += dispatcher_t::visit(single_handler{}, *objs[0][i]); break;
+                        case method::accept:                sum += family_t::visit_accept(*objs[0][i]); break;
+                        case method::std_visit:             sum += std::visit(single_handler{}, values[0][i]); break;
+                        case method::dynamic_cast_chain:    sum += family_t::visit_dynamic_cast(*objs[0][i]); break;
+                    }
+                }
+                else
+                {
+                    switch (m)
+                    {
+                        case method::josa:                  sum += dispatcher_t::visit(double_handler{}, *objs[0][i], *objs[1][i]); break;
+                        case method::accept:                sum += family_t::visit_accept(*objs[0][i], *objs[1][i]); break;
+                        case method::std_visit:             sum += std::visit(double_handler{}, values[0][i], values[1][i]); break;
+                        case method::dynamic_cast_chain:    sum += family_t::visit_dynamic_cast(*objs[0][i], *objs[1][i]); break;
+                    }
+                }
+            }
+
+            return sum;
+        }
+
+        std::array<std::vector<std::unique_ptr<typename family_t::base_t>>, Arity> objs;
+        std::array<std::vector<typename family_t::variant_t>, Arity> values;
+    };
+
+    template <std::size_t N, std::size_t Arity>
+    auto measure_threads(const method m, const std::size_t threads) -> double
+    {
+        constexpr int passes = 20;
+
+        auto ready = std::atomic<std::size_t>{0};
+        auto go = std::atomic<bool>{false};
+        auto pool = std::vector<std::thread>{};
+
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            pool.emplace_back([&, t] {
+                const auto w = workload<N, Arity>{order::random, 100 + static_cast<unsigned>(t)};
+                bench::do_not_optimize(w.run(m));
+
+                ready.fetch_add(1);
+
+                while (!go.load())
+                    std::this_thread::yield();
+
+                for (int p = 0; p < passes; ++p)
+                    bench::do_not_optimize(w.run(m));
+            });
+        }
+
+        while (ready.load() != threads)
+            std::this_thread::yield();
+
+        const auto start = std::chrono::steady_clock::now();
+        go.store(true);
+
+        for (auto& thread : pool)
+            thread.join();
+
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        return elapsed.count() / (passes * object_count);
+    }
+
+    struct result
+    {
+        const char* dispatch;
+        const char* method;
+        std::size_t types;
+        const char* order;
+        const char* cache;
+        std::size_t threads;
+        double ns;
+    };
+
+    auto thread_counts() -> std::vector<std::size_t>
+    {
+        const auto hardware = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+        auto counts = std::vector<std::size_t>{};
+
+        for (std::size_t t = 2; t < hardware; t *= 2)
+            counts.push_back(t);
+
+        if (hardware > 1)
+            counts.push_back(hardware);
+
+        return counts;
+    }
+
+    template <std::size_t N, std::size_t Arity>
+    auto run(std::vector<result>& results) -> void
+    {
+        const auto* dispatch = Arity == 1 ? "single" : "double";
+
+        for (const auto o : {order::sorted, order::random})
+        {
+            const auto w = workload<N, Arity>{o, 1};
+
+            for (const auto m : methods)
+            {
+                const auto warm = bench::ns_per_op([&] { bench::do_not_optimize(w.run(m)); }, object_count);
+                const auto cold = bench::ns_per_op_cold([&] { bench::do_not_optimize(w.run(m)); }, object_count);
+
+                results.push_back({dispatch, name_of(m), N, name_of(o), "warm", 1, warm});
+                results.push_back({dispatch, name_of(m), N, name_of(o), "cold", 1, cold});
+
+                std::printf("  %-20s N=%-4zu %-7s %8.2f ns/op warm %8.2f ns/op cold\n", name_of(m), N, name_of(o), warm, cold);
+            }
+        }
+
+        for (const auto threads : thread_counts())
+        {
+            for (const auto m : methods)
+            {
+                const auto ns = measure_threads<N, Arity>(m, threads);
+                results.push_back({dispatch, name_of(m), N, "random", "warm", threads, ns});
+
+                std::printf("  %-20s N=%-4zu %-7s %8.2f ns/op, %zu threads\n", name_of(m), N, "random", ns, threads);
+            }
+        }
+    }
+
+    auto write_json(const char* path, const std::vector<result>& results) -> bool
+    {
+        auto* out = std::fopen(path, "w");
+
+        if (!out)
+            return false;
+
+#if defined(__VERSION__)
+        const auto* compiler = __VERSION__;
+#else
+        const auto* compiler = "unknown";
+#endif
+
+        std::fprintf(out, "{\n  \"benchmark\": \"bench-baselines\",\n  \"compiler\": \"%s\",\n", compiler);
+        std::fprintf(out, "  \"hardware_threads\": %u,\n  \"objects\": %zu,\n  \"results\": [\n", std::thread::hardware_concurrency(), object_count);
+
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& r = results[i];
+
+            std::fprintf(out, "    {\"dispatch\": \"%s\", \"method\": \"%s\", \"types\": %zu, \"order\": \"%s\", \"cache\": \"%s\", "
+                "\"threads\": %zu, \"ns_per_op\": %.3f}%s\n",
+                r.dispatch, r.method, r.types, r.order, r.cache, r.threads, r.ns, i + 1 < results.size() ? "," : "");
+        }
+
+        std::fprintf(out, "  ]\n}\n");
+        return std::fclose(out) == 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const auto* output = argc > 1 ? argv[1] : "bench-baselines.json";
+    auto results = std::vector<result>{};
+
+    bench::print_header("single dispatch");
+
+    run<2, 1>(results);
+    run<8, 1>(results);
+    run<32, 1>(results);
+    run<128, 1>(results);
+
+    bench::print_header("double dispatch");
+
+    run<2, 2>(results);
+    run<8, 2>(results);
+    run<32, 2>(results);
+
+    if (!write_json(output, results))
+    {
+        std::fprintf(stderr, "cannot write %s\n", output);
+        return 1;
+    }
+
+    std::printf("\nwrote %s\n", output);
+}
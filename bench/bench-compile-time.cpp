@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Measures what visitors cost the compiler. Compiles compile-time-probe.cpp once per
+//  configuration, with the compiler and flags the benchmarks are built with, and records the wall
+//  time, peak memory of the compiler and size of the object file of each into a CSV file:
+//
+//      bench-compile-time [output.csv] [repetitions]
+//
+//  The output defaults to compile-time.csv; each configuration is compiled `repetitions` times
+//  (default 1), keeping the fastest time and the highest peak. Configurations are single dispatch
+//  over 8 to 512 types, through dispatcher, enable_dispatch and an enable_dispatch visitor declared
+//  with JOSA_VISITOR_EXTERN, and double dispatch and meta::all_pairs_t over 8 x 8 to 64 x 64
+//  types. Requires a POSIX system.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    struct configuration
+    {
+        const char* kind;
+        const char* macro;
+        std::size_t types;
+        std::size_t types2;
+    };
+
+    struct measurement
+    {
+        bool ok = false;
+        double seconds = 0;
+        double peak_mb = 0;
+        std::uintmax_t object_bytes = 0;
+    };
+
+    auto configurations() -> std::vector<configuration>
+    {
+        auto configs = std::vector<configuration>{};
+
+        for (const std::size_t n : {8, 32, 128, 512})
+        {
+            configs.push_back({"dispatcher", "PROBE_DISPATCHER", n, 0});
+            configs.push_back({"enable_dispatch", "PROBE_ENABLE_DISPATCH", n, 0});
+            configs.push_back({"extern", "PROBE_EXTERN", n, 0});
+        }
+
+        for (const std::size_t n : {8, 16, 32, 64})
+        {
+            configs.push_back({"double_dispatch", "PROBE_DOUBLE", n, n});
+            configs.push_back({"all_pairs", "PROBE_ALL_PAIRS", n, n});
+        }
+
+        return configs;
+    }
+
+    //  Splits the compiler flags CMake passes on spaces; flags containing spaces are not supported.
+    //
+    auto split(const std::string& flags) -> std::vector<std::string>
+    {
+        auto words = std::vector<std::string>{};
+        auto word = std::string{};
+
+        for (const char c : flags + ' ')
+        {
+            if (c != ' ')
+                word += c;
+            else if (!word.empty())
+                words.push_back(std::exchange(word, {}));
+        }
+
+        return words;
+    }
+
+    //  Runs the compiler and returns its wall time and peak resident memory.
+    //
+    auto compile(const configuration& config, const std::filesystem::path& object) -> measurement
+    {
+        auto args = std::vector<std::string>{JOSA_BENCH_CXX};
+
+        for (auto& flag : split(JOSA_BENCH_CXX_FLAGS))
+            args.push_back(std::move(flag));
+
+        args.push_back("-I" JOSA_BENCH_INCLUDE_DIR);
+        args.push_back("-D" + std::string{config.macro});
+        args.push_back("-DPROBE_TYPES=" + std::to_string(config.types));
+
+        if (config.types2 != 0)
+            args.push_back("-DPROBE_TYPES2=" + std::to_string(config.types2));
+
+        args.insert(args.end(), {"-c", JOSA_BENCH_PROBE_SOURCE, "-o", object.string()});
+
+        auto argv = std::vector<char*>{};
+
+        for (auto& arg : args)
+            argv.push_back(arg.data());
+
+        argv.push_back(nullptr);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto pid = fork();
+
+        if (pid == 0)
+        {
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+
+        auto status = 0;
+        auto usage = rusage{};
+
+        if (pid < 0 || wait4(pid, &status, 0, &usage) != pid)
+            return {};
+
+        auto m = measurement{};
+
+        m.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        m.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#if defined(__APPLE__)
+        m.peak_mb = static_cast<double>(usage.ru_maxrss) / (1024 * 1024);      // bytes
+#else
+        m.peak_mb = static_cast<double>(usage.ru_maxrss) / 1024;               // kilobytes
+#endif
+
+        if (m.ok)
+            m.object_bytes = std::filesystem::file_size(object);
+
+        return m;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const auto output = std::string{argc > 1 ? argv[1] : "compile-time.csv"};
+    const auto repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+    const auto object = std::filesystem::temp_directory_path() / ("josa-compile-time-" + std::to_string(getpid()) + ".o");
+
+    auto* csv = std::fopen(output.c_str(), "w");
+
+    if (!csv)
+    {
+        std::fprintf(stderr, "cannot write %s\n", output.c_str());
+        return 1;
+    }
+
+    std::fprintf(csv, "kind,types,types2,seconds,peak_mb,object_bytes\n");
+    std::printf("\n%-16s %7s %9s %10s %12s\n", "kind", "types", "seconds", "peak MB", "object bytes");
+
+    auto failed = false;
+
+    for (const auto& config : configurations())
+    {
+        auto best = compile(config, object);
+
+        for (int r = 1; r < repetitions && best.ok; ++r)
+        {
+            const auto m = compile(config, object);
+            best.seconds = std::min(best.seconds, m.seconds);
+            best.peak_mb = std::max(best.peak_mb, m.peak_mb);
+        }
+
+        const auto types = config.types2 == 0 ? std::to_string(config.types)
+            : std::to_string(config.types) + "x" + std::to_string(config.types2);
+
+        if (!best.ok)
+        {
+            std::printf("%-16s %7s   failed to compile\n", config.kind, types.c_str());
+            failed = true;
+            continue;
+        }
+
+        std::printf("%-16s %7s %9.2f %10.1f %12ju\n", config.kind, types.c_str(), best.seconds, best.peak_mb, best.object_bytes);
+        std::fprintf(csv, "%s,%zu,%zu,%.3f,%.1f,%ju\n", config.kind, config.types, config.types2, best.seconds, best.peak_mb, best.object_bytes);
+        std::fflush(csv);
+    }
+
+    std::fclose(csv);
+    std::filesystem::remove(object);
+    std::printf("\nwrote %s\n", output.c_str());
+
+    return failed ? 1 : 0;
+}
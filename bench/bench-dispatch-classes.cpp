@@ -0,0 +1,110 @@
+#include "harness.hpp"
+#include <josa/visitor.hpp>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Double dispatch over a 120 x 90 matrix of message and state types, where the handler only
+//  overloads on 4 groups of messages and 3 groups of states. One handler dispatches through the
+//  full 10800-entry table; the other declares its overload_types, so that the dispatcher builds a
+//  table per pair of classes instead. Reports ns/visit over random pairs and the size of each
+//  handler's dispatch table. Compiling this file without COMPRESSED_ONLY defined also shows the
+//  cost of instantiating the full table.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t message_count = 120;
+    constexpr std::size_t state_count = 90;
+    constexpr std::size_t pair_count = 1 << 16;
+
+    struct message { virtual ~message() = default; };
+    template <std::size_t G> struct message_group : message {};
+    template <std::size_t I> struct message_leaf final : message_group<I % 4> {};
+
+    struct state { virtual ~state() = default; };
+    template <std::size_t G> struct state_group : state {};
+    template <std::size_t I> struct state_leaf final : state_group<I % 3> {};
+
+    template <typename Base, template <std::size_t> class Leaf, typename IS> struct hierarchy_of;
+
+    template <typename Base, template <std::size_t> class Leaf, std::size_t... I>
+    struct hierarchy_of<Base, Leaf, std::index_sequence<I...>>
+    {
+        using type = jv::hierarchy<jv::base_type<Base>, jv::concrete_types<Leaf<I>...>>;
+
+        static auto make(const std::size_t i) -> std::unique_ptr<Base>
+        {
+            using factory_t = std::unique_ptr<Base>(*)();
+            static constexpr factory_t factories[] = {+[]() -> std::unique_ptr<Base> { return std::make_unique<Leaf<I>>(); }...};
+            return factories[i]();
+        }
+    };
+
+    using messages_t = hierarchy_of<message, message_leaf, std::make_index_sequence<message_count>>;
+    using states_t = hierarchy_of<state, state_leaf, std::make_index_sequence<state_count>>;
+    using dispatcher_t = jv::dispatcher<messages_t::type, states_t::type>;
+
+    struct handler
+    {
+        auto operator()(const message&, const state&) const -> int { return 0; }
+        auto operator()(const message_group<0>&, const state&) const -> int { return 1; }
+        auto operator()(const message_group<1>&, const state_group<0>&) const -> int { return 2; }
+        auto operator()(const message_group<1>&, const state_group<1>&) const -> int { return 3; }
+        auto operator()(const message_group<2>&, const state_group<2>&) const -> int { return 4; }
+    };
+
+    struct compressed_handler : handler
+    {
+        using overload_types = jv::overload_types
+        <
+            jv::types<message_group<0>, message_group<1>, message_group<2>>,
+            jv::types<state_group<0>, state_group<1>, state_group<2>>
+        >;
+    };
+}
+
+int main()
+{
+    auto rng = std::mt19937{42};
+    auto messages = std::vector<std::unique_ptr<message>>{};
+    auto states = std::vector<std::unique_ptr<state>>{};
+
+    for (std::size_t i = 0; i < pair_count; ++i)
+    {
+        messages.push_back(messages_t::make(rng() % message_count));
+        states.push_back(states_t::make(rng() % state_count));
+    }
+
+    bench::print_header("double dispatch, 120 x 90 types, handler overloads on 4 x 3 groups");
+
+    auto sum = 0;
+
+#if !defined(COMPRESSED_ONLY)
+    const auto full = bench::ns_per_op([&] {
+        for (std::size_t i = 0; i < pair_count; ++i)
+            sum += dispatcher_t::visit(handler{}, *messages[i], *states[i]);
+        bench::do_not_optimize(sum);
+    }, pair_count);
+
+    bench::print_row("full table", message_count * state_count, full);
+#endif
+
+    const auto compressed = bench::ns_per_op([&] {
+        for (std::size_t i = 0; i < pair_count; ++i)
+            sum += dispatcher_t::visit(compressed_handler{}, *messages[i], *states[i]);
+        bench::do_not_optimize(sum);
+    }, pair_count);
+
+    bench::print_row("overload_types classes", message_count * state_count, compressed);
+
+    const auto stats = jv::table_usage<messages_t::type, states_t::type>();
+    std::printf("\n  %zu dispatch tables, %zu bytes in all\n", stats.dispatch_tables, stats.dispatch_table_bytes);
+}
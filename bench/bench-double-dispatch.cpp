@@ -0,0 +1,121 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <array>
+#include <typeindex>
+#include <unordered_map>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Double dispatch: ns/visit of josa::visitor::dispatcher<H1, H2> against the unordered_map keyed on
+//  a pair of std::type_index values that it previously used, over randomly ordered pairs.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    struct pair_hasher
+    {
+        auto operator () (const std::array<std::type_index, 2>& key) const -> std::size_t
+        {
+            constexpr auto h = std::hash<std::type_index>{};
+            return h(key[0]) ^ (h(key[1]) << 1);
+        }
+    };
+
+    //  The previous implementation: one unordered_map per (F, Args...) from a pair of type_index
+    //  values to thunk.
+    //
+    template <typename F, typename Base1, typename Base2, typename ConcreteTL1, typename ConcreteTL2>
+    struct legacy_map;
+
+    template <typename F, typename Base1, typename Base2, typename... Concretes1, typename... Concretes2>
+    struct legacy_map<F, Base1, Base2, josa::meta::list<Concretes1...>, josa::meta::list<Concretes2...>>
+    {
+        using fn_t = std::size_t(*)(const F&, const Base1&, const Base2&);
+        using key_t = std::array<std::type_index, 2>;
+        using map_t = std::unordered_map<key_t, fn_t, pair_hasher>;
+
+        template <typename Concrete1, typename Concrete2>
+        static auto thunk(const F& f, const Base1& obj1, const Base2& obj2) -> std::size_t
+        {
+            return f(static_cast<const Concrete1&>(obj1), static_cast<const Concrete2&>(obj2));
+        }
+
+        template <typename Concrete1>
+        static auto insert_row(map_t& map) -> void
+        {
+            (map.emplace(key_t{std::type_index(typeid(Concrete1)), std::type_index(typeid(Concretes2))},
+                &thunk<Concrete1, Concretes2>), ...);
+        }
+
+        static auto make() -> map_t
+        {
+            auto map = map_t{};
+            (insert_row<Concretes1>(map), ...);
+            return map;
+        }
+
+        static auto visit(const F& f, const Base1& obj1, const Base2& obj2) -> std::size_t
+        {
+            static const auto map = make();
+
+            if (const auto it = map.find({std::type_index(typeid(obj1)), std::type_index(typeid(obj2))}); it != map.end())
+                return it->second(f, obj1, obj2);
+
+            throw jv::unhandled_type{typeid(obj1).name(), typeid(obj2).name()};
+        }
+    };
+
+    struct leaf_pair_index
+    {
+        template <std::size_t N1, std::size_t I1, std::size_t N2, std::size_t I2>
+        auto operator () (const bench::leaf<N1, I1>& a, const bench::leaf<N2, I2>& b) const -> std::size_t
+        {
+            return I1 * N2 + I2 + a.payload + b.payload;
+        }
+    };
+
+    constexpr std::size_t object_count = 1 << 14;
+
+    template <std::size_t N>
+    auto run() -> void
+    {
+        using synthetic_t = bench::synthetic<N>;
+        using base_t = typename synthetic_t::base_t;
+        using hierarchy_t = typename synthetic_t::hierarchy_t;
+        using concretes_t = typename jv::detail::hierarchy_traits<hierarchy_t>::concrete_types_t;
+
+        const auto objs1 = synthetic_t::make_random(object_count, 1);
+        const auto objs2 = synthetic_t::make_random(object_count, 2);
+        const auto f = leaf_pair_index{};
+
+        const auto legacy = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (std::size_t i = 0; i < object_count; ++i)
+                sum += legacy_map<leaf_pair_index, base_t, base_t, concretes_t, concretes_t>::visit(f, *objs1[i], *objs2[i]);
+            bench::do_not_optimize(sum);
+        }, object_count);
+
+        const auto josa = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (std::size_t i = 0; i < object_count; ++i)
+                sum += jv::dispatcher<hierarchy_t, hierarchy_t>::visit(f, *objs1[i], *objs2[i]);
+            bench::do_not_optimize(sum);
+        }, object_count);
+
+        bench::print_row("unordered_map<type_index[2]>", N * N, legacy);
+        bench::print_row("dispatcher<H, H>::visit", N * N, josa);
+    }
+}
+
+int main()
+{
+    bench::print_header("double dispatch, random type order (N = N1 x N2)");
+
+    run<2>();
+    run<8>();
+    run<32>();
+}
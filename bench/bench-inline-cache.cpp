@@ -0,0 +1,75 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <cstdio>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Inline caches: ns/visit with and without a per-call-site cache, for object sequences in which
+//  the concrete type changes every `run_length` objects.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t object_count = 1 << 14;
+
+    template <std::size_t N>
+    auto make_runs(const std::size_t run_length) -> std::vector<std::unique_ptr<bench::node<N>>>
+    {
+        auto objs = bench::synthetic<N>::make_random(object_count / run_length);
+        auto runs = std::vector<std::unique_ptr<bench::node<N>>>{};
+
+        for (const auto& p : objs)
+        {
+            for (std::size_t i = 0; i < run_length; ++i)
+                runs.push_back(bench::synthetic<N>::make(p->payload));
+        }
+
+        return runs;
+    }
+
+    template <std::size_t N, typename Cache>
+    auto run(const char* name, const std::size_t run_length) -> void
+    {
+        using hierarchy_t = typename bench::synthetic<N>::hierarchy_t;
+        using dispatcher_t = jv::dispatcher<hierarchy_t>;
+
+        const auto objs = make_runs<N>(run_length);
+        const auto f = bench::leaf_index{};
+
+        const auto plain = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (const auto& p : objs)
+                sum += dispatcher_t::visit(f, *p);
+            bench::do_not_optimize(sum);
+        }, objs.size());
+
+        auto cache = Cache{};
+
+        const auto cached = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (const auto& p : objs)
+                sum += dispatcher_t::visit(cache, f, *p);
+            bench::do_not_optimize(sum);
+        }, objs.size());
+
+        std::printf("  N=%-4zu run=%-4zu %-20s uncached %7.2f ns/op   cached %7.2f ns/op   hit rate %5.1f%%\n",
+            N, run_length, name, plain, cached, 100.0 * cache.hit_rate());
+    }
+}
+
+int main()
+{
+    bench::print_header("single dispatch with inline caches");
+
+    for (const auto run_length : {1, 4, 64})
+    {
+        run<8, jv::monomorphic_cache<bench::synthetic<8>::hierarchy_t>>("monomorphic_cache", run_length);
+        run<8, jv::inline_cache<bench::synthetic<8>::hierarchy_t>>("inline_cache", run_length);
+        run<32, jv::monomorphic_cache<bench::synthetic<32>::hierarchy_t>>("monomorphic_cache", run_length);
+        run<32, jv::inline_cache<bench::synthetic<32>::hierarchy_t>>("inline_cache", run_length);
+    }
+}
@@ -0,0 +1,73 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <algorithm>
+#include <string>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Switch against table dispatch: ns/visit of a handler small enough to inline, over objects in
+//  random order and over the same objects sorted by type, where branches are predictable. The visit_* functions are kept out of line so that their code can be inspected
+//  with a disassembler; with switch_dispatch the handler bodies appear inside them.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    template <std::size_t N, typename Option>
+    [[gnu::noinline]] auto visit_with(const typename bench::synthetic<N>::base_t& obj) -> std::size_t
+    {
+        using hierarchy_t = typename bench::synthetic<N>::template hierarchy_with<Option>;
+        return jv::dispatcher<hierarchy_t>::visit(bench::leaf_index{}, obj);
+    }
+
+    constexpr std::size_t object_count = 1 << 14;
+
+    template <std::size_t N, typename Objs>
+    auto run(const char* order, const Objs& objs) -> void
+    {
+        const auto table = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (const auto& p : objs)
+                sum += visit_with<N, jv::table_dispatch>(*p);
+            bench::do_not_optimize(sum);
+        }, objs.size());
+
+        const auto switched = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (const auto& p : objs)
+                sum += visit_with<N, jv::switch_dispatch>(*p);
+            bench::do_not_optimize(sum);
+        }, objs.size());
+
+        bench::print_row((std::string("table_dispatch, ") + order).c_str(), N, table);
+        bench::print_row((std::string("switch_dispatch, ") + order).c_str(), N, switched);
+    }
+
+    template <std::size_t N>
+    auto run() -> void
+    {
+        auto objs = bench::synthetic<N>::make_random(object_count);
+        run<N>("random", objs);
+
+        std::stable_sort(objs.begin(), objs.end(), [](const auto& a, const auto& b) {
+            return jv::detail::type_ordinal<typename bench::synthetic<N>::hierarchy_t>::of(*a)
+                 < jv::detail::type_ordinal<typename bench::synthetic<N>::hierarchy_t>::of(*b);
+        });
+
+        run<N>("sorted", objs);
+    }
+}
+
+int main()
+{
+    bench::print_header("single dispatch, table vs switch");
+
+    run<2>();
+    run<8>();
+    run<32>();
+    run<64>();
+    run<128>();
+}
@@ -0,0 +1,71 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Triple dispatch: ns/visit of josa::visitor::dispatcher<H, H, H> against three nested single
+//  dispatches, each capturing the objects resolved so far, over randomly ordered triples.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    struct leaf_triple_index
+    {
+        template <std::size_t N, std::size_t I1, std::size_t I2, std::size_t I3>
+        auto operator () (const bench::leaf<N, I1>& a, const bench::leaf<N, I2>& b, const bench::leaf<N, I3>& c) const -> std::size_t
+        {
+            return (I1 * N + I2) * N + I3 + a.payload + b.payload + c.payload;
+        }
+    };
+
+    constexpr std::size_t object_count = 1 << 14;
+
+    template <std::size_t N>
+    auto run() -> void
+    {
+        using synthetic_t = bench::synthetic<N>;
+        using hierarchy_t = typename synthetic_t::hierarchy_t;
+        using single_t = jv::dispatcher<hierarchy_t>;
+
+        const auto objs1 = synthetic_t::make_random(object_count, 1);
+        const auto objs2 = synthetic_t::make_random(object_count, 2);
+        const auto objs3 = synthetic_t::make_random(object_count, 3);
+        const auto f = leaf_triple_index{};
+
+        const auto nested = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (std::size_t i = 0; i < object_count; ++i)
+            {
+                sum += single_t::visit([&](const auto& a) {
+                    return single_t::visit([&](const auto& b) {
+                        return single_t::visit([&](const auto& c) { return f(a, b, c); }, *objs3[i]);
+                    }, *objs2[i]);
+                }, *objs1[i]);
+            }
+            bench::do_not_optimize(sum);
+        }, object_count);
+
+        const auto josa = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (std::size_t i = 0; i < object_count; ++i)
+                sum += jv::dispatcher<hierarchy_t, hierarchy_t, hierarchy_t>::visit(f, *objs1[i], *objs2[i], *objs3[i]);
+            bench::do_not_optimize(sum);
+        }, object_count);
+
+        bench::print_row("nested single dispatch", N * N * N, nested);
+        bench::print_row("dispatcher<H, H, H>::visit", N * N * N, josa);
+    }
+}
+
+int main()
+{
+    bench::print_header("triple dispatch, random type order (N = N1 x N2 x N3)");
+
+    run<2>();
+    run<4>();
+    run<8>();
+}
@@ -0,0 +1,74 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Parallel batch visits: ns/object of dispatcher::parallel_visit_all with 1 to 64 threads, over a
+//  large vector of unique_ptrs to objects of random concrete types, shuffled in memory. Each
+//  thread accumulates into its own copy of a stateful handler, and the copies are summed at the
+//  end. The speed-up is against the serial visit_all.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t object_count = 1 << 22;
+
+    struct leaf_sum
+    {
+        std::size_t sum = 0;
+
+        template <std::size_t N, std::size_t I>
+        auto operator () (const bench::leaf<N, I>& obj) -> void { sum += I + obj.payload; }
+    };
+
+    template <std::size_t N>
+    auto run() -> void
+    {
+        using synthetic_t = bench::synthetic<N>;
+        using dispatcher_t = jv::dispatcher<typename synthetic_t::hierarchy_t>;
+
+        auto objs = synthetic_t::make_random(object_count);
+        std::shuffle(objs.begin(), objs.end(), std::mt19937{7});
+
+        const auto add = [](leaf_sum a, const leaf_sum& b) { a.sum += b.sum; return a; };
+
+        const auto serial = bench::ns_per_op([&] {
+            auto f = leaf_sum{};
+            dispatcher_t::visit_all(f, objs.begin(), objs.end());
+            bench::do_not_optimize(f.sum);
+        }, objs.size());
+
+        bench::print_row("visit_all", N, serial);
+
+        for (std::size_t threads = 1; threads <= 64; threads *= 2)
+        {
+            const auto parallel = bench::ns_per_op([&] {
+                const auto f = dispatcher_t::parallel_visit_all(leaf_sum{}, objs.begin(), objs.end(), add, threads);
+                bench::do_not_optimize(f.sum);
+            }, objs.size());
+
+            const auto name = "parallel_visit_all, " + std::to_string(threads) + " threads";
+            bench::print_row(name.c_str(), N, parallel);
+            std::printf("  %-32s %15.2fx\n", "  speed-up", serial / parallel);
+        }
+    }
+}
+
+int main()
+{
+    std::printf("\nhardware threads: %u\n", std::thread::hardware_concurrency());
+    bench::print_header("parallel batch visits, random type order, shuffled, 2^22 objects");
+
+    run<8>();
+    run<128>();
+}
@@ -0,0 +1,143 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Runtime registry contention: 32 threads visit a shared vector of objects of 64 types, 8 of
+//  them listed in the hierarchy and 56 handled through a dispatch_registry, first undisturbed and
+//  then while another thread keeps re-registering the 56 types, one every 50 us. Each result is
+//  wall-clock time divided by the total number of visits made by all threads.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t type_count = 64;
+    constexpr std::size_t listed_count = 8;
+    constexpr std::size_t object_count = 1 << 16;
+    constexpr std::size_t thread_count = 32;
+    constexpr auto run_time = std::chrono::milliseconds{300};
+
+    using synthetic_t = bench::synthetic<type_count>;
+    using node_t = bench::node<type_count>;
+
+    template <typename IS = std::make_index_sequence<listed_count>> struct listed;
+
+    template <std::size_t... I>
+    struct listed<std::index_sequence<I...>>
+    {
+        using hierarchy_t = jv::hierarchy<jv::base_type<node_t>, jv::concrete_types<bench::leaf<type_count, I>...>>;
+    };
+
+    using hierarchy_t = listed<>::hierarchy_t;
+    using registry_t = jv::dispatch_registry<hierarchy_t, std::size_t(const node_t&)>;
+
+    template <std::size_t... I>
+    auto register_all(registry_t& registry, std::index_sequence<I...>) -> void
+    {
+        (registry.add<bench::leaf<type_count, listed_count + I>>(bench::leaf_index{}), ...);
+    }
+
+    template <std::size_t I>
+    auto register_one(registry_t& registry) -> void
+    {
+        registry.add<bench::leaf<type_count, I>>(bench::leaf_index{});
+    }
+
+    template <std::size_t... I>
+    auto register_nth(registry_t& registry, const std::size_t n, std::index_sequence<I...>) -> void
+    {
+        ((n == I ? register_one<listed_count + I>(registry) : void()), ...);
+    }
+
+    auto ns_per_visit(registry_t& registry, const std::vector<std::unique_ptr<node_t>>& objs, const bool registering) -> double
+    {
+        auto start = std::atomic<bool>{false};
+        auto stop = std::atomic<bool>{false};
+        auto visits = std::atomic<std::size_t>{0};
+        auto threads = std::vector<std::thread>{};
+
+        for (std::size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t] {
+                while (!start)
+                    std::this_thread::yield();
+
+                auto n = std::size_t{0};
+                auto sum = std::size_t{0};
+
+                for (auto i = t * 997; !stop; ++i, ++n)
+                    sum += registry.visit(bench::leaf_index{}, *objs[i % objs.size()]);
+
+                bench::do_not_optimize(sum);
+                visits += n;
+            });
+        }
+
+        auto registrations = std::size_t{0};
+        const auto begin = std::chrono::steady_clock::now();
+        start = true;
+
+        while (std::chrono::steady_clock::now() - begin < run_time)
+        {
+            if (registering)
+            {
+                register_nth(registry, registrations++ % (type_count - listed_count), std::make_index_sequence<type_count - listed_count>{});
+                std::this_thread::sleep_for(std::chrono::microseconds{50});
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        }
+
+        stop = true;
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+        for (auto& t : threads)
+            t.join();
+
+        if (registering)
+            std::printf("  %zu registrations during the run\n", registrations);
+
+        return elapsed / static_cast<double>(visits);
+    }
+}
+
+int main()
+{
+    auto registry = registry_t{};
+    register_all(registry, std::make_index_sequence<type_count - listed_count>{});
+
+    const auto objs = synthetic_t::make_random(object_count);
+
+    bench::print_header("dispatch_registry, 8 listed + 56 registered types, single thread");
+
+    auto sum = std::size_t{0};
+
+    const auto mixed = bench::ns_per_op([&] {
+        for (const auto& p : objs)
+            sum += registry.visit(bench::leaf_index{}, *p);
+        bench::do_not_optimize(sum);
+    }, objs.size());
+
+    bench::print_row("registry visit, mixed types", type_count, mixed);
+
+    std::printf("\nhardware threads: %u\n", std::thread::hardware_concurrency());
+    bench::print_header("dispatch_registry, 32 visiting threads");
+
+    const auto quiet = ns_per_visit(registry, objs, false);
+    bench::print_row("visit, no registrations", type_count, quiet);
+
+    const auto busy = ns_per_visit(registry, objs, true);
+    bench::print_row("visit, while registering", type_count, busy);
+}
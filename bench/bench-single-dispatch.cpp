@@ -0,0 +1,94 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <typeindex>
+#include <unordered_map>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Single dispatch: ns/visit of josa::visitor::dispatcher against the std::unordered_map keyed on
+//  std::type_index that it previously used, over randomly ordered objects.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    //  The previous implementation: one unordered_map per (F, Args...) from type_index to thunk.
+    //
+    template <typename F, typename Base, typename ConcreteTL> struct legacy_map;
+
+    template <typename F, typename Base, typename... Concretes>
+    struct legacy_map<F, Base, josa::meta::list<Concretes...>>
+    {
+        using fn_t = std::size_t(*)(const F&, const Base&);
+
+        template <typename Concrete>
+        static auto thunk(const F& f, const Base& obj) -> std::size_t
+        {
+            return f(static_cast<const Concrete&>(obj));
+        }
+
+        static auto visit(const F& f, const Base& obj) -> std::size_t
+        {
+            static const auto map = std::unordered_map<std::type_index, fn_t>
+                {{std::type_index(typeid(Concretes)), &thunk<Concretes>}...};
+
+            if (const auto it = map.find(std::type_index(typeid(obj))); it != map.end())
+                return it->second(f, obj);
+
+            throw jv::unhandled_type{typeid(obj).name()};
+        }
+    };
+
+    constexpr std::size_t object_count = 1 << 14;
+
+    template <std::size_t N>
+    auto run() -> void
+    {
+        using synthetic_t = bench::synthetic<N>;
+        using base_t = typename synthetic_t::base_t;
+        using concretes_t = typename jv::detail::hierarchy_traits<typename synthetic_t::hierarchy_t>::concrete_types_t;
+
+        const auto objs = synthetic_t::make_random(object_count);
+        const auto f = bench::leaf_index{};
+
+        const auto legacy = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (const auto& p : objs)
+                sum += legacy_map<bench::leaf_index, base_t, concretes_t>::visit(f, *p);
+            bench::do_not_optimize(sum);
+        }, objs.size());
+
+        const auto josa = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (const auto& p : objs)
+                sum += jv::dispatcher<typename synthetic_t::hierarchy_t>::visit(f, *p);
+            bench::do_not_optimize(sum);
+        }, objs.size());
+
+        using vtable_hierarchy_t = typename synthetic_t::template hierarchy_with<jv::vtable_key>;
+
+        const auto vtable = bench::ns_per_op([&] {
+            auto sum = std::size_t{0};
+            for (const auto& p : objs)
+                sum += jv::dispatcher<vtable_hierarchy_t>::visit(f, *p);
+            bench::do_not_optimize(sum);
+        }, objs.size());
+
+        bench::print_row("unordered_map<type_index>", N, legacy);
+        bench::print_row("dispatcher::visit", N, josa);
+        bench::print_row("dispatcher::visit (vtable_key)", N, vtable);
+    }
+}
+
+int main()
+{
+    bench::print_header("single dispatch, random type order");
+
+    run<2>();
+    run<8>();
+    run<32>();
+    run<128>();
+}
@@ -0,0 +1,86 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <cstdio>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Double dispatch over 120 x 90 types with a handler for 12 pairs and a default for the rest. One
+//  handler is dispatched through the full 10800-entry table, whose entries all instantiate a call
+//  to the handler; the other declares its handled_pairs, so that only 13 calls are instantiated.
+//  Reports ns/visit over random pairs and the size of each handler's tables. Compiling this file
+//  with and without SPARSE_ONLY defined shows the cost of instantiating the full table.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t pair_count = 1 << 16;
+
+    using first_t = bench::synthetic<120>;
+    using second_t = bench::synthetic<90>;
+    using dispatcher_t = jv::dispatcher<first_t::hierarchy_t, second_t::hierarchy_t>;
+
+    template <std::size_t I> using a = bench::leaf<120, I>;
+    template <std::size_t J> using b = bench::leaf<90, J>;
+
+    struct handler
+    {
+        auto operator()(const a<0>&, const b<0>&) const -> std::size_t { return 1; }
+        auto operator()(const a<1>&, const b<7>&) const -> std::size_t { return 2; }
+        auto operator()(const a<9>&, const b<3>&) const -> std::size_t { return 3; }
+        auto operator()(const a<17>&, const b<89>&) const -> std::size_t { return 4; }
+        auto operator()(const a<30>&, const b<30>&) const -> std::size_t { return 5; }
+        auto operator()(const a<44>&, const b<12>&) const -> std::size_t { return 6; }
+        auto operator()(const a<58>&, const b<60>&) const -> std::size_t { return 7; }
+        auto operator()(const a<71>&, const b<1>&) const -> std::size_t { return 8; }
+        auto operator()(const a<85>&, const b<45>&) const -> std::size_t { return 9; }
+        auto operator()(const a<99>&, const b<70>&) const -> std::size_t { return 10; }
+        auto operator()(const a<110>&, const b<88>&) const -> std::size_t { return 11; }
+        auto operator()(const a<119>&, const b<5>&) const -> std::size_t { return 12; }
+        auto operator()(const bench::node<120>&, const bench::node<90>&) const -> std::size_t { return 0; }
+    };
+
+    struct sparse : handler
+    {
+        using handled_pairs = jv::handled_pairs
+        <
+            jv::types<a<0>, b<0>>, jv::types<a<1>, b<7>>, jv::types<a<9>, b<3>>, jv::types<a<17>, b<89>>,
+            jv::types<a<30>, b<30>>, jv::types<a<44>, b<12>>, jv::types<a<58>, b<60>>, jv::types<a<71>, b<1>>,
+            jv::types<a<85>, b<45>>, jv::types<a<99>, b<70>>, jv::types<a<110>, b<88>>, jv::types<a<119>, b<5>>
+        >;
+    };
+}
+
+int main()
+{
+    const auto firsts = first_t::make_random(pair_count, 1);
+    const auto seconds = second_t::make_random(pair_count, 2);
+
+    bench::print_header("double dispatch, 120 x 90 types, 12 handled pairs and a default");
+
+    auto sum = std::size_t{0};
+
+#if !defined(SPARSE_ONLY)
+    const auto full = bench::ns_per_op([&] {
+        for (std::size_t i = 0; i < pair_count; ++i)
+            sum += dispatcher_t::visit(handler{}, *firsts[i], *seconds[i]);
+        bench::do_not_optimize(sum);
+    }, pair_count);
+
+    bench::print_row("full table", 120 * 90, full);
+#endif
+
+    const auto handled = bench::ns_per_op([&] {
+        for (std::size_t i = 0; i < pair_count; ++i)
+            sum += dispatcher_t::visit(sparse{}, *firsts[i], *seconds[i]);
+        bench::do_not_optimize(sum);
+    }, pair_count);
+
+    bench::print_row("handled_pairs", 120 * 90, handled);
+
+    const auto stats = jv::table_usage<first_t::hierarchy_t, second_t::hierarchy_t>();
+    std::printf("\n  %zu dispatch tables, %zu bytes in all\n", stats.dispatch_tables, stats.dispatch_table_bytes);
+}
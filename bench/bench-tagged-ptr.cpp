@@ -0,0 +1,110 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Tagged pointers: ns/object of visiting a large vector of pointers to objects shuffled in memory,
+//  against the same objects held by tagged_unique_ptrs, one at a time and with visit_all. One
+//  handler counts objects by type without reading them, so a tagged visit reads only the vector,
+//  while an untagged one reads each object's vtable pointer to find its type; the other reads each
+//  object's payload.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t object_count = 1 << 22;
+
+    struct type_count
+    {
+        std::size_t sum = 0;
+
+        template <std::size_t N, std::size_t I>
+        auto operator () (const bench::leaf<N, I>&) -> void { sum += I; }
+    };
+
+    struct payload_sum
+    {
+        std::size_t sum = 0;
+
+        template <std::size_t N, std::size_t I>
+        auto operator () (const bench::leaf<N, I>& obj) -> void { sum += I + obj.payload; }
+    };
+
+    template <typename Handler, std::size_t N, typename Objs, typename Tagged>
+    auto run_with(const char* name, const Objs& untagged, const Tagged& tagged) -> void
+    {
+        using dispatcher_t = jv::dispatcher<typename bench::synthetic<N>::hierarchy_t>;
+
+        const auto plain_visit = bench::ns_per_op([&] {
+            auto f = Handler{};
+            for (const auto p : untagged)
+                dispatcher_t::visit(f, *p);
+            bench::do_not_optimize(f.sum);
+        }, object_count, 3);
+
+        const auto tagged_visit = bench::ns_per_op([&] {
+            auto f = Handler{};
+            for (const auto& p : tagged)
+                dispatcher_t::visit(f, p);
+            bench::do_not_optimize(f.sum);
+        }, object_count, 3);
+
+        const auto plain_all = bench::ns_per_op([&] {
+            auto f = Handler{};
+            dispatcher_t::visit_all(f, untagged.begin(), untagged.end());
+            bench::do_not_optimize(f.sum);
+        }, object_count, 3);
+
+        const auto tagged_all = bench::ns_per_op([&] {
+            auto f = Handler{};
+            dispatcher_t::visit_all(f, tagged.begin(), tagged.end());
+            bench::do_not_optimize(f.sum);
+        }, object_count, 3);
+
+        std::printf("  %s\n", name);
+        bench::print_row("visit, pointers", N, plain_visit);
+        bench::print_row("visit, tagged pointers", N, tagged_visit);
+        bench::print_row("visit_all, pointers", N, plain_all);
+        bench::print_row("visit_all, tagged pointers", N, tagged_all);
+    }
+
+    template <std::size_t N>
+    auto run() -> void
+    {
+        using synthetic_t = bench::synthetic<N>;
+        using hierarchy_t = typename synthetic_t::hierarchy_t;
+
+        auto objs = synthetic_t::make_random(object_count);
+        std::shuffle(objs.begin(), objs.end(), std::mt19937{7});
+
+        auto tagged = std::vector<jv::tagged_unique_ptr<hierarchy_t>>{};
+        tagged.reserve(objs.size());
+
+        for (auto& obj : objs)
+            tagged.push_back(jv::tagged_unique_ptr<hierarchy_t>::of(std::move(obj)));
+
+        auto untagged = std::vector<const typename synthetic_t::base_t*>{};
+
+        for (const auto& t : tagged)
+            untagged.push_back(t.get());
+
+        run_with<type_count, N>("type_count, which does not read the objects", untagged, tagged);
+        run_with<payload_sum, N>("payload_sum, which does", untagged, tagged);
+    }
+}
+
+int main()
+{
+    bench::print_header("tagged pointers, random type order, shuffled, 2^22 objects");
+
+    run<8>();
+    run<128>();
+}
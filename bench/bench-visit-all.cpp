@@ -0,0 +1,96 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Batch visits: ns/object of dispatcher::visit in a loop against dispatcher::visit_all, over a
+//  large vector of unique_ptrs to objects of random concrete types. The objects are laid out in
+//  memory either in the order of the vector or shuffled, as in a long-lived heap.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t object_count = 1 << 20;
+
+    struct leaf_sum
+    {
+        std::size_t sum = 0;
+
+        template <std::size_t N, std::size_t I>
+        auto operator () (const bench::leaf<N, I>& obj) -> void { sum += I + obj.payload; }
+    };
+
+    template <std::size_t N>
+    auto run(const bool shuffled) -> void
+    {
+        using synthetic_t = bench::synthetic<N>;
+        using dispatcher_t = jv::dispatcher<typename synthetic_t::hierarchy_t>;
+
+        auto objs = synthetic_t::make_random(object_count);
+
+        if (shuffled)
+            std::shuffle(objs.begin(), objs.end(), std::mt19937{7});
+        auto results = std::vector<std::size_t>{};
+        results.reserve(object_count);
+
+        const auto loop = bench::ns_per_op([&] {
+            auto f = leaf_sum{};
+            for (const auto& p : objs)
+                dispatcher_t::visit(f, *p);
+            bench::do_not_optimize(f.sum);
+        }, objs.size());
+
+        const auto batch = bench::ns_per_op([&] {
+            auto f = leaf_sum{};
+            dispatcher_t::visit_all(f, objs.begin(), objs.end());
+            bench::do_not_optimize(f.sum);
+        }, objs.size());
+
+        const auto batch_no_prefetch = bench::ns_per_op([&] {
+            auto f = leaf_sum{};
+            dispatcher_t::template visit_all<0>(f, objs.begin(), objs.end());
+            bench::do_not_optimize(f.sum);
+        }, objs.size());
+
+        const auto loop_out = bench::ns_per_op([&] {
+            results.clear();
+            for (const auto& p : objs)
+                results.push_back(dispatcher_t::visit(bench::leaf_index{}, *p));
+            bench::do_not_optimize(results.data());
+        }, objs.size());
+
+        const auto batch_out = bench::ns_per_op([&] {
+            results.clear();
+            dispatcher_t::visit_all(bench::leaf_index{}, objs.begin(), objs.end(), std::back_inserter(results));
+            bench::do_not_optimize(results.data());
+        }, objs.size());
+
+        std::printf(" %s:\n", shuffled ? "shuffled in memory" : "in memory order");
+        bench::print_row("visit in a loop", N, loop);
+        bench::print_row("visit_all", N, batch);
+        bench::print_row("visit_all<0> (no prefetch)", N, batch_no_prefetch);
+        bench::print_row("visit in a loop, with results", N, loop_out);
+        bench::print_row("visit_all, with results", N, batch_out);
+    }
+}
+
+int main()
+{
+    bench::print_header("batch visits, random type order, 2^20 objects");
+
+    for (const auto shuffled : {false, true})
+    {
+        run<8>(shuffled);
+        run<32>(shuffled);
+        run<128>(shuffled);
+    }
+}
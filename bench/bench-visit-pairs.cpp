@@ -0,0 +1,113 @@
+#include "harness.hpp"
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Pairwise double dispatch: ns/pair over the cross product of two ranges of 2048 objects of
+//  random concrete types, visited with dispatcher<H, H>::visit in a nested loop, with visit_pairs,
+//  and with parallel_visit_pairs; then over a list of random pairs, visited one at a time and with
+//  visit_pairs. The direct call is the handler called in the same nested loop on objects whose
+//  concrete type is known statically, i.e. the cost of the work alone.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    constexpr std::size_t object_count = 2048;
+
+    struct pair_sum
+    {
+        std::size_t sum = 0;
+
+        template <std::size_t N1, std::size_t I1, std::size_t N2, std::size_t I2>
+        auto operator () (const bench::leaf<N1, I1>& a, const bench::leaf<N2, I2>& b) -> void
+        {
+            sum += (I1 * N2 + I2) ^ (a.payload + b.payload);
+        }
+    };
+
+    template <std::size_t N>
+    auto run() -> void
+    {
+        using synthetic_t = bench::synthetic<N>;
+        using dispatcher_t = jv::dispatcher<typename synthetic_t::hierarchy_t, typename synthetic_t::hierarchy_t>;
+
+        const auto objs1 = synthetic_t::make_random(object_count, 1);
+        const auto objs2 = synthetic_t::make_random(object_count, 2);
+        constexpr auto pairs = object_count * object_count;
+
+        auto leaves1 = std::vector<bench::leaf<N, 0>>(object_count);
+        auto leaves2 = std::vector<bench::leaf<N, 0>>(object_count);
+
+        const auto direct = bench::ns_per_op([&] {
+            auto f = pair_sum{};
+            for (const auto& a : leaves1)
+                for (const auto& b : leaves2)
+                    f(a, b);
+            bench::do_not_optimize(f.sum);
+        }, pairs, 3);
+
+        const auto nested = bench::ns_per_op([&] {
+            auto f = pair_sum{};
+            for (const auto& a : objs1)
+                for (const auto& b : objs2)
+                    dispatcher_t::visit(f, *a, *b);
+            bench::do_not_optimize(f.sum);
+        }, pairs, 3);
+
+        const auto batched = bench::ns_per_op([&] {
+            auto f = pair_sum{};
+            dispatcher_t::visit_pairs(f, objs1.begin(), objs1.end(), objs2.begin(), objs2.end());
+            bench::do_not_optimize(f.sum);
+        }, pairs, 3);
+
+        const auto threads = std::max(1u, std::thread::hardware_concurrency());
+        const auto parallel = bench::ns_per_op([&] {
+            const auto f = dispatcher_t::parallel_visit_pairs(pair_sum{}, objs1.begin(), objs1.end(), objs2.begin(), objs2.end(),
+                [](pair_sum a, const pair_sum& b) { a.sum += b.sum; return a; }, threads);
+            bench::do_not_optimize(f.sum);
+        }, pairs, 3);
+
+        bench::print_row("direct call", N * N, direct);
+        bench::print_row("visit, nested loop", N * N, nested);
+        bench::print_row("visit_pairs", N * N, batched);
+        bench::print_row("parallel_visit_pairs", N * N, parallel);
+
+        auto list = std::vector<std::pair<const bench::node<N>*, const bench::node<N>*>>{};
+
+        for (std::size_t i = 0; i < object_count * 64; ++i)
+            list.emplace_back(objs1[i % object_count].get(), objs2[(i * 7919) % object_count].get());
+
+        const auto one_by_one = bench::ns_per_op([&] {
+            auto f = pair_sum{};
+            for (const auto& [a, b] : list)
+                dispatcher_t::visit(f, *a, *b);
+            bench::do_not_optimize(f.sum);
+        }, list.size());
+
+        const auto listed = bench::ns_per_op([&] {
+            auto f = pair_sum{};
+            dispatcher_t::visit_pairs(f, list.begin(), list.end());
+            bench::do_not_optimize(f.sum);
+        }, list.size());
+
+        bench::print_row("pair list, visit", N * N, one_by_one);
+        bench::print_row("pair list, visit_pairs", N * N, listed);
+    }
+}
+
+int main()
+{
+    std::printf("\nhardware threads: %u\n", std::thread::hardware_concurrency());
+    bench::print_header("pairwise double dispatch, random type order, 2048 x 2048 objects");
+
+    run<4>();
+    run<16>();
+}
@@ -0,0 +1,112 @@
+#include "synthetic.hpp"
+#include <josa/visitor.hpp>
+#include <cstddef>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  The translation unit that bench-compile-time compiles, once per configuration. It visits
+//  synthetic hierarchies of PROBE_TYPES (and PROBE_TYPES2) concrete types in the way selected by
+//  one of:
+//
+//      PROBE_DISPATCHER        dispatcher<H>::visit with an overload per concrete type
+//      PROBE_ENABLE_DISPATCH   a visitor class deriving from enable_dispatch<Visitor, H>
+//      PROBE_EXTERN            the same visitor declared with JOSA_VISITOR_EXTERN, as seen by
+//                              every translation unit but the one that instantiates it
+//      PROBE_DOUBLE            dispatcher<H1, H2>::visit with an overload per pair of types
+//      PROBE_ALL_PAIRS         meta::all_pairs_t of the two lists of concrete types alone
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace
+{
+    namespace jv = josa::visitor;
+
+    using first_t = bench::synthetic<PROBE_TYPES>;
+
+#if defined(PROBE_TYPES2)
+    using second_t = bench::synthetic<PROBE_TYPES2>;
+#endif
+}
+
+#if defined(PROBE_DISPATCHER)
+
+auto probe(const first_t::base_t& obj) -> std::size_t
+{
+    return jv::dispatcher<first_t::hierarchy_t>::visit(bench::leaf_index{}, obj);
+}
+
+#elif defined(PROBE_ENABLE_DISPATCH)
+
+namespace
+{
+    struct leaf_visitor : jv::enable_dispatch<leaf_visitor, first_t::hierarchy_t>
+    {
+        template <std::size_t N, std::size_t I>
+        auto operator () (const bench::leaf<N, I>& obj) const -> std::size_t { return I + obj.payload; }
+    };
+}
+
+auto probe(const first_t::base_t& obj) -> std::size_t
+{
+    return leaf_visitor{}.visit(obj);
+}
+
+#elif defined(PROBE_EXTERN)
+
+struct extern_leaf_visitor : jv::enable_dispatch<extern_leaf_visitor, first_t::hierarchy_t>
+{
+    template <std::size_t N, std::size_t I>
+    auto operator () (const bench::leaf<N, I>& obj) const -> std::size_t { return I + obj.payload; }
+};
+
+JOSA_VISITOR_EXTERN(extern_leaf_visitor, first_t::hierarchy_t);
+
+auto probe(const first_t::base_t& obj) -> std::size_t
+{
+    return extern_leaf_visitor{}.visit(obj);
+}
+
+#elif defined(PROBE_DOUBLE)
+
+namespace
+{
+    struct leaf_pair
+    {
+        template <std::size_t N1, std::size_t I, std::size_t N2, std::size_t J>
+        auto operator () (const bench::leaf<N1, I>& a, const bench::leaf<N2, J>& b) const -> std::size_t
+        {
+            return I * N2 + J + a.payload + b.payload;
+        }
+    };
+}
+
+auto probe(const first_t::base_t& a, const second_t::base_t& b) -> std::size_t
+{
+    return jv::dispatcher<first_t::hierarchy_t, second_t::hierarchy_t>::visit(leaf_pair{}, a, b);
+}
+
+#elif defined(PROBE_ALL_PAIRS)
+
+namespace
+{
+    template <typename Pairs> struct pair_sizes;
+
+    template <typename... Pairs>
+    struct pair_sizes<josa::meta::list<Pairs...>>
+    {
+        static constexpr std::size_t sizes[] = {josa::meta::size<Pairs>::value...};
+    };
+
+    using concretes1_t = jv::detail::hierarchy_traits<first_t::hierarchy_t>::concrete_types_t;
+    using concretes2_t = jv::detail::hierarchy_traits<second_t::hierarchy_t>::concrete_types_t;
+}
+
+auto probe() -> std::size_t
+{
+    using sizes_t = pair_sizes<josa::meta::all_pairs_t<concretes1_t, concretes2_t>>;
+    return sizeof(sizes_t::sizes);
+}
+
+#else
+#   error "define one of PROBE_DISPATCHER, PROBE_ENABLE_DISPATCH, PROBE_EXTERN, PROBE_DOUBLE or PROBE_ALL_PAIRS"
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  A minimal, dependency-free timing harness for the Josa.Visitor benchmarks.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace bench
+{
+    //  Prevents the compiler from optimizing away a computed value.
+    //
+    template <typename T>
+    inline auto do_not_optimize(const T& value) -> void
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    //  Runs f(), which is expected to perform `ops` operations, repeatedly and returns the best
+    //  observed time per operation in nanoseconds.
+    //
+    template <typename F>
+    auto ns_per_op(F&& f, const std::size_t ops, const int repetitions = 7) -> double
+    {
+        using clock = std::chrono::steady_clock;
+
+        f();    // warm-up
+
+        auto best = std::chrono::duration<double, std::nano>::max();
+
+        for (int r = 0; r < repetitions; ++r)
+        {
+            const auto start = clock::now();
+            f();
+            best = std::min<decltype(best)>(best, clock::now() - start);
+        }
+
+        return best.count() / static_cast<double>(ops);
+    }
+
+    //  Evicts the data caches by writing to a buffer larger than common last-level caches.
+    //
+    inline auto evict_caches() -> void
+    {
+        static auto buffer = std::vector<unsigned char>(64 << 20);
+
+        for (std::size_t i = 0; i < buffer.size(); i += 64)
+            ++buffer[i];
+
+        do_not_optimize(buffer.front());
+    }
+
+    //  As ns_per_op, but evicts the caches before each run, untimed, so that every run starts cold.
+    //
+    template <typename F>
+    auto ns_per_op_cold(F&& f, const std::size_t ops, const int repetitions = 7) -> double
+    {
+        using clock = std::chrono::steady_clock;
+
+        auto best = std::chrono::duration<double, std::nano>::max();
+
+        for (int r = 0; r < repetitions; ++r)
+        {
+            evict_caches();
+
+            const auto start = clock::now();
+            f();
+            best = std::min<decltype(best)>(best, clock::now() - start);
+        }
+
+        return best.count() / static_cast<double>(ops);
+    }
+
+    inline auto print_header(const char* title) -> void
+    {
+        std::printf("\n%s\n", title);
+    }
+
+    inline auto print_row(const char* name, const std::size_t n, const double ns) -> void
+    {
+        std::printf("  %-32s N=%-4zu %8.2f ns/op\n", name, n, ns);
+    }
+}
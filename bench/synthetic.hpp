@@ -0,0 +1,83 @@
+#pragma once
+#include <josa/visitor/hierarchy.hpp>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Synthetic class hierarchies of arbitrary size, used by the benchmarks. synthetic<N> describes a
+//  base class with N final concrete classes, leaf<N,0> ... leaf<N,N-1>.
+//
+//--------------------------------------------------------------------------------------------------
+
+namespace bench
+{
+    template <std::size_t N>
+    struct node
+    {
+        virtual ~node() = default;
+        std::size_t payload = 0;
+    };
+
+    template <std::size_t N, std::size_t I>
+    struct leaf final : node<N> {};
+
+    template <std::size_t N, typename IS = std::make_index_sequence<N>>
+    struct synthetic;
+
+    template <std::size_t N, std::size_t... I>
+    struct synthetic<N, std::index_sequence<I...>>
+    {
+        using base_t = node<N>;
+
+        template <typename... Options>
+        using hierarchy_with = josa::visitor::hierarchy
+        <
+            josa::visitor::base_type<node<N>>,
+            josa::visitor::concrete_types<leaf<N, I>...>,
+            Options...
+        >;
+
+        using hierarchy_t = hierarchy_with<>;
+
+        static auto make(const std::size_t i) -> std::unique_ptr<node<N>>
+        {
+            using factory_t = std::unique_ptr<node<N>>(*)();
+            static constexpr std::array<factory_t, N> factories =
+                {+[]() -> std::unique_ptr<node<N>> { return std::make_unique<leaf<N, I>>(); }...};
+
+            auto p = factories[i % N]();
+            p->payload = i;
+            return p;
+        }
+
+        //  Creates `count` objects whose concrete types are drawn uniformly at random.
+        //
+        static auto make_random(const std::size_t count, const unsigned seed = 42)
+            -> std::vector<std::unique_ptr<node<N>>>
+        {
+            auto rng = std::mt19937{seed};
+            auto dist = std::uniform_int_distribution<std::size_t>{0, N - 1};
+            auto objs = std::vector<std::unique_ptr<node<N>>>{};
+
+            objs.reserve(count);
+
+            for (std::size_t i = 0; i < count; ++i)
+                objs.push_back(make(dist(rng)));
+
+            return objs;
+        }
+    };
+
+    //  A handler with a distinct overload per concrete type.
+    //
+    struct leaf_index
+    {
+        template <std::size_t N, std::size_t I>
+        auto operator () (const leaf<N, I>& obj) const -> std::size_t { return I + obj.payload; }
+    };
+}
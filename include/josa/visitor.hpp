@@ -1,3 +1,7 @@
 #pragma once
 #include "visitor/single_dispatch.hpp"
+#include "visitor/extern.hpp"
 #include "visitor/double_dispatch.hpp"
+#include "visitor/multiple_dispatch.hpp"
+#include "visitor/registry.hpp"
+#include "visitor/profile.hpp"
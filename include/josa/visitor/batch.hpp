@@ -0,0 +1,378 @@
+#pragma once
+#include "common.hpp"
+#include "index_switch.hpp"
+#include "list.hpp"
+#include "ordinal.hpp"
+#include "tagged_ptr.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace josa::visitor
+{
+    namespace detail
+    {
+        //  How many objects ahead visit_all prefetches by default.
+        //
+        inline constexpr std::size_t default_prefetch_distance = 32;
+
+        inline auto prefetch(const void* p) -> void
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(p);
+#else
+            static_cast<void>(p);
+#endif
+        }
+
+        //  The object an element of a range refers to: the element itself if it is an object of the
+        //  hierarchy, otherwise what it points to, e.g. for raw or smart pointers.
+        //
+        template <typename Base, typename T>
+        auto batch_object(T& element) -> decltype(auto)
+        {
+            if constexpr (std::is_base_of_v<Base, std::remove_cv_t<T>>)
+                return static_cast<mk_const_t<std::is_const_v<T>, Base>&>(element);
+            else
+                return batch_object<Base>(*element);
+        }
+
+        template <typename Base, typename InputIt>
+        using batch_object_t = std::remove_reference_t<decltype(batch_object<Base>(*std::declval<InputIt&>()))>;
+
+        //  Pointers to the objects of a range, as references to the base type.
+        //
+        template <typename Base, typename InputIt>
+        auto batch_objects(InputIt first, InputIt last)
+        {
+            using obj_t = mk_const_t<std::is_const_v<batch_object_t<Base, InputIt>>, Base>;
+
+            auto objs = std::vector<obj_t*>{};
+
+            if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+                objs.reserve(static_cast<std::size_t>(std::distance(first, last)));
+
+            for (; first != last; ++first)
+                objs.push_back(&batch_object<Base>(*first));
+
+            return objs;
+        }
+
+        //  What a batch holds for an element of a range: a copy of a tagged pointer of the hierarchy,
+        //  so that the object is not read until it is visited, and otherwise a pointer to the object.
+        //
+        template <typename Hierarchy, typename T>
+        auto batch_item(T& element)
+        {
+            if constexpr (is_tagged_v<T, Hierarchy>)
+                return tagged_of(element);
+            else
+                return &batch_object<typename hierarchy_traits<Hierarchy>::base_t>(element);
+        }
+
+        template <typename Hierarchy, typename InputIt>
+        using batch_item_t = decltype(batch_item<Hierarchy>(*std::declval<InputIt&>()));
+
+        //  The object of an item, const if the range's objects are.
+        //
+        template <typename Item>
+        using batch_item_object_t = std::remove_reference_t<decltype(*std::declval<const Item&>())>;
+
+        template <typename Hierarchy, typename InputIt>
+        auto batch_items(InputIt first, InputIt last) -> std::vector<batch_item_t<Hierarchy, InputIt>>
+        {
+            auto items = std::vector<batch_item_t<Hierarchy, InputIt>>{};
+
+            if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+                items.reserve(static_cast<std::size_t>(std::distance(first, last)));
+
+            for (; first != last; ++first)
+                items.push_back(batch_item<Hierarchy>(*first));
+
+            return items;
+        }
+
+        //  The ordinal of an item: looked up by ordinal_of for a pointer, and carried by a tagged
+        //  pointer.
+        //
+        template <typename Ordinal, typename Item>
+        auto batch_item_ordinal(Ordinal& ordinal_of, const Item& item) -> std::size_t
+        {
+            if constexpr (std::is_pointer_v<Item>)
+                return ordinal_of(*item);
+            else
+                return item.ordinal();
+        }
+
+        //  A direct-mapped memo of ordinals for a hierarchy of N types, local to one visit_all.
+        //
+        template <std::size_t N>
+        class batch_memo
+        {
+        public:
+
+            struct entry
+            {
+                const void* key = nullptr;
+                std::size_t ordinal = npos;
+            };
+
+            auto slot(const void* key) -> entry&
+            {
+                return entries_[address_hash(key) & (entries_.size() - 1)];
+            }
+
+        private:
+
+            std::array<entry, std::max(std::size_t{64}, table_capacity(N))> entries_{};
+        };
+
+        //  Number of objects bucketed at a time for a hierarchy of N types: small enough that a
+        //  chunk's objects are still in cache when they are visited, and large enough that the
+        //  buckets are not mostly empty.
+        //
+        constexpr auto batch_chunk_size(const std::size_t n) -> std::size_t
+        {
+            return std::min(std::size_t{4096}, std::max(std::size_t{256}, 8 * n));
+        }
+
+        //  Visits a batch of objects grouped by concrete type, one chunk at a time. The ordinals of
+        //  a chunk's objects are looked up first, so an unhandled type throws before any object of
+        //  its chunk is visited. The chunk is then bucketed by ordinal with a counting sort, and each
+        //  bucket is visited in a loop that calls the handler for a single concrete type, where the
+        //  call is direct and easily predicted.
+        //
+        //  items points to count items for the objects to visit, each a pointer to an object or a
+        //  tagged pointer. Ordinal(obj) looks up the ordinal of an object that is not tagged, and
+        //  throws for unhandled types, and VisitCase(size_constant<k>, obj) visits an object whose
+        //  ordinal is k. Count(counts) is given the number of objects of each of the N types in a
+        //  chunk, before the chunk is visited. Unless Results is nullptr, results.store(i, result)
+        //  receives the result for the i-th object of a chunk, and results.flush(n) is called once
+        //  the chunk's n objects have been visited.
+        //
+        template <std::size_t N, std::size_t PrefetchDistance>
+        struct batch_visit
+        {
+            static constexpr auto chunk_size = batch_chunk_size(N);
+
+            template <typename Item, typename Ordinal, typename VisitCase, typename Count, typename Results>
+            static auto run(const Item* items, const std::size_t count, Ordinal&& ordinal_of, VisitCase&& visit_case,
+                            Count&& count_chunk, Results&& results) -> void
+            {
+                constexpr auto stores = !std::is_same_v<std::decay_t<Results>, std::nullptr_t>;
+
+                //  A tagged pointer's object is not read to find its ordinal, so it is not prefetched:
+                //  the handler may not read it either, and prefetching it as it is visited measured
+                //  no faster when it does.
+                //
+                constexpr auto tagged = !std::is_pointer_v<Item>;
+
+                //  Up to a chunk of scratch space, tens of kilobytes for a large hierarchy, is allocated
+                //  once per call rather than taken from the stack, which a handler may need more.
+                //
+                const auto scratch_size = std::min(chunk_size, count);
+
+                auto ordinals = std::vector<std::size_t>(scratch_size);
+                auto sorted = std::vector<Item>(scratch_size);
+                auto positions = std::vector<std::size_t>(stores ? scratch_size : 0);
+
+                for (std::size_t first = 0; first < count; first += chunk_size)
+                {
+                    const auto n = std::min(chunk_size, count - first);
+                    const auto chunk = items + first;
+                    const auto prefetch_end = count - first;
+
+                    auto bucket_end = std::array<std::size_t, N + 1>{};
+
+                    for (std::size_t i = 0; i < n; ++i)
+                    {
+                        if constexpr (PrefetchDistance > 0 && !tagged)
+                        {
+                            if (i + PrefetchDistance < prefetch_end)
+                                prefetch(chunk[i + PrefetchDistance]);
+                        }
+
+                        ordinals[i] = batch_item_ordinal(ordinal_of, chunk[i]);
+                        ++bucket_end[ordinals[i] + 1];
+                    }
+
+                    count_chunk(bucket_end.data() + 1);
+
+                    for (std::size_t k = 1; k <= N; ++k)
+                        bucket_end[k] += bucket_end[k - 1];
+
+                    //  bucket_end[k] is now where bucket k begins; filling the buckets moves it to
+                    //  where bucket k ends.
+                    //
+                    for (std::size_t i = 0; i < n; ++i)
+                    {
+                        const auto j = bucket_end[ordinals[i]]++;
+                        sorted[j] = chunk[i];
+
+                        if constexpr (stores)
+                            positions[j] = i;
+                    }
+
+                    for (std::size_t k = 0, begin = 0; k < N; begin = bucket_end[k++])
+                    {
+                        const auto end = bucket_end[k];
+
+                        if (begin == end)
+                            continue;
+
+                        index_switch<void, N>(k, [&](auto ordinal) {
+                            for (auto j = begin; j < end; ++j)
+                            {
+                                if constexpr (stores)
+                                    results.store(positions[j], visit_case(ordinal, *sorted[j]));
+                                else
+                                    visit_case(ordinal, *sorted[j]);
+                            }
+                        });
+                    }
+
+                    if constexpr (stores)
+                        results.flush(n);
+                }
+            }
+        };
+
+        //  Sorts the objects of a range into buckets by ordinal with a counting sort, and returns
+        //  where each bucket begins in sorted, with the end of the last at index N. The ordinals of
+        //  all the objects are looked up before any is sorted, so an unhandled type throws first.
+        //
+        template <std::size_t N, typename Obj, typename Ordinal>
+        auto bucket_by_ordinal(const std::vector<Obj*>& objs, Ordinal&& ordinal_of, std::vector<Obj*>& sorted) -> std::array<std::size_t, N + 1>
+        {
+            auto ordinals = std::vector<std::size_t>(objs.size());
+            auto begins = std::array<std::size_t, N + 1>{};
+
+            for (std::size_t i = 0; i < objs.size(); ++i)
+            {
+                ordinals[i] = ordinal_of(*objs[i]);
+                ++begins[ordinals[i] + 1];
+            }
+
+            for (std::size_t k = 1; k <= N; ++k)
+                begins[k] += begins[k - 1];
+
+            auto next = begins;
+            sorted.resize(objs.size());
+
+            for (std::size_t i = 0; i < objs.size(); ++i)
+                sorted[next[ordinals[i]]++] = objs[i];
+
+            return begins;
+        }
+
+        //  Number of objects of the second range of a cross product that are paired with each
+        //  object of the first before moving on to the next tile, so that they stay in cache while
+        //  the first range streams past.
+        //
+        inline constexpr std::size_t pair_tile_size = 256;
+
+        //  Every pair of an object of one span with an object of another, the second span a tile at
+        //  a time.
+        //
+        template <typename Obj1, typename Obj2>
+        struct cross_block
+        {
+            using obj1_t = Obj1;
+            using obj2_t = Obj2;
+
+            Obj1* const* objs1;
+            std::size_t count1;
+            Obj2* const* objs2;
+            std::size_t count2;
+
+            template <typename G>
+            auto for_each(G&& g) const -> void
+            {
+                for (std::size_t tile = 0; tile < count2; tile += pair_tile_size)
+                {
+                    const auto tile_end = std::min(count2, tile + pair_tile_size);
+
+                    for (std::size_t i = 0; i < count1; ++i)
+                    {
+                        auto& obj1 = *objs1[i];
+
+                        for (auto j = tile; j < tile_end; ++j)
+                            g(obj1, *objs2[j]);
+                    }
+                }
+            }
+        };
+
+        template <typename Obj1, typename Obj2>
+        struct object_pair
+        {
+            std::size_t key;
+            Obj1* obj1;
+            Obj2* obj2;
+        };
+
+        //  A run of listed pairs.
+        //
+        template <typename Obj1, typename Obj2>
+        struct list_block
+        {
+            using obj1_t = Obj1;
+            using obj2_t = Obj2;
+
+            const object_pair<Obj1, Obj2>* pairs;
+            std::size_t count;
+
+            template <typename G>
+            auto for_each(G&& g) const -> void
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                    g(*pairs[i].obj1, *pairs[i].obj2);
+            }
+        };
+
+        //  Collects the results of one chunk and writes them to an output iterator in the order of
+        //  the range. A result type that cannot be default constructed is held in a std::optional.
+        //
+        template <typename Result, typename OutputIt>
+        class batch_results
+        {
+            using value_t = std::decay_t<Result>;
+            using slot_t = std::conditional_t<std::is_default_constructible_v<value_t>, value_t, std::optional<value_t>>;
+
+        public:
+
+            batch_results(const std::size_t chunk_size, OutputIt out) : slots_(chunk_size), out_{out} {}
+
+            auto store(const std::size_t i, Result&& result) -> void
+            {
+                slots_[i] = std::forward<Result>(result);
+            }
+
+            auto flush(const std::size_t n) -> void
+            {
+                for (std::size_t i = 0; i < n; ++i, ++out_)
+                {
+                    if constexpr (std::is_same_v<slot_t, value_t>)
+                        *out_ = std::move(slots_[i]);
+                    else
+                        *out_ = std::move(*slots_[i]);
+                }
+            }
+
+            auto out() const -> OutputIt
+            {
+                return out_;
+            }
+
+        private:
+
+            std::vector<slot_t> slots_;
+            OutputIt out_;
+        };
+    }
+}
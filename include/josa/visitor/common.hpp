@@ -1,6 +1,23 @@
 #pragma once
+#include "hierarchy.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+
+//  Whether exceptions are enabled. Without them, visiting an object of an unhandled type prints
+//  the type and aborts where it would otherwise throw unhandled_type; try_visit and visit_or never
+//  throw either way.
+//
+#if !defined(JOSA_VISITOR_EXCEPTIONS)
+#   if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#       define JOSA_VISITOR_EXCEPTIONS 1
+#   else
+#       define JOSA_VISITOR_EXCEPTIONS 0
+#   endif
+#endif
 
 namespace josa::visitor
 {
@@ -23,5 +40,84 @@ namespace josa::visitor
 
         template <typename T> struct mk_const<true, T> { using type = const T; };
         template <typename T> struct mk_const<false, T> { using type = T; };
+
+        template <typename T>
+        struct is_hierarchy : std::false_type {};
+
+        template <typename BaseType, typename ConcreteTypes, typename... Options>
+        struct is_hierarchy<hierarchy<BaseType, ConcreteTypes, Options...>> : std::true_type {};
+
+        //  Reports an object of an unhandled type. The names of the types are only worked out here,
+        //  by calling describe(), so that the visit itself stays cheap.
+        //
+        template <typename Describe>
+        [[noreturn]] auto unhandled(Describe&& describe) -> void
+        {
+#if JOSA_VISITOR_EXCEPTIONS
+            throw unhandled_type{describe()};
+#else
+            std::fprintf(stderr, "josa::visitor: unhandled type (%s)\n", describe().c_str());
+            std::abort();
+#endif
+        }
+
+        //  What try_visit returns for a handler that returns R: whether the object was visited if R
+        //  is void, otherwise the result, if any, by value.
+        //
+        template <typename R>
+        struct try_result
+        {
+            using type = std::optional<std::remove_cv_t<std::remove_reference_t<R>>>;
+
+            static auto none() -> type { return std::nullopt; }
+
+            template <typename Visit>
+            static auto of(Visit&& visit) -> type { return type{visit()}; }
+        };
+
+        template <>
+        struct try_result<void>
+        {
+            using type = bool;
+
+            static auto none() -> type { return false; }
+
+            template <typename Visit>
+            static auto of(Visit&& visit) -> type { visit(); return true; }
+        };
+
+        template <typename Dispatch> struct dispatch_result;
+
+        template <typename R, typename... Params>
+        struct dispatch_result<R (*)(Params...)> { using type = R; };
+
+        //  Whether the dispatch function of a case returns R. Cases must all return the same type to
+        //  share a dispatch table; a switch would instead convert each result to the type of the
+        //  first case, so it checks every case with this.
+        //
+        template <typename R, typename Case>
+        inline constexpr bool case_returns_v = std::is_same_v<typename dispatch_result<decltype(&Case::dispatch)>::type, R>;
+
+        template <typename T, typename = void>
+        struct has_dispatcher : std::false_type {};
+
+        template <typename T>
+        struct has_dispatcher<T, std::void_t<typename T::dispatcher_t>> : std::true_type {};
+    }
+
+    //  Fills the type lookup tables for a hierarchy, a dispatcher, or a visitor class deriving from
+    //  enable_dispatch. This normally happens during static initialization; calling warm_up at
+    //  startup guarantees it has happened before the first visit, e.g. for visitors used from other
+    //  static initializers.
+    //
+    template <typename T>
+    auto warm_up() -> void
+    {
+        if constexpr (detail::has_dispatcher<T>::value)
+            T::dispatcher_t::warm_up();
+        else if constexpr (detail::is_hierarchy<T>::value)
+            dispatcher<T>::warm_up();
+        else
+            T::warm_up();
     }
 }
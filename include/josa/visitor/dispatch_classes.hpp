@@ -0,0 +1,158 @@
+#pragma once
+#include "list.hpp"
+#include "ordinal.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace josa::visitor
+{
+    //  A handler for double dispatch may declare the parameter types its overloads take, as
+    //
+    //      using overload_types = josa::visitor::overload_types<types<...>, types<...>>;
+    //
+    //  with one list for each dispatched parameter. Concrete types that derive from the same
+    //  listed types select the same overload, so the dispatcher groups them into classes and
+    //  builds a table, and instantiates a dispatch function, per pair of classes rather than per
+    //  pair of concrete types; the handler is then called with each object as the most derived
+    //  listed type it derives from, or as the base type if there is none. A list must include
+    //  every type an overload takes for that parameter, other than types that every concrete
+    //  type derives from, and the listed types a concrete type derives from must form a single
+    //  chain of inheritance.
+    //
+    template <typename... Ts> struct types {};
+    template <typename... TypeLists> struct overload_types {};
+
+    namespace detail
+    {
+        template <typename F, typename = void>
+        struct handler_overload_types { using type = void; };
+
+        template <typename F>
+        struct handler_overload_types<F, std::void_t<typename F::overload_types>> { using type = typename F::overload_types; };
+
+        template <typename F>
+        using handler_overload_types_t = typename handler_overload_types<std::remove_cv_t<std::remove_reference_t<F>>>::type;
+
+        //  Bit p is set if T derives from (or is) the p-th of Params.
+        //
+        template <typename T, typename... Params>
+        constexpr auto listed_bases() -> std::uint64_t
+        {
+            auto mask = std::uint64_t{0};
+            auto bit = std::uint64_t{1};
+            ((mask |= std::is_base_of_v<Params, T> ? bit : 0, bit <<= 1), ...);
+            return mask;
+        }
+
+        template <std::size_t N>
+        struct class_numbering
+        {
+            std::array<std::size_t, N> class_of{};
+            std::array<std::uint64_t, N> masks{};
+            std::size_t count = 0;
+        };
+
+        //  Numbers the distinct masks in order of first appearance.
+        //
+        template <std::size_t N>
+        constexpr auto number_classes(const std::array<std::uint64_t, N>& masks) -> class_numbering<N>
+        {
+            auto n = class_numbering<N>{};
+
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                auto k = std::size_t{0};
+
+                while (k < n.count && n.masks[k] != masks[i])
+                    ++k;
+
+                if (k == n.count)
+                    n.masks[n.count++] = masks[i];
+
+                n.class_of[i] = k;
+            }
+
+            return n;
+        }
+
+        template <typename Id, std::size_t N>
+        constexpr auto class_ids_of(const class_numbering<N>& n) -> std::array<Id, N>
+        {
+            std::array<Id, N> ids{};
+
+            for (std::size_t i = 0; i < N; ++i)
+                ids[i] = static_cast<Id>(n.class_of[i]);
+
+            return ids;
+        }
+
+        //  The listed type that objects deriving from the listed types in mask are passed as: the
+        //  one that derives from all the others, P if mask is empty, or npos if the types in mask
+        //  are not a chain.
+        //
+        template <std::size_t P>
+        constexpr auto class_representative(const std::uint64_t mask, const std::array<std::uint64_t, P>& param_bases) -> std::size_t
+        {
+            if (mask == 0)
+                return P;
+
+            for (std::size_t p = 0; p < P; ++p)
+            {
+                if ((mask >> p & 1) && (param_bases[p] & mask) == mask)
+                    return p;
+            }
+
+            return npos;
+        }
+
+        //  Groups the concrete types of a hierarchy by the set of listed types each derives from.
+        //
+        template <typename Base, typename ConcreteTL, typename TypeList>
+        struct dispatch_classes;
+
+        template <typename Base, typename... Concretes, typename... Params>
+        struct dispatch_classes<Base, meta::list<Concretes...>, types<Params...>>
+        {
+            static_assert(sizeof...(Params) <= 64, "overload_types can list at most 64 types per parameter");
+
+            static constexpr std::size_t size = sizeof...(Concretes);
+            static constexpr std::size_t param_count = sizeof...(Params);
+
+            static constexpr auto numbered = number_classes<size>({listed_bases<Concretes, Params...>()...});
+            static constexpr std::array<std::uint64_t, param_count> param_bases = {listed_bases<Params, Params...>()...};
+
+            static constexpr std::size_t count = numbered.count;
+
+            using class_id_t = std::conditional_t<(count <= 256), std::uint8_t, std::uint16_t>;
+
+            //  The class of each concrete type, by ordinal.
+            //
+            static constexpr auto class_ids = class_ids_of<class_id_t>(numbered);
+
+            template <std::size_t P, bool = (P < param_count)>
+            struct param { using type = meta::at_t<P, meta::list<Params...>>; };
+
+            template <std::size_t P>
+            struct param<P, false>
+            {
+                static_assert(P == param_count, "a concrete type derives from listed types that are not a single chain of inheritance");
+                using type = Base;
+            };
+
+            template <std::size_t K>
+            using class_type_t = typename param<class_representative(numbered.masks[K], param_bases)>::type;
+
+            template <typename IS = std::make_index_sequence<count>> struct class_types;
+
+            template <std::size_t... K>
+            struct class_types<std::index_sequence<K...>> { using type = meta::list<class_type_t<K>...>; };
+
+            //  The types that the objects of each class are passed as, in class order.
+            //
+            using class_types_t = typename class_types<>::type;
+        };
+    }
+}
@@ -1,133 +1,337 @@
 #pragma once
+#include "batch.hpp"
 #include "common.hpp"
+#include "dispatch_classes.hpp"
+#include "handled_pairs.hpp"
 #include "hierarchy.hpp"
+#include "hooks.hpp"
+#include "index_switch.hpp"
+#include "inline_cache.hpp"
+#include "instrument.hpp"
 #include "list.hpp"
+#include "ordinal.hpp"
 #include "overload.hpp"
-#include <unordered_map>
-#include <typeindex>
+#include "parallel.hpp"
+#include "table_stats.hpp"
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <typeinfo>
 #include <type_traits>
+#include <vector>
 
 namespace josa::visitor
 {
     namespace detail
     {
-        struct hasher
+        template <bool Const1, bool Const2, typename F, typename Base1, typename Base2, typename ConcretePair, typename... Args>
+        struct dispatch_case_2
         {
-            auto operator () (const std::array<std::type_index, 2>& key) const -> std::size_t
+            static auto dispatch(F&& f, mk_const_t<Const1, Base1>& obj1, mk_const_t<Const2, Base2>& obj2,
+                                Args&&... args) -> decltype(auto)
             {
-                constexpr auto h = std::hash<std::type_index>{};
-                return h(key[0]) ^ (h(key[1]) << 1);
+                //  A compile-error on the following line probably means a case is missing from a visitor
+                //  class or overloaded function.
+                //
+                return f(static_cast<mk_const_t<Const1, meta::at_t<0, ConcretePair>>&>(obj1), 
+                    static_cast<mk_const_t<Const2, meta::at_t<1, ConcretePair>>&>(obj2), 
+                    std::forward<Args>(args)...);
             }
         };
 
         template <bool Const1, bool Const2, typename F, typename Base1, typename Base2, typename ConcretePair, typename... Args>
-        auto make_dispatcher_2()
+        constexpr auto make_dispatcher_2()
         {
-            struct dispatcher
-            {
-                static auto dispatch(F&& f, mk_const_t<Const1, Base1>& obj1, mk_const_t<Const2, Base2>& obj2,
-                                    Args&&... args) -> decltype(auto)
-                {
-                    //  A compile-error on the following line probably means a case is missing from a visitor
-                    //  class or overloaded function.
-                    //
-                    return f(static_cast<mk_const_t<Const1, meta::at_t<0, ConcretePair>>&>(obj1), 
-                        static_cast<mk_const_t<Const2, meta::at_t<1, ConcretePair>>&>(obj2), 
-                        std::forward<Args>(args)...);
-                }
-            };
-
-            return &dispatcher::dispatch;
+            return &dispatch_case_2<Const1, Const2, F, Base1, Base2, ConcretePair, Args...>::dispatch;
         }
 
+        //  Builds a row-major N1 x N2 matrix of dispatch functions, where the function for the pair of
+        //  concrete types with ordinals (i, j) is at index i * N2 + j. meta::all_pairs_t lists the
+        //  pairs in exactly that order.
+        //
         template <bool Const1, bool Const2, typename F, typename Base1, typename Base2,typename ConcreteAllPairsTL, typename ArgTL>
-        struct dispatch_map_maker_2_helper;
+        struct dispatch_table_maker_2_helper;
 
         template <bool Const1, bool Const2, typename F, typename Base1, typename Base2, typename... ConcretePairs, typename... Args>
-        struct dispatch_map_maker_2_helper<Const1, Const2, F, Base1, Base2, meta::list<ConcretePairs...>, meta::list<Args...>>
+        struct dispatch_table_maker_2_helper<Const1, Const2, F, Base1, Base2, meta::list<ConcretePairs...>, meta::list<Args...>>
         {
-            using key_t = std::array<std::type_index, 2>;
-            using value_t = std::common_type_t<decltype(make_dispatcher_2<Const1, Const2, F, Base1, Base2, ConcretePairs, Args...>())...>;
-            using map_t = std::unordered_map<key_t, value_t, hasher>;
+            //  Every dispatch function has the same signature; std::common_type_t would check this too,
+            //  but its recursion depth grows with N1 x N2.
+            //
+            using value_t = decltype(make_dispatcher_2<Const1, Const2, F, Base1, Base2, meta::head_t<meta::list<ConcretePairs...>>, Args...>());
+            using table_t = std::array<value_t, sizeof...(ConcretePairs)>;
 
-            static auto make() -> map_t
+            static constexpr auto make() -> table_t
             {
-                return {{{std::type_index(typeid(meta::at_t<0, ConcretePairs>)), std::type_index(typeid(meta::at_t<1, ConcretePairs>))},
-                    make_dispatcher_2<Const1, Const2, F, Base1, Base2, ConcretePairs, Args...>()}...};
+                return {make_dispatcher_2<Const1, Const2, F, Base1, Base2, ConcretePairs, Args...>()...};
             }
         };
 
         template <bool Const1, bool Const2, typename F, typename Base1, typename Base2, typename ConcreteTL1, typename ConcreteTL2, typename ArgTL>
-        struct dispatch_map_maker_2;
+        struct dispatch_table_maker_2;
 
         template <bool Const1, bool Const2, typename F, typename Base1, typename Base2,typename... Concretes1, typename... Concretes2, typename... Args>
-        struct dispatch_map_maker_2<Const1, Const2, F, Base1, Base2, meta::list<Concretes1...>, meta::list<Concretes2...>, meta::list<Args...>>
+        struct dispatch_table_maker_2<Const1, Const2, F, Base1, Base2, meta::list<Concretes1...>, meta::list<Concretes2...>, meta::list<Args...>>
         {
-            static auto make() -> decltype(auto)
+            static constexpr auto make() -> decltype(auto)
             {
-                return dispatch_map_maker_2_helper<Const1, Const2, F, Base1, Base2,
+                return dispatch_table_maker_2_helper<Const1, Const2, F, Base1, Base2,
                     meta::all_pairs_t<meta::list<Concretes1...>, meta::list<Concretes2...>>, meta::list<Args...>>::make();
             }
         };
+
+        //  A handler whose result does not depend on the order of the objects can declare
+        //
+        //      static constexpr bool symmetric = true;
+        //
+        //  when both objects are of the same hierarchy. It is then only called with the objects in
+        //  order of their concrete types' ordinals (or of their classes, with overload_types), and
+        //  needs overloads, and a table entry, for just one order of each pair of types.
+        //
+        template <typename F, typename = void>
+        struct handler_is_symmetric : std::false_type {};
+
+        template <typename F>
+        struct handler_is_symmetric<F, std::enable_if_t<F::symmetric>> : std::true_type {};
+
+        template <typename F>
+        inline constexpr bool handler_is_symmetric_v = handler_is_symmetric<std::remove_cv_t<std::remove_reference_t<F>>>::value;
+
+        //  Number of pairs (a, b) with a <= b < n.
+        //
+        constexpr auto triangle_size(const std::size_t n) -> std::size_t
+        {
+            return n * (n + 1) / 2;
+        }
+
+        //  Position of the pair (a, b), a <= b < n, when the upper triangle of an n x n matrix is
+        //  stored row by row.
+        //
+        constexpr auto triangle_index(const std::size_t a, const std::size_t b, const std::size_t n) -> std::size_t
+        {
+            return a * (2 * n - a - 1) / 2 + b;
+        }
+
+        constexpr auto triangle_row(std::size_t k, const std::size_t n) -> std::size_t
+        {
+            auto a = std::size_t{0};
+
+            for (; k >= n - a; ++a)
+                k -= n - a;
+
+            return a;
+        }
+
+        constexpr auto triangle_column(const std::size_t k, const std::size_t n) -> std::size_t
+        {
+            const auto a = triangle_row(k, n);
+            return k - triangle_index(a, a, n) + a;
+        }
+
+        //  Builds the upper triangle of the matrix of dispatch functions for pairs of types from the
+        //  same list, in the order of triangle_index.
+        //
+        template <bool Const1, bool Const2, typename F, typename Base, typename TypeTL, typename ArgTL,
+                  typename IS = std::make_index_sequence<triangle_size(meta::size<TypeTL>::value)>>
+        struct dispatch_triangle_maker_2;
+
+        template <bool Const1, bool Const2, typename F, typename Base, typename TypeTL, typename... Args, std::size_t... K>
+        struct dispatch_triangle_maker_2<Const1, Const2, F, Base, TypeTL, meta::list<Args...>, std::index_sequence<K...>>
+        {
+            static constexpr auto n = meta::size<TypeTL>::value;
+
+            template <std::size_t k>
+            using pair_t = meta::list<meta::at_t<triangle_row(k, n), TypeTL>, meta::at_t<triangle_column(k, n), TypeTL>>;
+
+            static constexpr auto make() -> decltype(auto)
+            {
+                return dispatch_table_maker_2_helper<Const1, Const2, F, Base, Base, meta::list<pair_t<K>...>, meta::list<Args...>>::make();
+            }
+        };
+
+        //  Calls a handler for every pair of a block of pairs of objects of the same two concrete
+        //  types, so that the call is direct and can be inlined into the loop.
+        //
+        template <typename F, typename ConcretePair, typename Block>
+        struct pair_block_case
+        {
+            static auto run(F& f, const Block& block) -> void
+            {
+                using concrete1_t = mk_const_t<std::is_const_v<typename Block::obj1_t>, meta::at_t<0, ConcretePair>>;
+                using concrete2_t = mk_const_t<std::is_const_v<typename Block::obj2_t>, meta::at_t<1, ConcretePair>>;
+
+                block.for_each([&f](auto& obj1, auto& obj2) {
+                    f(static_cast<concrete1_t&>(obj1), static_cast<concrete2_t&>(obj2)); });
+            }
+        };
+
+        template <typename F, typename ConcreteAllPairsTL, typename Block>
+        struct pair_block_table_maker;
+
+        template <typename F, typename... ConcretePairs, typename Block>
+        struct pair_block_table_maker<F, meta::list<ConcretePairs...>, Block>
+        {
+            using value_t = void (*)(F&, const Block&);
+
+            static constexpr auto make() -> std::array<value_t, sizeof...(ConcretePairs)>
+            {
+                return {&pair_block_case<F, ConcretePairs, Block>::run...};
+            }
+        };
+
+        //  The types that the objects of a double dispatch are passed to the handler as, and the
+        //  position among them of each concrete type: the concrete types themselves, unless the
+        //  handler declares its overload_types, in which case there is one per class of types.
+        //
+        template <typename OverloadTypes, typename Base1, typename Base2, typename ConcreteTL1, typename ConcreteTL2>
+        struct dispatch_axes_2
+        {
+            static_assert(std::is_void_v<OverloadTypes>, "overload_types for double dispatch needs two lists of types");
+
+            using types1_t = ConcreteTL1;
+            using types2_t = ConcreteTL2;
+
+            static auto index1(const std::size_t i) -> std::size_t { return i; }
+            static auto index2(const std::size_t j) -> std::size_t { return j; }
+        };
+
+        template <typename Types1, typename Types2, typename Base1, typename Base2, typename ConcreteTL1, typename ConcreteTL2>
+        struct dispatch_axes_2<overload_types<Types1, Types2>, Base1, Base2, ConcreteTL1, ConcreteTL2>
+        {
+            using classes1_t = dispatch_classes<Base1, ConcreteTL1, Types1>;
+            using classes2_t = dispatch_classes<Base2, ConcreteTL2, Types2>;
+
+            using types1_t = typename classes1_t::class_types_t;
+            using types2_t = typename classes2_t::class_types_t;
+
+            static auto index1(const std::size_t i) -> std::size_t { return classes1_t::class_ids[i]; }
+            static auto index2(const std::size_t j) -> std::size_t { return classes2_t::class_ids[j]; }
+        };
     }
 
-    template <typename Base1, typename Base2, typename... Concretes1, typename... Concretes2>
-    struct dispatcher<hierarchy<base_type<Base1>, concrete_types<Concretes1...>>,
-                    hierarchy<base_type<Base2>, concrete_types<Concretes2...>>>
+    template <typename Base1, typename Base2, typename... Concretes1, typename... Options1, typename... Concretes2, typename... Options2>
+    struct dispatcher<hierarchy<base_type<Base1>, concrete_types<Concretes1...>, Options1...>,
+                    hierarchy<base_type<Base2>, concrete_types<Concretes2...>, Options2...>>
     {
+        using Hierarchy1 = hierarchy<base_type<Base1>, concrete_types<Concretes1...>, Options1...>;
+        using Hierarchy2 = hierarchy<base_type<Base2>, concrete_types<Concretes2...>, Options2...>;
+        using Ordinal1 = detail::hierarchy_ordinal_t<Hierarchy1>;
+        using Ordinal2 = detail::hierarchy_ordinal_t<Hierarchy2>;
+
         template <typename F, typename... Args>
         static auto visit(F&& f, const Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
         {
-            static const auto dispatch_map =
-                detail::dispatch_map_maker_2<true, true, F, Base1, Base2,
-                meta::list<Concretes1...>, meta::list<Concretes2...>, meta::list<Args...>>::make();
-
-            if (const auto it = dispatch_map.find({std::type_index(typeid(obj1)), std::type_index(typeid(obj2))}); it != dispatch_map.end())
-                return it->second(std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
-    
-            throw unhandled_type{typeid(obj1).name(), typeid(obj2).name()};
+            return visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
         }
 
         template <typename F, typename... Args>
         static auto visit(F&& f, const Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
         {
-            static const auto dispatch_map =
-                detail::dispatch_map_maker_2<true, false, F, Base1, Base2,
-                meta::list<Concretes1...>, meta::list<Concretes2...>, meta::list<Args...>>::make();
+            return visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
 
-            if (const auto it = dispatch_map.find({std::type_index(typeid(obj1)), std::type_index(typeid(obj2))}); it != dispatch_map.end())
-                return it->second(std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        template <typename F, typename... Args>
+        static auto visit(F&& f, Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
 
-            throw unhandled_type{typeid(obj1).name(), typeid(obj2).name()};
+        template <typename F, typename... Args>
+        static auto visit(F&& f, Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
         }
 
+        template <std::size_t Ways, typename F, typename... Args>
+        static auto visit(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, F&& f,
+                        const Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals(lookup<F, 0>(cache, obj1), lookup<F, 1>(cache, obj2),
+                std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename F, typename... Args>
+        static auto visit(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, F&& f,
+                        const Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals(lookup<F, 0>(cache, obj1), lookup<F, 1>(cache, obj2),
+                std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename F, typename... Args>
+        static auto visit(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, F&& f,
+                        Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals(lookup<F, 0>(cache, obj1), lookup<F, 1>(cache, obj2),
+                std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename F, typename... Args>
+        static auto visit(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, F&& f,
+                        Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals(lookup<F, 0>(cache, obj1), lookup<F, 1>(cache, obj2),
+                std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+            
+        //  As visit, but a pair with an object of an unhandled type is not an error: try_visit then
+        //  returns an empty std::optional, or false if the handler returns void, and visit_or
+        //  returns fallback(obj1, obj2, args...). Neither throws or allocates on that path.
+        //
         template <typename F, typename... Args>
-        static auto visit(F&& f, Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        static auto try_visit(F&& f, const Base1& obj1, const Base2& obj2, Args&&... args)
         {
-            static const auto dispatch_map =
-                detail::dispatch_map_maker_2<false, true, F, Base1, Base2,
-                meta::list<Concretes1...>, meta::list<Concretes2...>, meta::list<Args...>>::make();
+            return try_visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
 
-            if (const auto it = dispatch_map.find({std::type_index(typeid(obj1)), std::type_index(typeid(obj2))}); it != dispatch_map.end())
-                return it->second(std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        template <typename F, typename... Args>
+        static auto try_visit(F&& f, const Base1& obj1, Base2& obj2, Args&&... args)
+        {
+            return try_visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
 
-            throw unhandled_type{typeid(obj1).name(), typeid(obj2).name()};
+        template <typename F, typename... Args>
+        static auto try_visit(F&& f, Base1& obj1, const Base2& obj2, Args&&... args)
+        {
+            return try_visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
         }
 
         template <typename F, typename... Args>
-        static auto visit(F&& f, Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        static auto try_visit(F&& f, Base1& obj1, Base2& obj2, Args&&... args)
+        {
+            return try_visit_ordinals(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename F, typename... Args>
+        static auto visit_or(Fallback&& fallback, F&& f, const Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
         {
-            static const auto dispatch_map =
-                detail::dispatch_map_maker_2<false, false, F, Base1, Base2,
-                meta::list<Concretes1...>, meta::list<Concretes2...>, meta::list<Args...>>::make();
+            return visit_ordinals_or(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<Fallback>(fallback), std::forward<F>(f),
+                obj1, obj2, std::forward<Args>(args)...);
+        }
 
-            if (const auto it = dispatch_map.find({std::type_index(typeid(obj1)), std::type_index(typeid(obj2))}); it != dispatch_map.end())
-                return it->second(std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        template <typename Fallback, typename F, typename... Args>
+        static auto visit_or(Fallback&& fallback, F&& f, const Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals_or(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<Fallback>(fallback), std::forward<F>(f),
+                obj1, obj2, std::forward<Args>(args)...);
+        }
 
-            throw unhandled_type{typeid(obj1).name(), typeid(obj2).name()};
+        template <typename Fallback, typename F, typename... Args>
+        static auto visit_or(Fallback&& fallback, F&& f, Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals_or(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<Fallback>(fallback), std::forward<F>(f),
+                obj1, obj2, std::forward<Args>(args)...);
         }
-            
+
+        template <typename Fallback, typename F, typename... Args>
+        static auto visit_or(Fallback&& fallback, F&& f, Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinals_or(lookup<F, Hierarchy1>(obj1), lookup<F, Hierarchy2>(obj2), std::forward<Fallback>(fallback), std::forward<F>(f),
+                obj1, obj2, std::forward<Args>(args)...);
+        }
+
         static auto match(const Base1& obj1, const Base2& obj2) -> decltype(auto)
         {
             return [&obj1, &obj2](auto... fs) -> decltype(auto) {
@@ -151,14 +355,482 @@ namespace josa::visitor
             return [&obj1, &obj2](auto&&... fs) -> decltype(auto) {
                 return dispatcher::visit(overload(std::forward<decltype(fs)>(fs)...), obj1, obj2); };
         }
+
+        template <std::size_t Ways>
+        static auto match(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, const Base1& obj1, const Base2& obj2) -> decltype(auto)
+        {
+            return [&cache, &obj1, &obj2](auto&&... fs) -> decltype(auto) {
+                return dispatcher::visit(cache, overload(std::forward<decltype(fs)>(fs)...), obj1, obj2); };
+        }
+
+        template <std::size_t Ways>
+        static auto match(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, const Base1& obj1, Base2& obj2) -> decltype(auto)
+        {
+            return [&cache, &obj1, &obj2](auto&&... fs) -> decltype(auto) {
+                return dispatcher::visit(cache, overload(std::forward<decltype(fs)>(fs)...), obj1, obj2); };
+        }
+
+        template <std::size_t Ways>
+        static auto match(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, Base1& obj1, const Base2& obj2) -> decltype(auto)
+        {
+            return [&cache, &obj1, &obj2](auto&&... fs) -> decltype(auto) {
+                return dispatcher::visit(cache, overload(std::forward<decltype(fs)>(fs)...), obj1, obj2); };
+        }
+
+        template <std::size_t Ways>
+        static auto match(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, Base1& obj1, Base2& obj2) -> decltype(auto)
+        {
+            return [&cache, &obj1, &obj2](auto&&... fs) -> decltype(auto) {
+                return dispatcher::visit(cache, overload(std::forward<decltype(fs)>(fs)...), obj1, obj2); };
+        }
+
+        //  Visits every pair of an object of the first range with an object of the second, e.g. for
+        //  the broad phase of collision detection. The ranges may hold objects of the hierarchies or
+        //  (smart) pointers to them. Each object's type is looked up once, and both ranges are
+        //  grouped by concrete type, so that the handler for each pair of concrete types is called in
+        //  a loop over the pairs of their objects; the order of the visits is therefore unspecified.
+        //  An object of an unhandled type throws unhandled_type before any pair is visited.
+        //
+        template <typename F, typename InputIt1, typename InputIt2>
+        static auto visit_pairs(F&& f, InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2) -> void
+        {
+            const auto buckets1 = pair_buckets<Base1, Ordinal1, Hierarchy1, sizeof...(Concretes1)>(first1, last1);
+            const auto buckets2 = pair_buckets<Base2, Ordinal2, Hierarchy2, sizeof...(Concretes2)>(first2, last2);
+
+            visit_rows(f, buckets1, 0, buckets1.objs.size(), buckets2);
+        }
+
+        //  Visits each pair of a range of pairs, such as std::pair<const Shape*, const Shape*>, whose
+        //  elements may be objects of the hierarchies or (smart) pointers to them. The pairs are taken
+        //  a chunk at a time, and grouped by the concrete types of their objects before they are
+        //  visited; an unhandled type throws before any pair of its chunk is visited.
+        //
+        template <typename F, typename InputIt>
+        static auto visit_pairs(F&& f, InputIt first, InputIt last) -> void
+        {
+            using element_t = decltype(*first);
+            using obj1_t = std::remove_reference_t<decltype(detail::batch_object<Base1>(std::get<0>(std::declval<element_t&>())))>;
+            using obj2_t = std::remove_reference_t<decltype(detail::batch_object<Base2>(std::get<1>(std::declval<element_t&>())))>;
+            using pair_t = detail::object_pair<obj1_t, obj2_t>;
+
+            constexpr auto n = sizeof...(Concretes1) * sizeof...(Concretes2);
+            constexpr auto chunk_size = std::max(std::size_t{4096}, 2 * n);
+
+            auto pairs = std::vector<pair_t>{};
+            auto sorted = std::vector<pair_t>(chunk_size);
+            auto begins = std::vector<std::size_t>(n + 1);
+
+            pairs.reserve(chunk_size);
+
+            while (first != last)
+            {
+                pairs.clear();
+                std::fill(begins.begin(), begins.end(), std::size_t{0});
+
+                for (; first != last && pairs.size() < chunk_size; ++first)
+                {
+                    auto&& element = *first;
+                    auto& obj1 = detail::batch_object<Base1>(std::get<0>(element));
+                    auto& obj2 = detail::batch_object<Base2>(std::get<1>(element));
+
+                    const auto key = checked_ordinal<Hierarchy1, Ordinal1>(obj1) * sizeof...(Concretes2)
+                        + checked_ordinal<Hierarchy2, Ordinal2>(obj2);
+
+                    pairs.push_back({key, &obj1, &obj2});
+                    ++begins[key + 1];
+                }
+
+                //  A counting sort by pair of concrete types, after which begins[k] is where the
+                //  pairs with key k end.
+                //
+                for (std::size_t k = 1; k <= n; ++k)
+                    begins[k] += begins[k - 1];
+
+                for (const auto& pair : pairs)
+                    sorted[begins[pair.key]++] = pair;
+
+                for (std::size_t begin = 0, end = 0; begin < pairs.size(); begin = end)
+                {
+                    const auto key = sorted[begin].key;
+                    end = begins[key];
+
+                    visit_block(key / sizeof...(Concretes2), key % sizeof...(Concretes2), f,
+                        detail::list_block<obj1_t, obj2_t>{sorted.data() + begin, end - begin});
+                }
+            }
+        }
+
+        //  As visit_pairs over two ranges, across the given number of threads, the calling thread
+        //  included. Each thread visits pairs of a share of the first range's objects with every
+        //  object of the second, with its own copy of f, and the copies are then combined into the
+        //  result with reduce(F, F) -> F, in an unspecified order. If a visit throws, the other
+        //  threads stop at their next share and the exception is rethrown.
+        //
+        template <typename F, typename InputIt1, typename InputIt2, typename Reduce>
+        static auto parallel_visit_pairs(const F& f, InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2,
+                                         Reduce&& reduce, std::size_t threads = detail::default_thread_count()) -> F
+        {
+            const auto buckets1 = pair_buckets<Base1, Ordinal1, Hierarchy1, sizeof...(Concretes1)>(first1, last1);
+            const auto buckets2 = pair_buckets<Base2, Ordinal2, Hierarchy2, sizeof...(Concretes2)>(first2, last2);
+
+            const auto count = buckets1.objs.size();
+            const auto grain = detail::parallel_grain_size(count, std::max(threads, std::size_t{1}), 1);
+
+            threads = std::clamp(threads, std::size_t{1}, std::max(std::size_t{1}, (count + grain - 1) / grain));
+
+            auto states = std::vector<detail::padded<F>>{};
+            states.reserve(threads);
+
+            for (std::size_t worker = 0; worker < threads; ++worker)
+                states.push_back({f});
+
+            detail::parallel_grains(count, grain, threads, [&](const std::size_t worker, const std::size_t begin, const std::size_t end) {
+                visit_rows(states[worker].value, buckets1, begin, end, buckets2); });
+
+            auto result = std::optional<F>{std::move(states[0].value)};
+
+            for (std::size_t worker = 1; worker < threads; ++worker)
+                result.emplace(reduce(std::move(*result), std::move(states[worker].value)));
+
+            return std::move(*result);
+        }
+
+        static auto warm_up() -> void
+        {
+            Ordinal1::warm_up();
+            Ordinal2::warm_up();
+        }
+
+    private:
+
+        //  The ordinal of the concrete type of an object of Hierarchy, either of the two, counted
+        //  for visitor F under that hierarchy if instrumentation is on.
+        //
+        template <typename F, typename Hierarchy, typename Obj>
+        static auto lookup(const Obj& obj) -> std::size_t
+        {
+#if JOSA_VISITOR_INSTRUMENT
+            return detail::instrument<Hierarchy, detail::unhooked_t<F>>::lookup([&obj] { return detail::hierarchy_ordinal_t<Hierarchy>::of(obj); });
+#else
+            return detail::hierarchy_ordinal_t<Hierarchy>::of(obj);
+#endif
+        }
+
+        template <typename F, std::size_t I, std::size_t Ways, typename Obj>
+        static auto lookup(basic_inline_cache<Ways, Hierarchy1, Hierarchy2>& cache, const Obj& obj) -> std::size_t
+        {
+#if JOSA_VISITOR_INSTRUMENT
+            using hierarchy_t = meta::at_t<I, meta::list<Hierarchy1, Hierarchy2>>;
+
+            return detail::instrument<hierarchy_t, detail::unhooked_t<F>>::lookup([&] { return cache.template ordinal_of<I>(obj); });
+#else
+            return cache.template ordinal_of<I>(obj);
+#endif
+        }
+
+        template <typename F, typename Obj1, typename Obj2, typename... Args>
+        using result_t = decltype(detail::dispatch_case_2<std::is_const_v<Obj1>, std::is_const_v<Obj2>, F, Base1, Base2,
+            meta::list<meta::head_t<meta::list<Concretes1...>>, meta::head_t<meta::list<Concretes2...>>>, Args...>
+            ::dispatch(std::declval<F>(), std::declval<Obj1&>(), std::declval<Obj2&>(), std::declval<Args>()...));
+
+        template <typename F, typename Obj1, typename Obj2, typename... Args>
+        static auto visit_ordinals(const std::size_t i, const std::size_t j, F&& f, Obj1& obj1, Obj2& obj2, Args&&... args) -> decltype(auto)
+        {
+            if (i == detail::npos || j == detail::npos)
+                detail::unhandled([&obj1, &obj2] {
+                    return detail::type_name_of<Hierarchy1>(obj1) + ", " + detail::type_name_of<Hierarchy2>(obj2); });
+
+            return dispatch_ordinals(i, j, std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename Obj1, typename Obj2, typename... Args>
+        static auto try_visit_ordinals(const std::size_t i, const std::size_t j, F&& f, Obj1& obj1, Obj2& obj2, Args&&... args)
+        {
+            using try_result = detail::try_result<result_t<F, Obj1, Obj2, Args...>>;
+
+            if (i == detail::npos || j == detail::npos)
+                return try_result::none();
+
+            return try_result::of([&]() -> result_t<F, Obj1, Obj2, Args...> {
+                return dispatch_ordinals(i, j, std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...); });
+        }
+
+        template <typename Fallback, typename F, typename Obj1, typename Obj2, typename... Args>
+        static auto visit_ordinals_or(const std::size_t i, const std::size_t j, Fallback&& fallback, F&& f,
+                                      Obj1& obj1, Obj2& obj2, Args&&... args) -> decltype(auto)
+        {
+            if (i == detail::npos || j == detail::npos)
+                return static_cast<result_t<F, Obj1, Obj2, Args...>>(std::forward<Fallback>(fallback)(obj1, obj2, std::forward<Args>(args)...));
+
+            return dispatch_ordinals(i, j, std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        //  The objects of a range sorted by ordinal, and where the objects of each ordinal begin.
+        //
+        template <typename Obj, std::size_t N>
+        struct buckets
+        {
+            std::vector<Obj*> objs;
+            std::array<std::size_t, N + 1> begins;
+        };
+
+        template <typename Base, typename Ordinal, typename Hierarchy, std::size_t N, typename InputIt>
+        static auto pair_buckets(InputIt first, InputIt last)
+        {
+            const auto objs = detail::batch_objects<Base>(first, last);
+
+            using obj_t = std::remove_pointer_t<typename decltype(objs)::value_type>;
+
+            auto sorted = std::vector<obj_t*>{};
+            auto begins = detail::bucket_by_ordinal<N>(objs, [](const Base& obj) { return checked_ordinal<Hierarchy, Ordinal>(obj); }, sorted);
+
+            return buckets<obj_t, N>{std::move(sorted), begins};
+        }
+
+        template <typename Hierarchy, typename Ordinal, typename Base>
+        static auto checked_ordinal(const Base& obj) -> std::size_t
+        {
+            const auto i = Ordinal::of(obj);
+
+            if (i == detail::npos)
+                detail::unhandled([&obj] { return detail::type_name_of<Hierarchy>(obj); });
+
+            return i;
+        }
+
+        //  Visits the pairs of the objects [begin, end) of the first range's buckets with every
+        //  object of the second's, one block per pair of concrete types.
+        //
+        template <typename F, typename Obj1, typename Obj2>
+        static auto visit_rows(F& f, const buckets<Obj1, sizeof...(Concretes1)>& buckets1, const std::size_t begin, const std::size_t end,
+                               const buckets<Obj2, sizeof...(Concretes2)>& buckets2) -> void
+        {
+            for (std::size_t i = 0; i < sizeof...(Concretes1); ++i)
+            {
+                const auto first1 = std::max(begin, buckets1.begins[i]);
+                const auto last1 = std::min(end, buckets1.begins[i + 1]);
+
+                if (first1 >= last1)
+                    continue;
+
+                for (std::size_t j = 0; j < sizeof...(Concretes2); ++j)
+                {
+                    const auto first2 = buckets2.begins[j];
+                    const auto last2 = buckets2.begins[j + 1];
+
+                    if (first2 == last2)
+                        continue;
+
+                    visit_block(i, j, f, detail::cross_block<Obj1, Obj2>{buckets1.objs.data() + first1, last1 - first1,
+                        buckets2.objs.data() + first2, last2 - first2});
+                }
+            }
+        }
+
+        //  Visits a block of pairs of objects whose concrete types have ordinals (i, j). For a
+        //  handler dispatched over every pair of concrete types, the whole block is visited by one
+        //  function that calls the handler directly; otherwise each pair is dispatched as visit
+        //  would, which still saves looking up the objects' types.
+        //
+        template <typename F, typename Block>
+        static auto visit_block(const std::size_t i, const std::size_t j, F& f, const Block& block) -> void
+        {
+            constexpr auto plain = !detail::handler_is_symmetric_v<F>
+                && std::is_void_v<detail::handler_overload_types_t<F>> && std::is_void_v<detail::handler_handled_pairs_t<F>>;
+
+            if constexpr (plain)
+            {
+                using pairs_t = meta::all_pairs_t<meta::list<Concretes1...>, meta::list<Concretes2...>>;
+
+                constexpr auto n2 = sizeof...(Concretes2);
+                constexpr auto n = sizeof...(Concretes1) * n2;
+                const auto index = i * n2 + j;
+
+                if constexpr (detail::dispatch_uses_switch<Hierarchy1, Hierarchy2>(n))
+                {
+                    detail::index_switch<void, n>(index, [&](auto k) {
+                        using pair_t = meta::list<meta::at_t<decltype(k)::value / n2, meta::list<Concretes1...>>,
+                            meta::at_t<decltype(k)::value % n2, meta::list<Concretes2...>>>;
+
+                        detail::pair_block_case<F, pair_t, Block>::run(f, block); });
+                }
+                else
+                {
+                    using maker_t = detail::pair_block_table_maker<F, pairs_t, Block>;
+                    static constexpr auto block_table = maker_t::make();
+                    static_cast<void>(&detail::counted_table<maker_t, Hierarchy1, Hierarchy2>::counted);
+
+                    block_table[index](f, block);
+                }
+            }
+            else
+                block.for_each([&](auto& obj1, auto& obj2) { dispatch_ordinals(i, j, f, obj1, obj2); });
+        }
+
+        template <typename F>
+        using dispatch_axes_t = detail::dispatch_axes_2<detail::handler_overload_types_t<F>, Base1, Base2,
+            meta::list<Concretes1...>, meta::list<Concretes2...>>;
+
+        //  Calls the handler for the pair of concrete types with ordinals (i, j), which must both be
+        //  valid. A symmetric handler is only instantiated for pairs whose first type comes no later
+        //  than the second, so the objects of the other pairs are swapped.
+        //
+        template <typename F, typename Obj1, typename Obj2, typename... Args>
+        static auto dispatch_ordinals(const std::size_t i, const std::size_t j, F&& f, Obj1& obj1, Obj2& obj2, Args&&... args)
+            -> result_t<F, Obj1, Obj2, Args...>
+        {
+            if constexpr (detail::handler_is_symmetric_v<F>)
+            {
+                static_assert(std::is_void_v<detail::handler_handled_pairs_t<F>>, "a symmetric handler cannot declare handled_pairs");
+                static_assert(std::is_same_v<Hierarchy1, Hierarchy2>, "a symmetric handler needs both objects to be of the same hierarchy");
+                static_assert(std::is_same_v<typename dispatch_axes_t<F>::types1_t, typename dispatch_axes_t<F>::types2_t>,
+                    "a symmetric handler must declare the same overload_types for both parameters");
+
+                const auto a = dispatch_axes_t<F>::index1(i);
+                const auto b = dispatch_axes_t<F>::index2(j);
+
+                if (a <= b)
+                    return dispatch_triangle(a, b, std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+
+                return dispatch_triangle(b, a, std::forward<F>(f), obj2, obj1, std::forward<Args>(args)...);
+            }
+            else if constexpr (!std::is_void_v<detail::handler_handled_pairs_t<F>>)
+            {
+                static_assert(std::is_void_v<detail::handler_overload_types_t<F>>, "a handler cannot declare both handled_pairs and overload_types");
+
+                return dispatch_sparse(i, j, std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+            }
+            else
+                return dispatch_matrix(i, j, std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename Obj1, typename Obj2, typename... Args>
+        static auto dispatch_matrix(const std::size_t i, const std::size_t j, F&& f, Obj1& obj1, Obj2& obj2, Args&&... args)
+            -> result_t<F, Obj1, Obj2, Args...>
+        {
+            constexpr auto is_const1 = std::is_const_v<Obj1>;
+            constexpr auto is_const2 = std::is_const_v<Obj2>;
+
+            using axes_t = dispatch_axes_t<F>;
+            using types1_t = typename axes_t::types1_t;
+            using types2_t = typename axes_t::types2_t;
+
+            constexpr auto n1 = meta::size<types1_t>::value;
+            constexpr auto n2 = meta::size<types2_t>::value;
+
+            const auto index = axes_t::index1(i) * n2 + axes_t::index2(j);
+
+            if constexpr (detail::dispatch_uses_switch<Hierarchy1, Hierarchy2>(n1 * n2))
+            {
+                using case_result_t = result_t<F, Obj1, Obj2, Args...>;
+
+                return detail::index_switch<case_result_t, n1 * n2>(index, [&](auto k) -> case_result_t {
+                    //  n2 is not named here, which GCC 12 fails to substitute in an alias in this lambda.
+                    //
+                    using pair_t = meta::list<meta::at_t<decltype(k)::value / meta::size<types2_t>::value, types1_t>,
+                                              meta::at_t<decltype(k)::value % meta::size<types2_t>::value, types2_t>>;
+                    using case_t = detail::dispatch_case_2<is_const1, is_const2, F, Base1, Base2, pair_t, Args...>;
+                    static_assert(detail::case_returns_v<case_result_t, case_t>, "every case of a visitor must return the same type");
+
+                    return case_t::dispatch(std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...); });
+            }
+            else
+            {
+                using maker_t = detail::dispatch_table_maker_2<is_const1, is_const2, F, Base1, Base2, types1_t, types2_t, meta::list<Args...>>;
+                static constexpr auto dispatch_table = maker_t::make();
+                static_cast<void>(&detail::counted_table<maker_t, Hierarchy1, Hierarchy2>::counted);
+
+                return dispatch_table[index](std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+            }
+        }
+
+        //  Calls a symmetric handler for the pair of types at positions a <= b of the handler's
+        //  dispatch axes.
+        //
+        template <typename F, typename Obj1, typename Obj2, typename... Args>
+        static auto dispatch_triangle(const std::size_t a, const std::size_t b, F&& f, Obj1& obj1, Obj2& obj2, Args&&... args)
+            -> result_t<F, Obj1, Obj2, Args...>
+        {
+            constexpr auto is_const1 = std::is_const_v<Obj1>;
+            constexpr auto is_const2 = std::is_const_v<Obj2>;
+
+            using types_t = typename dispatch_axes_t<F>::types1_t;
+
+            constexpr auto n = meta::size<types_t>::value;
+
+            const auto index = detail::triangle_index(a, b, n);
+
+            if constexpr (detail::dispatch_uses_switch<Hierarchy1, Hierarchy2>(detail::triangle_size(n)))
+            {
+                using case_result_t = result_t<F, Obj1, Obj2, Args...>;
+
+                return detail::index_switch<case_result_t, detail::triangle_size(n)>(index, [&](auto k) -> case_result_t {
+                    constexpr auto row = detail::triangle_row(decltype(k)::value, n);
+                    constexpr auto column = detail::triangle_column(decltype(k)::value, n);
+
+                    using pair_t = meta::list<meta::at_t<row, types_t>, meta::at_t<column, types_t>>;
+                    using case_t = detail::dispatch_case_2<is_const1, is_const2, F, Base1, Base1, pair_t, Args...>;
+                    static_assert(detail::case_returns_v<case_result_t, case_t>, "every case of a visitor must return the same type");
+
+                    return case_t::dispatch(std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...); });
+            }
+            else
+            {
+                using maker_t = detail::dispatch_triangle_maker_2<is_const1, is_const2, F, Base1, types_t, meta::list<Args...>>;
+                static constexpr auto dispatch_table = maker_t::make();
+                static_cast<void>(&detail::counted_table<maker_t, Hierarchy1, Hierarchy2>::counted);
+
+                return dispatch_table[index](std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+            }
+        }
+
+        //  Calls a handler with handled_pairs for the pair of concrete types with ordinals (i, j):
+        //  the pair's number is looked up first, and then its dispatch function.
+        //
+        template <typename F, typename Obj1, typename Obj2, typename... Args>
+        static auto dispatch_sparse(const std::size_t i, const std::size_t j, F&& f, Obj1& obj1, Obj2& obj2, Args&&... args)
+            -> result_t<F, Obj1, Obj2, Args...>
+        {
+            constexpr auto is_const1 = std::is_const_v<Obj1>;
+            constexpr auto is_const2 = std::is_const_v<Obj2>;
+
+            using pairs_t = detail::sparse_pairs<detail::handler_handled_pairs_t<F>, Base1, Base2,
+                meta::list<Concretes1...>, meta::list<Concretes2...>>;
+            using cases_t = typename pairs_t::cases_t;
+
+            static_cast<void>(&detail::counted_table<pairs_t, Hierarchy1, Hierarchy2>::counted);
+
+            const std::size_t id = pairs_t::ids[i * sizeof...(Concretes2) + j];
+
+            if constexpr (detail::dispatch_uses_switch<Hierarchy1, Hierarchy2>(pairs_t::count))
+            {
+                using case_result_t = result_t<F, Obj1, Obj2, Args...>;
+
+                return detail::index_switch<case_result_t, pairs_t::count>(id, [&](auto k) -> case_result_t {
+                    using case_t = detail::dispatch_case_2<is_const1, is_const2, F, Base1, Base2, meta::at_t<decltype(k)::value, cases_t>, Args...>;
+                    static_assert(detail::case_returns_v<case_result_t, case_t>, "every case of a visitor must return the same type");
+
+                    return case_t::dispatch(std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...); });
+            }
+            else
+            {
+                using maker_t = detail::dispatch_table_maker_2_helper<is_const1, is_const2, F, Base1, Base2, cases_t, meta::list<Args...>>;
+                static constexpr auto dispatch_table = maker_t::make();
+                static_cast<void>(&detail::counted_table<maker_t, Hierarchy1, Hierarchy2>::counted);
+
+                return dispatch_table[id](std::forward<F>(f), obj1, obj2, std::forward<Args>(args)...);
+            }
+        }
     };
 
-    template <typename Handler, typename Base1, typename Base2, typename... Concretes1, typename... Concretes2>
-    struct enable_dispatch<Handler, hierarchy<base_type<Base1>, concrete_types<Concretes1...>>,
-                                    hierarchy<base_type<Base2>, concrete_types<Concretes2...>>>
+    template <typename Handler, typename Base1, typename Base2, typename... Concretes1, typename... Options1,
+              typename... Concretes2, typename... Options2>
+    struct enable_dispatch<Handler, hierarchy<base_type<Base1>, concrete_types<Concretes1...>, Options1...>,
+                                    hierarchy<base_type<Base2>, concrete_types<Concretes2...>, Options2...>>
     {
-        using dispatcher_t = dispatcher<hierarchy<base_type<Base1>, concrete_types<Concretes1...>>,
-                                        hierarchy<base_type<Base2>, concrete_types<Concretes2...>>>;
+        using hierarchy1_t = hierarchy<base_type<Base1>, concrete_types<Concretes1...>, Options1...>;
+        using hierarchy2_t = hierarchy<base_type<Base2>, concrete_types<Concretes2...>, Options2...>;
+        using dispatcher_t = dispatcher<hierarchy1_t, hierarchy2_t>;
 
         template <typename... Args>
         auto visit(const Base1& obj1, const Base2& obj2, Args&&... args) const -> decltype(auto)
@@ -208,9 +880,161 @@ namespace josa::visitor
             return dispatcher_t::visit(handler(), obj1, obj2, std::forward<Args>(args)...);
         }
 
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, const Base1& obj1, const Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, const Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, const Base1& obj1, Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, const Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, Base1& obj1, const Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, Base1& obj1, Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy1_t, hierarchy2_t>& cache, Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(const Base1& obj1, const Base2& obj2, Args&&... args) const
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(const Base1& obj1, const Base2& obj2, Args&&... args)
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(const Base1& obj1, Base2& obj2, Args&&... args) const
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(const Base1& obj1, Base2& obj2, Args&&... args)
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(Base1& obj1, const Base2& obj2, Args&&... args) const
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(Base1& obj1, const Base2& obj2, Args&&... args)
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(Base1& obj1, Base2& obj2, Args&&... args) const
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(Base1& obj1, Base2& obj2, Args&&... args)
+        {
+            return dispatcher_t::try_visit(handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, const Base1& obj1, const Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, const Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, const Base1& obj1, Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, const Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, Base1& obj1, const Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, Base1& obj1, const Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, Base1& obj1, Base2& obj2, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, Base1& obj1, Base2& obj2, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), handler(), obj1, obj2, std::forward<Args>(args)...);
+        }
+
     private:
 
-        auto handler() const -> const Handler& { return static_cast<const Handler&>(*this); }
-        auto handler() -> Handler& { return static_cast<Handler&>(*this); }
+        auto handler() const -> const Handler& { check_hooks(); return static_cast<const Handler&>(*this); }
+        auto handler() -> Handler& { check_hooks(); return static_cast<Handler&>(*this); }
+
+        //  Hooks are called around the handlers of one object; there is no ordinal to pass for two.
+        //
+        static constexpr auto check_hooks() -> void
+        {
+            static_assert(std::is_void_v<detail::handler_hooks_t<Handler>>,
+                          "visit_hooks are only supported by single dispatch");
+        }
     };
 }
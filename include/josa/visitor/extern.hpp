@@ -0,0 +1,32 @@
+#pragma once
+#include "single_dispatch.hpp"
+
+//--------------------------------------------------------------------------------------------------
+//
+//  Compiling the dispatch of a visitor class in one translation unit only. Every translation unit
+//  that calls visit on an enable_dispatch visitor otherwise instantiates its dispatch table and the
+//  case for every concrete type, and the linker keeps one copy. In a header, after the visitor:
+//
+//      JOSA_VISITOR_EXTERN(Visitor, Hierarchy, Args...);
+//
+//  declares that the dispatch of Visitor over Hierarchy, with extra arguments of types Args..., is
+//  instantiated elsewhere, and in one source file:
+//
+//      JOSA_VISITOR_INSTANTIATE(Visitor, Hierarchy, Args...);
+//
+//  instantiates it. Both are used at global scope, and Visitor needs external linkage. Args are
+//  the types of the extra arguments as visit forwards them: T& for an lvalue and T for an rvalue;
+//  each different list needs its own pair. Both cover a const and a non-const visitor visiting a
+//  const and a non-const object; a combination the visitor cannot handle is left to the dispatcher.
+//  Hierarchy must not contain a top-level comma, so name it with an alias.
+//
+//--------------------------------------------------------------------------------------------------
+
+#define JOSA_VISITOR_DETAIL_ENTRIES(Prefix, Visitor, ...)                                           \
+    Prefix template struct josa::visitor::detail::visit_entry<const Visitor&, true, __VA_ARGS__>;   \
+    Prefix template struct josa::visitor::detail::visit_entry<const Visitor&, false, __VA_ARGS__>;  \
+    Prefix template struct josa::visitor::detail::visit_entry<Visitor&, true, __VA_ARGS__>;         \
+    Prefix template struct josa::visitor::detail::visit_entry<Visitor&, false, __VA_ARGS__>
+
+#define JOSA_VISITOR_EXTERN(Visitor, ...) JOSA_VISITOR_DETAIL_ENTRIES(extern, Visitor, __VA_ARGS__)
+#define JOSA_VISITOR_INSTANTIATE(Visitor, ...) JOSA_VISITOR_DETAIL_ENTRIES(, Visitor, __VA_ARGS__)
@@ -0,0 +1,98 @@
+#pragma once
+#include "dispatch_classes.hpp"
+#include "list.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace josa::visitor
+{
+    //  A handler for double dispatch that handles only a few pairs of concrete types may list them,
+    //  as
+    //
+    //      using handled_pairs = josa::visitor::handled_pairs<types<Ping, Idle>, types<Text, Busy>>;
+    //
+    //  and take every other pair through one overload for the two base types. The dispatcher then
+    //  instantiates a dispatch function for each listed pair and one for the default, rather than
+    //  one per pair of concrete types, and finds them through a table of small indices. A listed
+    //  pair is called with the objects as its concrete types, even when the handler has an overload
+    //  that takes them as more general types.
+    //
+    template <typename... Pairs> struct handled_pairs {};
+
+    namespace detail
+    {
+        template <typename F, typename = void>
+        struct handler_handled_pairs { using type = void; };
+
+        template <typename F>
+        struct handler_handled_pairs<F, std::void_t<typename F::handled_pairs>> { using type = typename F::handled_pairs; };
+
+        template <typename F>
+        using handler_handled_pairs_t = typename handler_handled_pairs<std::remove_cv_t<std::remove_reference_t<F>>>::type;
+
+        template <typename Id, std::size_t N>
+        struct sparse_ids
+        {
+            std::array<Id, N> ids{};
+            bool duplicates = false;
+        };
+
+        //  Numbers the pairs at the given positions of an N-entry table from 1, leaving the other
+        //  entries 0.
+        //
+        template <typename Id, std::size_t N, std::size_t K>
+        constexpr auto number_sparse_pairs(const std::array<std::size_t, K>& positions) -> sparse_ids<Id, N>
+        {
+            auto n = sparse_ids<Id, N>{};
+
+            for (std::size_t k = 0; k < K; ++k)
+            {
+                n.duplicates |= n.ids[positions[k]] != 0;
+                n.ids[positions[k]] = static_cast<Id>(k + 1);
+            }
+
+            return n;
+        }
+
+        //  Numbers the dispatch functions of a handler with handled_pairs: 0 is the default, and
+        //  k + 1 the k-th listed pair.
+        //
+        template <typename HandledPairs, typename Base1, typename Base2, typename ConcreteTL1, typename ConcreteTL2>
+        struct sparse_pairs
+        {
+            static_assert(meta::always_false<HandledPairs>::value, "handled_pairs must list pairs as types<T1, T2>");
+        };
+
+        template <typename... Firsts, typename... Seconds, typename Base1, typename Base2, typename ConcreteTL1, typename ConcreteTL2>
+        struct sparse_pairs<handled_pairs<types<Firsts, Seconds>...>, Base1, Base2, ConcreteTL1, ConcreteTL2>
+        {
+            static constexpr std::size_t count = sizeof...(Firsts) + 1;
+            static constexpr std::size_t n2 = meta::size<ConcreteTL2>::value;
+            static constexpr std::size_t size = meta::size<ConcreteTL1>::value * n2;
+
+            static_assert(count <= 65536, "handled_pairs can list at most 65535 pairs");
+
+            using id_t = std::conditional_t<(count <= 256), std::uint8_t, std::uint16_t>;
+
+            //  The pairs of types each dispatch function is called with, by number.
+            //
+            using cases_t = meta::list<meta::list<Base1, Base2>, meta::list<Firsts, Seconds>...>;
+
+            static constexpr auto numbered = number_sparse_pairs<id_t, size>(std::array<std::size_t, count - 1>
+                {meta::index_of<Firsts, ConcreteTL1>::value * n2 + meta::index_of<Seconds, ConcreteTL2>::value...});
+
+            static_assert(!numbered.duplicates, "handled_pairs lists the same pair twice");
+
+            //  The number of the dispatch function for each pair of ordinals (i, j), at i * N2 + j.
+            //
+            static constexpr auto ids = numbered.ids;
+
+            static constexpr auto make() -> std::array<id_t, size>
+            {
+                return ids;
+            }
+        };
+    }
+}
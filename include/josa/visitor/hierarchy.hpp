@@ -1,8 +1,52 @@
 #pragma once
+#include <type_traits>
 
 namespace josa::visitor 
 {
-    template <typename BaseType, typename ConcreteTypes> struct hierarchy;
+    template <typename BaseType, typename ConcreteTypes, typename... Options> struct hierarchy;
     template <typename T> struct base_type;
     template <typename... Ts> struct concrete_types;
+
+    //  Hierarchy options
+    //
+    //  vtable_key - identify the dynamic type of an object by its vtable pointer, learning each
+    //      vtable on first sight and falling back to RTTI. Itanium C++ ABI only (GCC, Clang).
+    //
+    struct vtable_key;
+
+    //  switch_dispatch - dispatch through a switch on the type's ordinal, so that the compiler can
+    //      inline handlers into the call site. The default for hierarchies of up to 8 types.
+    //
+    //  table_dispatch - dispatch through a table of function pointers. The default for larger
+    //      hierarchies, where a switch mostly adds code size.
+    //
+    struct switch_dispatch;
+    struct table_dispatch;
+
+    //  resolve_derived - dispatch an object whose type is not listed, but derives from a listed
+    //      type, as its nearest listed ancestor. Each such type is resolved through dynamic_cast
+    //      the first time it is seen and remembered, so later visits cost a lock-free lookup. The
+    //      object must contain a single base type subobject.
+    //
+    struct resolve_derived;
+
+    //  tag_accessor<&Base::kind> - identify the dynamic type of an object by a tag that the base
+    //      class already stores, instead of by RTTI. The accessor is a pointer to a data member or
+    //      a const member function of the base class, or a function taking the base class by const
+    //      reference, and yields an integer or an enum. Each concrete type's tag is given by
+    //      type_tag. Hierarchies with a tag accessor can be used with -fno-rtti.
+    //
+    template <auto Accessor> struct tag_accessor;
+
+    //  The tag of a concrete type in a hierarchy with a tag_accessor; by default its static member
+    //  `tag`. Specialize it for types that spell their tag differently.
+    //
+    template <typename Concrete, typename = void>
+    struct type_tag {};
+
+    template <typename Concrete>
+    struct type_tag<Concrete, std::enable_if_t<!std::is_member_pointer_v<decltype(&Concrete::tag)>>>
+    {
+        static constexpr auto value = Concrete::tag;
+    };
 }
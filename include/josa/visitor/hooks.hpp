@@ -0,0 +1,137 @@
+#pragma once
+#include "list.hpp"
+#include "ordinal.hpp"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace josa::visitor
+{
+    //  A visitor class deriving from enable_dispatch may name a hook policy, as
+    //
+    //      using visit_hooks = MyHooks;
+    //
+    //  to have it called around each call of one of its handlers by visit, try_visit, visit_or,
+    //  visit_all and parallel_visit_all:
+    //
+    //      struct MyHooks
+    //      {
+    //          template <typename Handler, typename Hierarchy>
+    //          static auto before(std::size_t ordinal, std::size_t depth) -> void;
+    //
+    //          template <typename Handler, typename Hierarchy>
+    //          static auto after(std::size_t ordinal, std::size_t depth) -> void;
+    //      };
+    //
+    //  ordinal is that of the concrete type of the object visited, and depth the number of hooked
+    //  visits the calling thread is already inside, so 0 for the outermost. after is also called
+    //  when the handler throws. parallel_visit_all calls them on each thread that visits, around
+    //  the calls of that thread's copy of the handler.
+    //
+    //  Only single dispatch calls hooks. A visitor naming visit_hooks fails to compile when it
+    //  derives from the enable_dispatch of two or more hierarchies.
+    //
+    namespace detail
+    {
+        template <typename F, typename = void>
+        struct handler_hooks { using type = void; };
+
+        template <typename F>
+        struct handler_hooks<F, std::void_t<typename F::visit_hooks>> { using type = typename F::visit_hooks; };
+
+        template <typename F>
+        using handler_hooks_t = typename handler_hooks<std::remove_cv_t<std::remove_reference_t<F>>>::type;
+
+        inline auto hook_depth() -> std::size_t&
+        {
+            thread_local std::size_t depth = 0;
+            return depth;
+        }
+
+        template <typename Hooks, typename Handler, typename Hierarchy>
+        class hook_scope
+        {
+        public:
+
+            explicit hook_scope(const std::size_t ordinal)
+                :   ordinal_{ordinal},
+                    depth_{hook_depth()}
+            {
+                //  Counted only once before has returned, as the destructor does not run if it throws.
+                //
+                Hooks::template before<Handler, Hierarchy>(ordinal_, depth_);
+                ++hook_depth();
+            }
+
+            hook_scope(const hook_scope&) = delete;
+            auto operator=(const hook_scope&) -> hook_scope& = delete;
+
+            ~hook_scope()
+            {
+                --hook_depth();
+                Hooks::template after<Handler, Hierarchy>(ordinal_, depth_);
+            }
+
+        private:
+
+            std::size_t ordinal_;
+            std::size_t depth_;
+        };
+
+        //  Calls a handler, a reference type F, between the hooks it names.
+        //
+        template <typename Hierarchy, typename F>
+        struct hooked_handler
+        {
+            using handler_t = std::remove_cv_t<std::remove_reference_t<F>>;
+            using concrete_types_t = typename hierarchy_traits<Hierarchy>::concrete_types_t;
+
+            F f;
+
+            template <typename T, typename... Args>
+            auto operator () (T& obj, Args&&... args) const -> decltype(std::declval<F>()(obj, std::forward<Args>(args)...))
+            {
+                constexpr auto ordinal = meta::index_of<std::remove_const_t<T>, concrete_types_t>::value;
+                const auto scope = hook_scope<handler_hooks_t<F>, handler_t, Hierarchy>{ordinal};
+
+                return f(obj, std::forward<Args>(args)...);
+            }
+        };
+
+        //  The visitor a handler stands for, in reports.
+        //
+        template <typename F>
+        struct unhooked { using type = std::decay_t<F>; };
+
+        template <typename Hierarchy, typename F>
+        struct unhooked<hooked_handler<Hierarchy, F>> { using type = std::decay_t<F>; };
+
+        template <typename F>
+        using unhooked_t = typename unhooked<std::decay_t<F>>::type;
+
+        template <typename F>
+        inline constexpr bool is_hooked_v = !std::is_same_v<std::decay_t<F>, unhooked_t<F>>;
+
+        //  The handler f stands for.
+        //
+        template <typename F>
+        auto unhook(F& f) -> decltype(auto)
+        {
+            if constexpr (is_hooked_v<F>)
+                return f.f;
+            else
+                return f;
+        }
+
+        //  The handler to dispatch to: f itself, or f wrapped in its hooks if it names any.
+        //
+        template <typename Hierarchy, typename F>
+        auto hooked(F& f) -> decltype(auto)
+        {
+            if constexpr (std::is_void_v<handler_hooks_t<F>>)
+                return f;
+            else
+                return hooked_handler<Hierarchy, F&>{f};
+        }
+    }
+}
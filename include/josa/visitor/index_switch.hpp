@@ -0,0 +1,175 @@
+#pragma once
+#include "list.hpp"
+#include <cstddef>
+#include <utility>
+
+namespace josa::visitor
+{
+    namespace detail
+    {
+        //  Number of cases in one switch statement of index_switch. Larger indices chain into further
+        //  switch statements.
+        //
+        inline constexpr std::size_t index_switch_block = 64;
+
+        //  Calls f(meta::size_constant<i>{}) for a runtime index i < N, using switch statements
+        //  rather than a table of function pointers, so that each case can be inlined into the caller.
+        //  Every case must return R.
+        //
+        //  Indices past the current block of cases are handled by the default case, which moves on to
+        //  the next block. In the last block, index N - 1 is handled after the switch, which is also
+        //  where every unused case goes, so no path falls off the end.
+        //
+        template <typename R, std::size_t N, std::size_t First = 0, typename F>
+        constexpr auto index_switch(const std::size_t i, F&& f) -> R
+        {
+            static_assert(N > 0, "index_switch requires at least one case");
+            static_assert(index_switch_block == 64, "index_switch_block must match the number of cases below");
+
+            if constexpr (First + index_switch_block < N)
+            {
+                switch (i - First)
+                {
+                    case 0:   return f(meta::size_constant<First + 0>{});
+                    case 1:   return f(meta::size_constant<First + 1>{});
+                    case 2:   return f(meta::size_constant<First + 2>{});
+                    case 3:   return f(meta::size_constant<First + 3>{});
+                    case 4:   return f(meta::size_constant<First + 4>{});
+                    case 5:   return f(meta::size_constant<First + 5>{});
+                    case 6:   return f(meta::size_constant<First + 6>{});
+                    case 7:   return f(meta::size_constant<First + 7>{});
+                    case 8:   return f(meta::size_constant<First + 8>{});
+                    case 9:   return f(meta::size_constant<First + 9>{});
+                    case 10:  return f(meta::size_constant<First + 10>{});
+                    case 11:  return f(meta::size_constant<First + 11>{});
+                    case 12:  return f(meta::size_constant<First + 12>{});
+                    case 13:  return f(meta::size_constant<First + 13>{});
+                    case 14:  return f(meta::size_constant<First + 14>{});
+                    case 15:  return f(meta::size_constant<First + 15>{});
+                    case 16:  return f(meta::size_constant<First + 16>{});
+                    case 17:  return f(meta::size_constant<First + 17>{});
+                    case 18:  return f(meta::size_constant<First + 18>{});
+                    case 19:  return f(meta::size_constant<First + 19>{});
+                    case 20:  return f(meta::size_constant<First + 20>{});
+                    case 21:  return f(meta::size_constant<First + 21>{});
+                    case 22:  return f(meta::size_constant<First + 22>{});
+                    case 23:  return f(meta::size_constant<First + 23>{});
+                    case 24:  return f(meta::size_constant<First + 24>{});
+                    case 25:  return f(meta::size_constant<First + 25>{});
+                    case 26:  return f(meta::size_constant<First + 26>{});
+                    case 27:  return f(meta::size_constant<First + 27>{});
+                    case 28:  return f(meta::size_constant<First + 28>{});
+                    case 29:  return f(meta::size_constant<First + 29>{});
+                    case 30:  return f(meta::size_constant<First + 30>{});
+                    case 31:  return f(meta::size_constant<First + 31>{});
+                    case 32:  return f(meta::size_constant<First + 32>{});
+                    case 33:  return f(meta::size_constant<First + 33>{});
+                    case 34:  return f(meta::size_constant<First + 34>{});
+                    case 35:  return f(meta::size_constant<First + 35>{});
+                    case 36:  return f(meta::size_constant<First + 36>{});
+                    case 37:  return f(meta::size_constant<First + 37>{});
+                    case 38:  return f(meta::size_constant<First + 38>{});
+                    case 39:  return f(meta::size_constant<First + 39>{});
+                    case 40:  return f(meta::size_constant<First + 40>{});
+                    case 41:  return f(meta::size_constant<First + 41>{});
+                    case 42:  return f(meta::size_constant<First + 42>{});
+                    case 43:  return f(meta::size_constant<First + 43>{});
+                    case 44:  return f(meta::size_constant<First + 44>{});
+                    case 45:  return f(meta::size_constant<First + 45>{});
+                    case 46:  return f(meta::size_constant<First + 46>{});
+                    case 47:  return f(meta::size_constant<First + 47>{});
+                    case 48:  return f(meta::size_constant<First + 48>{});
+                    case 49:  return f(meta::size_constant<First + 49>{});
+                    case 50:  return f(meta::size_constant<First + 50>{});
+                    case 51:  return f(meta::size_constant<First + 51>{});
+                    case 52:  return f(meta::size_constant<First + 52>{});
+                    case 53:  return f(meta::size_constant<First + 53>{});
+                    case 54:  return f(meta::size_constant<First + 54>{});
+                    case 55:  return f(meta::size_constant<First + 55>{});
+                    case 56:  return f(meta::size_constant<First + 56>{});
+                    case 57:  return f(meta::size_constant<First + 57>{});
+                    case 58:  return f(meta::size_constant<First + 58>{});
+                    case 59:  return f(meta::size_constant<First + 59>{});
+                    case 60:  return f(meta::size_constant<First + 60>{});
+                    case 61:  return f(meta::size_constant<First + 61>{});
+                    case 62:  return f(meta::size_constant<First + 62>{});
+                    case 63:  return f(meta::size_constant<First + 63>{});
+                    default:  return index_switch<R, N, First + index_switch_block>(i, std::forward<F>(f));
+                }
+            }
+            else
+            {
+                switch (i - First)
+                {
+                    case 0:   if constexpr (First + 0 < N - 1) return f(meta::size_constant<First + 0>{}); else break;
+                    case 1:   if constexpr (First + 1 < N - 1) return f(meta::size_constant<First + 1>{}); else break;
+                    case 2:   if constexpr (First + 2 < N - 1) return f(meta::size_constant<First + 2>{}); else break;
+                    case 3:   if constexpr (First + 3 < N - 1) return f(meta::size_constant<First + 3>{}); else break;
+                    case 4:   if constexpr (First + 4 < N - 1) return f(meta::size_constant<First + 4>{}); else break;
+                    case 5:   if constexpr (First + 5 < N - 1) return f(meta::size_constant<First + 5>{}); else break;
+                    case 6:   if constexpr (First + 6 < N - 1) return f(meta::size_constant<First + 6>{}); else break;
+                    case 7:   if constexpr (First + 7 < N - 1) return f(meta::size_constant<First + 7>{}); else break;
+                    case 8:   if constexpr (First + 8 < N - 1) return f(meta::size_constant<First + 8>{}); else break;
+                    case 9:   if constexpr (First + 9 < N - 1) return f(meta::size_constant<First + 9>{}); else break;
+                    case 10:  if constexpr (First + 10 < N - 1) return f(meta::size_constant<First + 10>{}); else break;
+                    case 11:  if constexpr (First + 11 < N - 1) return f(meta::size_constant<First + 11>{}); else break;
+                    case 12:  if constexpr (First + 12 < N - 1) return f(meta::size_constant<First + 12>{}); else break;
+                    case 13:  if constexpr (First + 13 < N - 1) return f(meta::size_constant<First + 13>{}); else break;
+                    case 14:  if constexpr (First + 14 < N - 1) return f(meta::size_constant<First + 14>{}); else break;
+                    case 15:  if constexpr (First + 15 < N - 1) return f(meta::size_constant<First + 15>{}); else break;
+                    case 16:  if constexpr (First + 16 < N - 1) return f(meta::size_constant<First + 16>{}); else break;
+                    case 17:  if constexpr (First + 17 < N - 1) return f(meta::size_constant<First + 17>{}); else break;
+                    case 18:  if constexpr (First + 18 < N - 1) return f(meta::size_constant<First + 18>{}); else break;
+                    case 19:  if constexpr (First + 19 < N - 1) return f(meta::size_constant<First + 19>{}); else break;
+                    case 20:  if constexpr (First + 20 < N - 1) return f(meta::size_constant<First + 20>{}); else break;
+                    case 21:  if constexpr (First + 21 < N - 1) return f(meta::size_constant<First + 21>{}); else break;
+                    case 22:  if constexpr (First + 22 < N - 1) return f(meta::size_constant<First + 22>{}); else break;
+                    case 23:  if constexpr (First + 23 < N - 1) return f(meta::size_constant<First + 23>{}); else break;
+                    case 24:  if constexpr (First + 24 < N - 1) return f(meta::size_constant<First + 24>{}); else break;
+                    case 25:  if constexpr (First + 25 < N - 1) return f(meta::size_constant<First + 25>{}); else break;
+                    case 26:  if constexpr (First + 26 < N - 1) return f(meta::size_constant<First + 26>{}); else break;
+                    case 27:  if constexpr (First + 27 < N - 1) return f(meta::size_constant<First + 27>{}); else break;
+                    case 28:  if constexpr (First + 28 < N - 1) return f(meta::size_constant<First + 28>{}); else break;
+                    case 29:  if constexpr (First + 29 < N - 1) return f(meta::size_constant<First + 29>{}); else break;
+                    case 30:  if constexpr (First + 30 < N - 1) return f(meta::size_constant<First + 30>{}); else break;
+                    case 31:  if constexpr (First + 31 < N - 1) return f(meta::size_constant<First + 31>{}); else break;
+                    case 32:  if constexpr (First + 32 < N - 1) return f(meta::size_constant<First + 32>{}); else break;
+                    case 33:  if constexpr (First + 33 < N - 1) return f(meta::size_constant<First + 33>{}); else break;
+                    case 34:  if constexpr (First + 34 < N - 1) return f(meta::size_constant<First + 34>{}); else break;
+                    case 35:  if constexpr (First + 35 < N - 1) return f(meta::size_constant<First + 35>{}); else break;
+                    case 36:  if constexpr (First + 36 < N - 1) return f(meta::size_constant<First + 36>{}); else break;
+                    case 37:  if constexpr (First + 37 < N - 1) return f(meta::size_constant<First + 37>{}); else break;
+                    case 38:  if constexpr (First + 38 < N - 1) return f(meta::size_constant<First + 38>{}); else break;
+                    case 39:  if constexpr (First + 39 < N - 1) return f(meta::size_constant<First + 39>{}); else break;
+                    case 40:  if constexpr (First + 40 < N - 1) return f(meta::size_constant<First + 40>{}); else break;
+                    case 41:  if constexpr (First + 41 < N - 1) return f(meta::size_constant<First + 41>{}); else break;
+                    case 42:  if constexpr (First + 42 < N - 1) return f(meta::size_constant<First + 42>{}); else break;
+                    case 43:  if constexpr (First + 43 < N - 1) return f(meta::size_constant<First + 43>{}); else break;
+                    case 44:  if constexpr (First + 44 < N - 1) return f(meta::size_constant<First + 44>{}); else break;
+                    case 45:  if constexpr (First + 45 < N - 1) return f(meta::size_constant<First + 45>{}); else break;
+                    case 46:  if constexpr (First + 46 < N - 1) return f(meta::size_constant<First + 46>{}); else break;
+                    case 47:  if constexpr (First + 47 < N - 1) return f(meta::size_constant<First + 47>{}); else break;
+                    case 48:  if constexpr (First + 48 < N - 1) return f(meta::size_constant<First + 48>{}); else break;
+                    case 49:  if constexpr (First + 49 < N - 1) return f(meta::size_constant<First + 49>{}); else break;
+                    case 50:  if constexpr (First + 50 < N - 1) return f(meta::size_constant<First + 50>{}); else break;
+                    case 51:  if constexpr (First + 51 < N - 1) return f(meta::size_constant<First + 51>{}); else break;
+                    case 52:  if constexpr (First + 52 < N - 1) return f(meta::size_constant<First + 52>{}); else break;
+                    case 53:  if constexpr (First + 53 < N - 1) return f(meta::size_constant<First + 53>{}); else break;
+                    case 54:  if constexpr (First + 54 < N - 1) return f(meta::size_constant<First + 54>{}); else break;
+                    case 55:  if constexpr (First + 55 < N - 1) return f(meta::size_constant<First + 55>{}); else break;
+                    case 56:  if constexpr (First + 56 < N - 1) return f(meta::size_constant<First + 56>{}); else break;
+                    case 57:  if constexpr (First + 57 < N - 1) return f(meta::size_constant<First + 57>{}); else break;
+                    case 58:  if constexpr (First + 58 < N - 1) return f(meta::size_constant<First + 58>{}); else break;
+                    case 59:  if constexpr (First + 59 < N - 1) return f(meta::size_constant<First + 59>{}); else break;
+                    case 60:  if constexpr (First + 60 < N - 1) return f(meta::size_constant<First + 60>{}); else break;
+                    case 61:  if constexpr (First + 61 < N - 1) return f(meta::size_constant<First + 61>{}); else break;
+                    case 62:  if constexpr (First + 62 < N - 1) return f(meta::size_constant<First + 62>{}); else break;
+                    case 63:  if constexpr (First + 63 < N - 1) return f(meta::size_constant<First + 63>{}); else break;
+                    default:  break;
+                }
+
+                return f(meta::size_constant<N - 1>{});
+            }
+        }
+    }
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include "ordinal.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+
+namespace josa::visitor
+{
+    namespace detail
+    {
+        //  A small, most-recently-used list of the types last looked up for one hierarchy, each kept
+        //  with its ordinal under the type_info address that was looked up, so that a type_info
+        //  emitted by another shared object hits as well. A version counter, odd while the ways are
+        //  being updated, keeps readers from using a torn (type, ordinal) pair; a writer that finds
+        //  another one updating skips its update.
+        //
+        //  The counters are kept on a line of their own, so that counting a hit does not take the
+        //  ways' line away from other threads reading it.
+        //
+        template <typename Hierarchy, std::size_t Ways>
+        class inline_cache_line
+        {
+            static_assert(Ways > 0, "an inline cache needs at least one way");
+
+            using ordinal_t = type_ordinal<Hierarchy>;
+
+            struct way
+            {
+                std::atomic<const std::type_info*> type{nullptr};
+                std::atomic<std::size_t> ordinal{npos};
+            };
+
+            struct counters
+            {
+                std::atomic<std::size_t> hits{0};
+                std::atomic<std::size_t> misses{0};
+            };
+
+        public:
+
+#if JOSA_VISITOR_RTTI
+            auto ordinal_of(const typename hierarchy_traits<Hierarchy>::base_t& obj) -> std::size_t
+            {
+                return ordinal_of(typeid(obj), obj);
+            }
+
+            //  The ordinal of obj, whose dynamic type is described by type.
+            //
+            auto ordinal_of(const std::type_info& type, const typename hierarchy_traits<Hierarchy>::base_t& obj) -> std::size_t
+            {
+                const auto version = version_.load(std::memory_order_acquire);
+
+                for (auto& w : ways_)
+                {
+                    if (w.type.load(std::memory_order_relaxed) == &type)
+                    {
+                        const auto ordinal = w.ordinal.load(std::memory_order_relaxed);
+                        std::atomic_thread_fence(std::memory_order_acquire);
+
+                        if (version % 2 == 0 && version_.load(std::memory_order_relaxed) == version)
+                        {
+                            count(counters_.value.hits);
+                            return ordinal;
+                        }
+
+                        break;
+                    }
+                }
+
+                count(counters_.value.misses);
+
+                const auto p = ordinal_t::find(type, &obj);
+
+                if (!p)
+                    return npos;
+
+                remember(type, p->ordinal);
+
+                return p->ordinal;
+            }
+#endif
+
+            auto hits() const -> std::size_t { return counters_.value.hits.load(std::memory_order_relaxed); }
+            auto misses() const -> std::size_t { return counters_.value.misses.load(std::memory_order_relaxed); }
+
+        private:
+
+            //  The counters are statistics only: a plain load and store keeps a hit free of locked
+            //  instructions, at the cost of occasionally losing an increment when threads race.
+            //
+            static auto count(std::atomic<std::size_t>& counter) -> void
+            {
+                counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+
+            auto remember(const std::type_info& type, const std::size_t ordinal) -> void
+            {
+                auto version = version_.load(std::memory_order_relaxed);
+
+                if (version % 2 != 0 || !version_.compare_exchange_strong(version, version + 1, std::memory_order_relaxed))
+                    return;
+
+                std::atomic_thread_fence(std::memory_order_release);
+
+                for (auto i = Ways - 1; i > 0; --i)
+                {
+                    ways_[i].type.store(ways_[i - 1].type.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    ways_[i].ordinal.store(ways_[i - 1].ordinal.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+
+                ways_[0].type.store(&type, std::memory_order_relaxed);
+                ways_[0].ordinal.store(ordinal, std::memory_order_relaxed);
+
+                version_.store(version + 2, std::memory_order_release);
+            }
+
+            std::atomic<std::size_t> version_{0};
+            std::array<way, Ways> ways_{};
+            padded<counters> counters_{};
+        };
+
+        //  Hierarchies with a tag_accessor look up the tag instead, so their line is empty.
+        //
+        struct tag_cache_line
+        {
+            auto hits() const -> std::size_t { return 0; }
+            auto misses() const -> std::size_t { return 0; }
+        };
+
+        template <typename Hierarchy, std::size_t Ways>
+        using cache_line_t = std::conditional_t<hierarchy_traits<Hierarchy>::tag_dispatch,
+            tag_cache_line, inline_cache_line<Hierarchy, Ways>>;
+    }
+
+    //  A per-call-site cache of recently visited types, checked before the hierarchy's full type
+    //  lookup. Declare one (usually static) at a call site that tends to see the same few types in
+    //  long runs, and pass it as the first argument of visit or match. For double dispatch there is
+    //  one cache line per hierarchy.
+    //
+    template <std::size_t Ways, typename... Hierarchies>
+    class basic_inline_cache
+    {
+    public:
+
+        static constexpr std::size_t ways = Ways;
+
+        template <std::size_t I, typename Obj>
+        auto ordinal_of(const Obj& obj) -> std::size_t
+        {
+            using hierarchy_t = meta::at_t<I, meta::list<Hierarchies...>>;
+
+            //  Reading a tag is cheaper than any cache.
+            //
+            if constexpr (detail::hierarchy_traits<hierarchy_t>::tag_dispatch)
+                return detail::tag_ordinal<hierarchy_t>::of(obj);
+#if JOSA_VISITOR_RTTI
+            else
+                return std::get<I>(lines_).ordinal_of(obj);
+#endif
+        }
+
+        //  Number of lookups answered (or not) by the cache, summed over all hierarchies. Counts are
+        //  approximate when the cache is shared between threads.
+        //
+        auto hits() const -> std::size_t
+        {
+            return std::apply([](const auto&... line) { return (std::size_t{0} + ... + line.hits()); }, lines_);
+        }
+
+        auto misses() const -> std::size_t
+        {
+            return std::apply([](const auto&... line) { return (std::size_t{0} + ... + line.misses()); }, lines_);
+        }
+
+        auto hit_rate() const -> double
+        {
+            const auto total = hits() + misses();
+            return total ? static_cast<double>(hits()) / static_cast<double>(total) : 0.0;
+        }
+
+    private:
+
+        std::tuple<detail::cache_line_t<Hierarchies, Ways>...> lines_;
+    };
+
+    //  Caches a single type per hierarchy.
+    //
+    template <typename... Hierarchies>
+    using monomorphic_cache = basic_inline_cache<1, Hierarchies...>;
+
+    //  Caches the four most recently seen types per hierarchy.
+    //
+    template <typename... Hierarchies>
+    using inline_cache = basic_inline_cache<4, Hierarchies...>;
+}
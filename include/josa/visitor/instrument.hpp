@@ -0,0 +1,385 @@
+#pragma once
+#include "list.hpp"
+#include "ordinal.hpp"
+#include "parallel.hpp"
+#include "table_stats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//  Whether dispatchers, and the visitor classes built on them, count the objects they visit by
+//  visitor and concrete type, count objects of unhandled types, and time a sample of type lookups.
+//  Each object of a double or multiple dispatch is counted under its own hierarchy; the pairs of
+//  visit_pairs are not counted. Off by default, when the dispatchers contain no instrumentation at all and snapshots
+//  are empty. It must have the same value in every translation unit of a program.
+//
+#if !defined(JOSA_VISITOR_INSTRUMENT)
+#   define JOSA_VISITOR_INSTRUMENT 0
+#endif
+
+//  Each thread times one in this many of its type lookups.
+//
+#if !defined(JOSA_VISITOR_INSTRUMENT_SAMPLE_PERIOD)
+#   define JOSA_VISITOR_INSTRUMENT_SAMPLE_PERIOD 1024
+#endif
+
+namespace josa::visitor
+{
+    //  What one visitor type has visited through one hierarchy, summed over threads. calls has one
+    //  count per concrete type, in the order of types; misses counts objects of unhandled types,
+    //  whether they threw or were passed to a fallback. Lookup times are those of the sampled
+    //  lookups. tables describes the tables behind the dispatcher, shared by all its visitors.
+    //
+    struct visitor_stats
+    {
+        std::string visitor;
+        std::string hierarchy;
+        std::vector<std::string> types;
+        std::vector<std::uint64_t> calls;
+        std::uint64_t misses = 0;
+        std::uint64_t lookup_samples = 0;
+        std::uint64_t lookup_nanoseconds = 0;
+        std::uint64_t lookup_nanoseconds_max = 0;
+        table_stats tables;
+    };
+
+    struct dispatch_snapshot
+    {
+        std::vector<visitor_stats> visitors;
+    };
+
+    namespace detail
+    {
+        //  The name of a type, for reports, without RTTI where the compiler can give it.
+        //
+        template <typename T>
+        auto type_name() -> std::string
+        {
+#if defined(__clang__) || defined(__GNUC__)
+            const auto signature = std::string_view{__PRETTY_FUNCTION__};
+            const auto begin = signature.find("T = ") + 4;
+            const auto end = std::min(signature.find(';', begin), signature.rfind(']'));
+
+            return std::string{signature.substr(begin, end - begin)};
+#elif defined(_MSC_VER)
+            const auto signature = std::string_view{__FUNCSIG__};
+            const auto begin = signature.find("type_name<") + 10;
+            const auto end = signature.rfind(">(void)");
+
+            return std::string{signature.substr(begin, end - begin)};
+#elif JOSA_VISITOR_RTTI
+            return typeid(T).name();
+#else
+            return {};
+#endif
+        }
+
+        template <typename TL> struct type_names;
+
+        template <typename... Ts>
+        struct type_names<meta::list<Ts...>>
+        {
+            static auto get() -> std::vector<std::string> { return {type_name<Ts>()...}; }
+        };
+
+        //  Counters are sharded by thread, so that threads visiting with the same visitor update
+        //  different cache lines unless there are more threads than shards.
+        //
+        inline constexpr std::size_t instrument_shards = 16;
+
+        inline auto instrument_shard() -> std::size_t
+        {
+            static auto next = std::atomic<std::size_t>{0};
+            thread_local const auto shard = next.fetch_add(1, std::memory_order_relaxed) % instrument_shards;
+
+            return shard;
+        }
+
+        inline auto instrument_sample_due() -> bool
+        {
+            thread_local std::uint32_t countdown = JOSA_VISITOR_INSTRUMENT_SAMPLE_PERIOD;
+
+            if (--countdown != 0)
+                return false;
+
+            countdown = JOSA_VISITOR_INSTRUMENT_SAMPLE_PERIOD;
+            return true;
+        }
+
+        //  Every instrumented (hierarchy, visitor) pair in the program, added during static
+        //  initialization.
+        //
+        struct instrument_list
+        {
+            std::mutex mutex;
+            std::vector<auto (*)() -> visitor_stats> snapshots;
+
+            static auto get() -> instrument_list&
+            {
+                static auto list = instrument_list{};
+                return list;
+            }
+        };
+
+        template <typename Hierarchy, typename Visitor>
+        struct instrument
+        {
+            using traits_t = hierarchy_traits<Hierarchy>;
+
+            struct shard
+            {
+                std::atomic<std::uint64_t> calls[traits_t::size];
+                std::atomic<std::uint64_t> misses;
+                std::atomic<std::uint64_t> lookup_samples;
+                std::atomic<std::uint64_t> lookup_nanoseconds;
+                std::atomic<std::uint64_t> lookup_nanoseconds_max;
+            };
+
+            //  Zero-initialized, being static.
+            //
+            inline static padded<shard> shards[instrument_shards];
+
+            //  Counts the ordinal found by find(), which is timed if a sample is due.
+            //
+            template <typename Find>
+            static auto lookup(Find&& find) -> std::size_t
+            {
+                auto& s = shards[instrument_shard()].value;
+
+                if (!instrument_sample_due())
+                    return count(s, find());
+
+                const auto start = std::chrono::steady_clock::now();
+                const auto i = find();
+                const auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+
+                s.lookup_samples.fetch_add(1, std::memory_order_relaxed);
+                s.lookup_nanoseconds.fetch_add(ns, std::memory_order_relaxed);
+
+                auto max = s.lookup_nanoseconds_max.load(std::memory_order_relaxed);
+                while (ns > max && !s.lookup_nanoseconds_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+
+                return count(s, i);
+            }
+
+            //  Counts an ordinal that needed no lookup.
+            //
+            static auto count(const std::size_t i) -> void
+            {
+                count(shards[instrument_shard()].value, i);
+            }
+
+            //  Counts a chunk of a batch visit, given the number of its objects of each concrete
+            //  type.
+            //
+            static auto count_chunk(const std::size_t* counts) -> void
+            {
+                static_cast<void>(&registered);
+
+                auto& s = shards[instrument_shard()].value;
+
+                for (std::size_t i = 0; i < traits_t::size; ++i)
+                {
+                    if (counts[i] != 0)
+                        s.calls[i].fetch_add(counts[i], std::memory_order_relaxed);
+                }
+            }
+
+            static auto snapshot() -> visitor_stats
+            {
+                auto stats = visitor_stats{};
+
+                stats.visitor = type_name<Visitor>();
+                stats.hierarchy = type_name<typename traits_t::base_t>();
+                stats.types = type_names<typename traits_t::concrete_types_t>::get();
+                stats.calls.resize(traits_t::size);
+                stats.tables = table_usage<Hierarchy>();
+
+                for (const auto& padded_shard : shards)
+                {
+                    const auto& s = padded_shard.value;
+
+                    for (std::size_t i = 0; i < traits_t::size; ++i)
+                        stats.calls[i] += s.calls[i].load(std::memory_order_relaxed);
+
+                    stats.misses += s.misses.load(std::memory_order_relaxed);
+                    stats.lookup_samples += s.lookup_samples.load(std::memory_order_relaxed);
+                    stats.lookup_nanoseconds += s.lookup_nanoseconds.load(std::memory_order_relaxed);
+                    stats.lookup_nanoseconds_max = std::max(stats.lookup_nanoseconds_max, s.lookup_nanoseconds_max.load(std::memory_order_relaxed));
+                }
+
+                return stats;
+            }
+
+        private:
+
+            inline static const bool registered = [] {
+                auto& list = instrument_list::get();
+                const auto lock = std::lock_guard{list.mutex};
+                list.snapshots.push_back(&snapshot);
+                return true;
+            }();
+
+            static auto count(shard& s, const std::size_t i) -> std::size_t
+            {
+                //  Registers this pair wherever it counts anything.
+                //
+                static_cast<void>(&registered);
+
+                if (i < traits_t::size)
+                    s.calls[i].fetch_add(1, std::memory_order_relaxed);
+                else
+                    s.misses.fetch_add(1, std::memory_order_relaxed);
+
+                return i;
+            }
+        };
+
+        //  Escapes a string for a JSON string or a Prometheus label value. A newline is written as
+        //  \n, which both formats read; any other control character as \u00XX, which JSON requires.
+        //
+        inline auto append_escaped(std::string& out, const std::string& s) -> void
+        {
+            constexpr auto hex = std::string_view{"0123456789abcdef"};
+
+            for (const char c : s)
+            {
+                const auto u = static_cast<unsigned char>(c);
+
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if (c == '\n')
+                {
+                    out += "\\n";
+                }
+                else if (u < 0x20)
+                {
+                    out += "\\u00";
+                    out += hex[u >> 4];
+                    out += hex[u & 0xf];
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+
+        inline auto append_labels(std::string& out, const visitor_stats& v) -> void
+        {
+            out += "{visitor=\"";
+            append_escaped(out, v.visitor);
+            out += "\",hierarchy=\"";
+            append_escaped(out, v.hierarchy);
+            out += '"';
+        }
+    }
+
+    //  The counts of every visitor whose dispatch the program instantiates, in no particular order.
+    //  Empty unless JOSA_VISITOR_INSTRUMENT is set. Counts are read without stopping visits, so a
+    //  snapshot taken while other threads visit is not of a single instant.
+    //
+    inline auto instrumentation_snapshot() -> dispatch_snapshot
+    {
+        auto snapshot = dispatch_snapshot{};
+        auto& list = detail::instrument_list::get();
+        const auto lock = std::lock_guard{list.mutex};
+
+        for (const auto get : list.snapshots)
+            snapshot.visitors.push_back(get());
+
+        return snapshot;
+    }
+
+    inline auto to_json(const dispatch_snapshot& snapshot) -> std::string
+    {
+        auto out = std::string{"{\"visitors\":["};
+
+        for (const auto& v : snapshot.visitors)
+        {
+            out += &v == snapshot.visitors.data() ? "{\"visitor\":\"" : ",{\"visitor\":\"";
+            detail::append_escaped(out, v.visitor);
+            out += "\",\"hierarchy\":\"";
+            detail::append_escaped(out, v.hierarchy);
+            out += "\",\"calls\":{";
+
+            for (std::size_t i = 0; i < v.types.size(); ++i)
+            {
+                out += i == 0 ? "\"" : ",\"";
+                detail::append_escaped(out, v.types[i]);
+                out += "\":" + std::to_string(v.calls[i]);
+            }
+
+            out += "},\"misses\":" + std::to_string(v.misses);
+            out += ",\"lookup_samples\":" + std::to_string(v.lookup_samples);
+            out += ",\"lookup_nanoseconds\":" + std::to_string(v.lookup_nanoseconds);
+            out += ",\"lookup_nanoseconds_max\":" + std::to_string(v.lookup_nanoseconds_max);
+            out += ",\"lookup_table_bytes\":" + std::to_string(v.tables.lookup_bytes);
+            out += ",\"dispatch_tables\":" + std::to_string(v.tables.dispatch_tables);
+            out += ",\"dispatch_table_bytes\":" + std::to_string(v.tables.dispatch_table_bytes) + "}";
+        }
+
+        return out + "]}\n";
+    }
+
+    //  In the Prometheus text exposition format, labelled by visitor and hierarchy, and by concrete
+    //  type for the visit counts.
+    //
+    inline auto to_prometheus(const dispatch_snapshot& snapshot) -> std::string
+    {
+        auto out = std::string{};
+
+        const auto metric = [&](const char* name, const char* type, const char* help, auto&& value) {
+            out += std::string{"# HELP "} + name + ' ' + help + "\n# TYPE " + name + ' ' + type + '\n';
+
+            for (const auto& v : snapshot.visitors)
+            {
+                out += name;
+                detail::append_labels(out, v);
+                out += "} " + std::to_string(value(v)) + '\n';
+            }
+        };
+
+        out += "# HELP josa_visitor_calls_total Objects visited, by visitor and concrete type.\n"
+               "# TYPE josa_visitor_calls_total counter\n";
+
+        for (const auto& v : snapshot.visitors)
+        {
+            for (std::size_t i = 0; i < v.types.size(); ++i)
+            {
+                out += "josa_visitor_calls_total";
+                detail::append_labels(out, v);
+                out += ",type=\"";
+                detail::append_escaped(out, v.types[i]);
+                out += "\"} " + std::to_string(v.calls[i]) + '\n';
+            }
+        }
+
+        metric("josa_visitor_unhandled_total", "counter", "Objects of unhandled types.",
+            [](const visitor_stats& v) { return v.misses; });
+        metric("josa_visitor_lookup_samples_total", "counter", "Type lookups timed.",
+            [](const visitor_stats& v) { return v.lookup_samples; });
+        metric("josa_visitor_lookup_nanoseconds_total", "counter", "Time spent in the type lookups timed.",
+            [](const visitor_stats& v) { return v.lookup_nanoseconds; });
+        metric("josa_visitor_lookup_nanoseconds_max", "gauge", "Longest type lookup timed.",
+            [](const visitor_stats& v) { return v.lookup_nanoseconds_max; });
+        metric("josa_visitor_lookup_table_bytes", "gauge", "Bytes of the type lookup tables of the hierarchy.",
+            [](const visitor_stats& v) { return v.tables.lookup_bytes; });
+        metric("josa_visitor_dispatch_tables", "gauge", "Dispatch tables of the dispatcher.",
+            [](const visitor_stats& v) { return v.tables.dispatch_tables; });
+        metric("josa_visitor_dispatch_table_bytes", "gauge", "Bytes of the dispatch tables of the dispatcher.",
+            [](const visitor_stats& v) { return v.tables.dispatch_table_bytes; });
+
+        return out;
+    }
+}
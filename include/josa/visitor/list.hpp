@@ -14,6 +14,116 @@ using bool_constant = std::integral_constant<bool, B>;
 
 template <typename> struct always_false : std::false_type {};
 
+//--------------------------------------------------------------------------------------------------
+//  The algorithms below avoid recursing over the elements of a list, which costs an instantiation
+//  per element and makes element access O(N) deep: predicates are evaluated into a constexpr
+//  array, and elements are selected by index, through __type_pack_element where the compiler has
+//  it, and otherwise by overload resolution against a class that inherits one base per element.
+//  Large hierarchies make lists of tens of thousands of pairs of types, so they also avoid fold
+//  expressions over lists, which some compilers limit to 256 operands.
+//--------------------------------------------------------------------------------------------------
+
+#if defined(__has_builtin)
+#   if __has_builtin(__type_pack_element)
+#       define JOSA_VISITOR_TYPE_PACK_ELEMENT 1
+#   endif
+#endif
+
+namespace detail {
+
+//  The position of the first true flag, or N - 1 if there is none. Flags end with an extra false,
+//  so that empty packs do not make empty arrays.
+//
+template <std::size_t N>
+constexpr auto find_true(const bool (&flags)[N]) -> std::size_t
+{
+    auto i = std::size_t{0};
+
+    while (i < N - 1 && !flags[i])
+        ++i;
+
+    return i;
+}
+
+template <std::size_t N>
+constexpr auto count_true(const bool (&flags)[N]) -> std::size_t
+{
+    auto n = std::size_t{0};
+
+    for (std::size_t i = 0; i < N; ++i)
+        n += flags[i];
+
+    return n;
+}
+
+template <typename T, typename... Ts>
+constexpr auto find_type() -> std::size_t
+{
+    return find_true({std::is_same_v<T, Ts>..., false});
+}
+
+//  type_at_t<I, Ts...> is the I-th of Ts.
+//
+#if defined(JOSA_VISITOR_TYPE_PACK_ELEMENT)
+
+template <std::size_t I, typename... Ts>
+using type_at_t = __type_pack_element<I, Ts...>;
+
+#else
+
+template <std::size_t I, typename T> struct element { using type = T; };
+
+template <typename IS, typename... Ts> struct elements;
+
+template <std::size_t... Is, typename... Ts>
+struct elements<std::index_sequence<Is...>, Ts...> : element<Is, Ts>... {};
+
+template <std::size_t I, typename T>
+auto element_at(const element<I, T>&) -> element<I, T>;
+
+template <std::size_t I, typename... Ts>
+using type_at_t = typename decltype(element_at<I>(std::declval<elements<std::index_sequence_for<Ts...>, Ts...>>()))::type;
+
+#endif
+
+//  The positions of the true flags, of which there are size. Flags end with an extra false.
+//
+template <std::size_t N>
+struct selection
+{
+    std::size_t index[N] = {};
+    std::size_t size = 0;
+};
+
+template <std::size_t N>
+constexpr auto select_true(const bool (&flags)[N]) -> selection<N>
+{
+    auto s = selection<N>{};
+
+    for (std::size_t i = 0; i < N - 1; ++i)
+    {
+        if (flags[i])
+            s.index[s.size++] = i;
+    }
+
+    return s;
+}
+
+//  The list of the elements of Ts at the positions Selection::value selects.
+//
+template <typename Selection, typename IS, typename... Ts> struct select_types;
+
+template <typename Selection, std::size_t... Ks, typename... Ts>
+struct select_types<Selection, std::index_sequence<Ks...>, Ts...>
+{
+    using type = list<type_at_t<Selection::value.index[Ks], Ts...>...>;
+};
+
+template <typename Selection, typename... Ts>
+using select_types_t = typename select_types<Selection, std::make_index_sequence<Selection::value.size>, Ts...>::type;
+
+} // namespace detail
+
 //--------------------------------------------------------------------------------------------------
 //  size - get the number of elements in a list
 //--------------------------------------------------------------------------------------------------
@@ -39,14 +149,8 @@ template <typename Hd, typename... Tl> struct empty<list<Hd, Tl...>> : std::fals
 
 template <typename T, typename List> struct contains;
 
-template <typename T> struct contains<T, list<>>
-    :   std::false_type {};
-
-template <typename T, typename... Tl> struct contains<T, list<T, Tl...>>
-    :   std::true_type {};
-
-template <typename T, typename Hd, typename... Tl> struct contains<T, list<Hd, Tl...>>
-    :   contains<T, list<Tl...>> {};
+template <typename T, typename... Ts> struct contains<T, list<Ts...>>
+    :   bool_constant<detail::find_type<T, Ts...>() < sizeof...(Ts)> {};
 
 //--------------------------------------------------------------------------------------------------
 //  count - count the number of times a specified type occurs in a list.
@@ -54,14 +158,8 @@ template <typename T, typename Hd, typename... Tl> struct contains<T, list<Hd, T
 
 template <typename T, typename List> struct count;
 
-template <typename T> struct count<T, list<>>
-    :   size_constant<0> {};
-
-template <typename T, typename... Tl> struct count<T, list<T, Tl...>>
-    :   size_constant<1 + count<T, list<Tl...>>::value> {};
-
-template <typename T, typename Hd, typename... Tl> struct count<T, list<Hd, Tl...>>
-    :   count<T, list<Tl...>> {};
+template <typename T, typename... Ts> struct count<T, list<Ts...>>
+    :   size_constant<detail::count_true({std::is_same_v<T, Ts>..., false})> {};
 
 //--------------------------------------------------------------------------------------------------
 //  all_unique - determine if the list contains only unique types, i.e. there are no duplicates.
@@ -69,11 +167,22 @@ template <typename T, typename Hd, typename... Tl> struct count<T, list<Hd, Tl..
 
 template <typename List> struct all_unique;
 
-template <> struct all_unique<list<>>
-    :   std::true_type {};
+namespace detail {
+
+//  Flags each element that is the first of its type.
+//
+template <typename IS, typename... Ts> struct first_occurrences;
+
+template <std::size_t... Is, typename... Ts>
+struct first_occurrences<std::index_sequence<Is...>, Ts...>
+{
+    static constexpr bool flags[] = {(find_type<Ts, Ts...>() == Is)..., false};
+};
+
+} // namespace detail
 
-template <typename Hd, typename... Tl> struct all_unique<list<Hd, Tl...>>
-    :   bool_constant<!contains<Hd, list<Tl...>>::value && all_unique<list<Tl...>>::value> {};
+template <typename... Ts> struct all_unique<list<Ts...>>
+    :   bool_constant<detail::count_true(detail::first_occurrences<std::index_sequence_for<Ts...>, Ts...>::flags) == sizeof...(Ts)> {};
 
 //--------------------------------------------------------------------------------------------------
 //  convert - given a list<Ts...> create a Type<Ts...>, for some specified Type.
@@ -97,13 +206,9 @@ using convert_t = typename convert<List, Type>::type;
 
 template <typename List, template <typename> class Predicate> struct each_of;
 
-template <template <typename> class Predicate>
-struct each_of<list<>, Predicate>
-    :   std::true_type {};
-
-template <typename Hd, typename... Tl, template <typename> class Predicate>
-struct each_of<list<Hd, Tl...>, Predicate>
-    :   bool_constant<Predicate<Hd>::value && each_of<list<Tl...>, Predicate>::value> {};
+template <typename... Ts, template <typename> class Predicate>
+struct each_of<list<Ts...>, Predicate>
+    :   bool_constant<detail::count_true({static_cast<bool>(Predicate<Ts>::value)..., false}) == sizeof...(Ts)> {};
 
 //--------------------------------------------------------------------------------------------------
 //  any_of - determine whether at least one type T in a list, the predicate Predicate<T>::value is
@@ -112,13 +217,9 @@ struct each_of<list<Hd, Tl...>, Predicate>
 
 template <typename List, template <typename> class Predicate> struct any_of;
 
-template <template <typename> class Predicate>
-struct any_of<list<>, Predicate>
-    :   std::false_type {};
-
-template <typename Hd, typename... Tl, template <typename> class Predicate>
-struct any_of<list<Hd, Tl...>, Predicate>
-    :   bool_constant<Predicate<Hd>::value || any_of<list<Tl...>, Predicate>::value> {};
+template <typename... Ts, template <typename> class Predicate>
+struct any_of<list<Ts...>, Predicate>
+    :   bool_constant<detail::count_true({static_cast<bool>(Predicate<Ts>::value)..., false}) != 0> {};
 
 //--------------------------------------------------------------------------------------------------
 //  prepend - creates a list by prepending a type to an existing list.
@@ -158,19 +259,11 @@ template <typename T, typename List> struct remove;
 template <typename T, typename List>
 using remove_t = typename remove<T, List>::type;
 
-template <typename T> struct remove<T, list<>>
-{
-    using type = list<>;
-};
-
-template <typename T, typename... Tl> struct remove<T, list<T, Tl...>>
+template <typename T, typename... Ts> struct remove<T, list<Ts...>>
 {
-    using type = remove_t<T, list<Tl...>>;
-};
+    struct kept { static constexpr auto value = detail::select_true({!std::is_same_v<T, Ts>..., false}); };
 
-template <typename T, typename Hd, typename... Tl> struct remove<T, list<Hd, Tl...>>
-{
-    using type = prepend_t<Hd, remove_t<T, list<Tl...>>>;
+    using type = detail::select_types_t<kept, Ts...>;
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -213,14 +306,11 @@ template <typename List> struct uniques;
 
 template <typename List> using uniques_t = typename uniques<List>::type;
 
-template <> struct uniques<list<>>
+template <typename... Ts> struct uniques<list<Ts...>>
 {
-    using type = list<>;
-};
+    struct kept { static constexpr auto value = detail::select_true(detail::first_occurrences<std::index_sequence_for<Ts...>, Ts...>::flags); };
 
-template <typename Hd, typename... Tl> struct uniques<list<Hd, Tl...>>
-{
-    using type = prepend_t<Hd, remove_t<Hd, list<Tl...>>>;
+    using type = detail::select_types_t<kept, Ts...>;
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -242,6 +332,21 @@ template <typename... Ts> struct concat<list<Ts...>>
     using type = list<Ts...>;
 };
 
+template <typename... Ts, typename... Us>
+struct concat<list<Ts...>, list<Us...>>
+{
+    using type = list<Ts..., Us...>;
+};
+
+//  Eight lists at a time, so that concatenating N lists takes N / 7 steps rather than N.
+//
+template <typename... T1, typename... T2, typename... T3, typename... T4,
+    typename... T5, typename... T6, typename... T7, typename... T8, typename... Lists>
+struct concat<list<T1...>, list<T2...>, list<T3...>, list<T4...>, list<T5...>, list<T6...>, list<T7...>, list<T8...>, Lists...>
+{
+    using type = concat_t<list<T1..., T2..., T3..., T4..., T5..., T6..., T7..., T8...>, Lists...>;
+};
+
 template <typename... Ts, typename... Us, typename... Lists>
 struct concat<list<Ts...>, list<Us...>, Lists...>
 {
@@ -254,19 +359,13 @@ struct concat<list<Ts...>, list<Us...>, Lists...>
 
 template <typename T, typename List> struct index_of;
 
-template <typename T> struct index_of<T, list<>>
+template <typename T, typename... Ts>
+struct index_of<T, list<Ts...>>
+    :   size_constant<detail::find_type<T, Ts...>()>
 {
-    static_assert(always_false<T>::value, "list does not contain any elements of type T");
+    static_assert(detail::find_type<T, Ts...>() < sizeof...(Ts), "list does not contain any elements of type T");
 };
 
-template <typename T, typename... Tl>
-struct index_of<T, list<T, Tl...>>
-    :   size_constant<0> {};
-
-template <typename T, typename Hd, typename... Tl>
-struct index_of<T, list<Hd, Tl...>>
-    :   size_constant<1 + index_of<T, list<Tl...>>::value> {};
-
 //--------------------------------------------------------------------------------------------------
 //  at - gets the type at a specified index
 //--------------------------------------------------------------------------------------------------
@@ -276,20 +375,30 @@ template <std::size_t Index, typename List> struct at;
 template <std::size_t Index, typename List>
 using at_t = typename at<Index,List>::type;
 
-template <> struct at<0, list<>>;
-
-template <typename Hd, typename... Tl>
-struct at<0, list<Hd, Tl...>>
+template <std::size_t Index, typename... Ts>
+struct at<Index, list<Ts...>>
 {
-    using type = Hd;
-};
+    static_assert(Index < sizeof...(Ts), "index out of range");
 
-template <std::size_t Index, typename Hd, typename... Tl>
-struct at<Index, list<Hd, Tl...>>
-{
-    using type = at_t<Index - 1, list<Tl...>>;
+    using type = detail::type_at_t<Index, Ts...>;
 };
 
+#if !defined(JOSA_VISITOR_TYPE_PACK_ELEMENT)
+
+//  The first elements, which pairs of types and short lists mostly ask for, are matched directly,
+//  as that is cheaper than building the class of elements.
+//
+template <typename T0, typename... Ts>
+struct at<0, list<T0, Ts...>> { using type = T0; };
+
+template <typename T0, typename T1, typename... Ts>
+struct at<1, list<T0, T1, Ts...>> { using type = T1; };
+
+template <typename T0, typename T1, typename T2, typename... Ts>
+struct at<2, list<T0, T1, T2, Ts...>> { using type = T2; };
+
+#endif
+
 //--------------------------------------------------------------------------------------------------
 //  div_at - gets the type at a specified index divided by a given divisor
 //--------------------------------------------------------------------------------------------------
@@ -357,15 +466,22 @@ template <typename List> struct reverse;
 
 template <typename List> using reverse_t = typename reverse<List>::type;
 
-template <> struct reverse<list<>>
+namespace detail {
+
+template <typename IS, typename... Ts> struct reverse_helper;
+
+template <std::size_t... Is, typename... Ts>
+struct reverse_helper<std::index_sequence<Is...>, Ts...>
 {
-    using type = list<>;
+    using type = list<type_at_t<sizeof...(Ts) - 1 - Is, Ts...>...>;
 };
 
-template <typename Hd, typename... Tl>
-struct reverse<list<Hd, Tl...>>
+} // namespace detail
+
+template <typename... Ts>
+struct reverse<list<Ts...>>
 {
-    using type = append_t<reverse_t<list<Tl...>>, Hd>;
+    using type = typename detail::reverse_helper<std::index_sequence_for<Ts...>, Ts...>::type;
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -378,21 +494,16 @@ namespace detail
     template <typename List, template <typename> class F>
     struct for_each_helper;
 
-    template <template <typename> class F>
-    struct for_each_helper<list<>, F>
-    {
-	    template <typename... Args>
-	    static constexpr auto execute(Args&&...) -> void {}
-    };
-
-    template <typename Hd, typename... Tl, template <typename> class F>
-    struct for_each_helper<list<Hd, Tl...>, F>
+    template <typename... Ts, template <typename> class F>
+    struct for_each_helper<list<Ts...>, F>
     {
 	    template <typename... Args>
 	    static constexpr auto execute(Args&&... args) -> void
         {
-		    F<Hd>{}(std::forward<Args>(args)...);
-		    for_each_helper<list<Tl...>, F>::execute(std::forward<Args>(args)...);
+		    //  The elements of a braced list are evaluated in order.
+		    //
+		    const int in_order[] = {0, (F<Ts>{}(std::forward<Args>(args)...), 0)...};
+		    (void)in_order;
 	    }
     };
 }
@@ -423,52 +534,67 @@ template <typename List, std::size_t I = 0> struct indexed;
 template <typename List, std::size_t I = 0>
 using indexed_t = typename indexed<List, I>::type;
 
-template <std::size_t I> 
-struct indexed<list<>, I>
+namespace detail {
+
+template <std::size_t I, typename IS, typename... Ts> struct indexed_helper;
+
+template <std::size_t I, std::size_t... Is, typename... Ts>
+struct indexed_helper<I, std::index_sequence<Is...>, Ts...>
 {
-    using type = list<>;
+    using type = list<indexed_type<I + Is, Ts>...>;
 };
 
-template <typename Hd, typename... Tl, std::size_t I>
-struct indexed<list<Hd, Tl...>, I>
+} // namespace detail
+
+template <typename... Ts, std::size_t I>
+struct indexed<list<Ts...>, I>
 {
-    using type = prepend_t<indexed_type<I, Hd>, indexed_t<list<Tl...>, I + 1>>;
+    using type = typename detail::indexed_helper<I, std::index_sequence_for<Ts...>, Ts...>::type;
 };
 
 //--------------------------------------------------------------------------------------------------
-//  all_pairs
+//  cartesian_product - given zero or more lists, creates the list of every list<T1, T2, ...> that
+//      takes T1 from the first list, T2 from the second, and so on. The order is row-major, i.e.
+//      the last list varies fastest, so the element for indices (i1, ..., in) is at position
+//      ((i1 * N2 + i2) * N3 + ...) + in.
 //--------------------------------------------------------------------------------------------------
 
-template <typename List1, typename List2> struct all_pairs;
+template <typename... Lists> struct cartesian_product;
 
-template <typename List1, typename List2>
-using all_pairs_t = typename all_pairs<List1, List2>::type;
+template <typename... Lists>
+using cartesian_product_t = typename cartesian_product<Lists...>::type;
 
 namespace detail {
-    
-template <typename List1, typename List2, typename IS> struct all_pairs_helper;
 
-template <typename... Ts1, typename... Ts2, std::size_t... I>
-struct all_pairs_helper<list<Ts1...>, list<Ts2...>, std::index_sequence<I...>>
-{
-    using list1 = list<Ts1...>;
-    using list2 = list<Ts2...>;
-    constexpr static auto size2 = sizeof...(Ts2);
+template <typename T, typename ListOfLists> struct prepend_each;
 
-    using type = list<list<div_at_t<I,size2,list1>, mod_at_t<I,size2,list2>>...>;
+template <typename T, typename... Lists>
+struct prepend_each<T, list<Lists...>>
+{
+    using type = list<prepend_t<T, Lists>...>;
 };
 
 } // namespace detail
 
-template <> struct all_pairs<list<>,list<>> { using type = list<>; };
-template <typename... Ts> struct all_pairs<list<Ts...>,list<>> { using type = list<>; };
-template <typename... Ts> struct all_pairs<list<>,list<Ts...>> { using type = list<>; };
+template <> struct cartesian_product<>
+{
+    using type = list<list<>>;
+};
 
-template <typename... Ts1, typename... Ts2>
-struct all_pairs<list<Ts1...>, list<Ts2...>>
+template <typename... Ts, typename... Lists>
+struct cartesian_product<list<Ts...>, Lists...>
 {
-    using type = typename detail::all_pairs_helper<list<Ts1...>, list<Ts2...>,
-        std::make_index_sequence<sizeof...(Ts1) * sizeof...(Ts2)>>::type;
+    using type = concat_t<typename detail::prepend_each<Ts, cartesian_product_t<Lists...>>::type...>;
 };
 
+//--------------------------------------------------------------------------------------------------
+//  all_pairs - the cartesian product of two lists
+//--------------------------------------------------------------------------------------------------
+
+template <typename List1, typename List2> struct all_pairs
+    :   cartesian_product<List1, List2> {};
+
+template <typename List1, typename List2>
+using all_pairs_t = typename all_pairs<List1, List2>::type;
+
 }
@@ -0,0 +1,285 @@
+#pragma once
+#include "common.hpp"
+#include "hierarchy.hpp"
+#include "hooks.hpp"
+#include "index_switch.hpp"
+#include "inline_cache.hpp"
+#include "instrument.hpp"
+#include "list.hpp"
+#include "ordinal.hpp"
+#include "overload.hpp"
+#include "table_stats.hpp"
+#include <array>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace josa::visitor
+{
+    namespace detail
+    {
+        //  The reference through which an object passed to an N-ary visit is dispatched: a const
+        //  reference to the hierarchy's base unless the object is a non-const lvalue.
+        //
+        template <typename Obj, typename Hierarchy>
+        struct object_ref
+        {
+            using base_t = typename hierarchy_traits<Hierarchy>::base_t;
+
+            static_assert(std::is_base_of_v<base_t, std::remove_cv_t<std::remove_reference_t<Obj>>>,
+                "each object passed to visit must derive from the base type of its hierarchy");
+
+            static constexpr bool is_const = std::is_const_v<std::remove_reference_t<Obj>> || !std::is_lvalue_reference_v<Obj>;
+
+            using type = mk_const_t<is_const, base_t>&;
+        };
+
+        template <typename Obj, typename Hierarchy>
+        using object_ref_t = typename object_ref<Obj, Hierarchy>::type;
+
+        template <typename F, typename ObjRefTL, typename ConcreteTL, typename ArgTL>
+        struct dispatch_case_n;
+
+        template <typename F, typename... ObjRefs, typename... Concretes, typename... Args>
+        struct dispatch_case_n<F, meta::list<ObjRefs...>, meta::list<Concretes...>, meta::list<Args...>>
+        {
+            static auto dispatch(F&& f, ObjRefs... objs, Args&&... args) -> decltype(auto)
+            {
+                //  A compile-error on the following line probably means a case is missing from a visitor
+                //  class or overloaded function.
+                //
+                return f(static_cast<mk_const_t<std::is_const_v<std::remove_reference_t<ObjRefs>>, Concretes>&>(objs)...,
+                    std::forward<Args>(args)...);
+            }
+        };
+
+        //  Builds the flattened N-dimensional table of dispatch functions, in the row-major order of
+        //  meta::cartesian_product_t.
+        //
+        template <typename F, typename ObjRefTL, typename CombinationTL, typename ArgTL>
+        struct dispatch_table_maker_n;
+
+        template <typename F, typename ObjRefTL, typename... Combinations, typename ArgTL>
+        struct dispatch_table_maker_n<F, ObjRefTL, meta::list<Combinations...>, ArgTL>
+        {
+            using value_t = decltype(&dispatch_case_n<F, ObjRefTL, meta::head_t<meta::list<Combinations...>>, ArgTL>::dispatch);
+            using table_t = std::array<value_t, sizeof...(Combinations)>;
+
+            static constexpr auto make() -> table_t
+            {
+                return {&dispatch_case_n<F, ObjRefTL, Combinations, ArgTL>::dispatch...};
+            }
+        };
+
+        template <typename HierarchyTL, typename ObjRefTL, typename ArgTL>
+        struct dispatch_n;
+
+        template <typename... Hierarchies, typename... ObjRefs, typename... Args>
+        struct dispatch_n<meta::list<Hierarchies...>, meta::list<ObjRefs...>, meta::list<Args...>>
+        {
+            static constexpr std::size_t arity = sizeof...(Hierarchies);
+            static constexpr std::array<std::size_t, arity> sizes = {hierarchy_traits<Hierarchies>::size...};
+            static constexpr std::size_t combinations = (std::size_t{1} * ... * hierarchy_traits<Hierarchies>::size);
+
+            //  Distance in the flattened table between consecutive ordinals of hierarchy m.
+            //
+            static constexpr auto stride(const std::size_t m) -> std::size_t
+            {
+                std::size_t s = 1;
+
+                for (auto k = m + 1; k < arity; ++k)
+                    s *= sizes[k];
+
+                return s;
+            }
+
+            //  The concrete types for index K of the flattened table.
+            //
+            template <std::size_t K, typename IS = std::make_index_sequence<arity>> struct combination_at;
+
+            template <std::size_t K, std::size_t... M>
+            struct combination_at<K, std::index_sequence<M...>>
+            {
+                using type = meta::list<meta::at_t<(K / stride(M)) % sizes[M],
+                    typename hierarchy_traits<Hierarchies>::concrete_types_t>...>;
+            };
+
+            template <typename F>
+            static auto call(const std::array<std::size_t, arity>& ordinals, F&& f, ObjRefs... objs, Args&&... args) -> decltype(auto)
+            {
+                auto index = std::size_t{0};
+
+                for (std::size_t m = 0; m < arity; ++m)
+                {
+                    if (ordinals[m] == npos)
+                        unhandled([&] { return describe(objs...); });
+
+                    index = index * sizes[m] + ordinals[m];
+                }
+
+                if constexpr (dispatch_uses_switch<Hierarchies...>())
+                {
+                    using result_t = decltype(dispatch_case_n<F, meta::list<ObjRefs...>, typename combination_at<0>::type, meta::list<Args...>>
+                        ::dispatch(std::declval<F>(), objs..., std::declval<Args>()...));
+
+                    return index_switch<result_t, combinations>(index, [&](auto k) -> result_t {
+                        using case_t = dispatch_case_n<F, meta::list<ObjRefs...>, typename combination_at<decltype(k)::value>::type, meta::list<Args...>>;
+                        static_assert(case_returns_v<result_t, case_t>, "every case of a visitor must return the same type");
+
+                        return case_t::dispatch(std::forward<F>(f), objs..., std::forward<Args>(args)...); });
+                }
+                else
+                {
+                    using maker_t = dispatch_table_maker_n<F, meta::list<ObjRefs...>,
+                        meta::cartesian_product_t<typename hierarchy_traits<Hierarchies>::concrete_types_t...>, meta::list<Args...>>;
+                    static constexpr auto dispatch_table = maker_t::make();
+                    static_cast<void>(&counted_table<maker_t, Hierarchies...>::counted);
+
+                    return dispatch_table[index](std::forward<F>(f), objs..., std::forward<Args>(args)...);
+                }
+            }
+
+            static auto describe(ObjRefs... objs) -> std::string
+            {
+                auto names = std::string{};
+                ((names += (names.empty() ? "" : ", ") + type_name_of<Hierarchies>(objs)), ...);
+                return names;
+            }
+        };
+    }
+
+    //  Dispatch on three or more hierarchies at once. visit takes one object per hierarchy followed
+    //  by any extra arguments, and looks the combination up in a single flattened table, so the
+    //  cost is one type lookup per object plus one indirect call, whatever the number of
+    //  hierarchies. Objects passed as const references or temporaries are dispatched as const.
+    //
+    template <typename Hierarchy1, typename Hierarchy2, typename Hierarchy3, typename... Hierarchies>
+    struct dispatcher<Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>
+    {
+        using hierarchies_t = meta::list<Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>;
+
+        static constexpr std::size_t arity = 3 + sizeof...(Hierarchies);
+
+        template <typename F, typename... ObjsAndArgs>
+        static auto visit(F&& f, ObjsAndArgs&&... objs_and_args) -> decltype(auto)
+        {
+            static_assert(sizeof...(ObjsAndArgs) >= arity, "visit needs one object per hierarchy");
+
+            return visit_split(
+                [](auto m, const auto& obj) { return detail::hierarchy_ordinal_t<meta::at_t<decltype(m)::value, hierarchies_t>>::of(obj); },
+                std::make_index_sequence<arity>{}, std::make_index_sequence<sizeof...(ObjsAndArgs) - arity>{},
+                std::forward<F>(f), std::forward_as_tuple(std::forward<ObjsAndArgs>(objs_and_args)...));
+        }
+
+        template <std::size_t Ways, typename F, typename... ObjsAndArgs>
+        static auto visit(basic_inline_cache<Ways, Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>& cache, F&& f,
+                        ObjsAndArgs&&... objs_and_args) -> decltype(auto)
+        {
+            static_assert(sizeof...(ObjsAndArgs) >= arity, "visit needs one object per hierarchy");
+
+            return visit_split(
+                [&cache](auto m, const auto& obj) { return cache.template ordinal_of<decltype(m)::value>(obj); },
+                std::make_index_sequence<arity>{}, std::make_index_sequence<sizeof...(ObjsAndArgs) - arity>{},
+                std::forward<F>(f), std::forward_as_tuple(std::forward<ObjsAndArgs>(objs_and_args)...));
+        }
+
+        template <typename... Objs>
+        static auto match(Objs&&... objs) -> decltype(auto)
+        {
+            static_assert(sizeof...(Objs) == arity, "match needs one object per hierarchy");
+
+            return [&objs...](auto&&... fs) -> decltype(auto) {
+                return dispatcher::visit(overload(std::forward<decltype(fs)>(fs)...), std::forward<Objs>(objs)...); };
+        }
+
+        template <std::size_t Ways, typename... Objs>
+        static auto match(basic_inline_cache<Ways, Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>& cache, Objs&&... objs) -> decltype(auto)
+        {
+            static_assert(sizeof...(Objs) == arity, "match needs one object per hierarchy");
+
+            return [&cache, &objs...](auto&&... fs) -> decltype(auto) {
+                return dispatcher::visit(cache, overload(std::forward<decltype(fs)>(fs)...), std::forward<Objs>(objs)...); };
+        }
+
+        static auto warm_up() -> void
+        {
+            detail::hierarchy_ordinal_t<Hierarchy1>::warm_up();
+            detail::hierarchy_ordinal_t<Hierarchy2>::warm_up();
+            detail::hierarchy_ordinal_t<Hierarchy3>::warm_up();
+            (detail::hierarchy_ordinal_t<Hierarchies>::warm_up(), ...);
+        }
+
+    private:
+
+        template <typename Lookup, std::size_t... M, std::size_t... J, typename F, typename Tuple>
+        static auto visit_split(Lookup&& lookup, std::index_sequence<M...>, std::index_sequence<J...>, F&& f, Tuple&& t) -> decltype(auto)
+        {
+            using tuple_t = std::remove_reference_t<Tuple>;
+            using dispatch_t = detail::dispatch_n<hierarchies_t,
+                meta::list<detail::object_ref_t<std::tuple_element_t<M, tuple_t>, meta::at_t<M, hierarchies_t>>...>,
+                meta::list<std::tuple_element_t<arity + J, tuple_t>...>>;
+
+            return dispatch_t::call({counted_lookup<F, M>(lookup, std::get<M>(t))...}, std::forward<F>(f),
+                std::get<M>(t)..., std::forward<std::tuple_element_t<arity + J, tuple_t>>(std::get<arity + J>(t))...);
+        }
+
+        //  The ordinal lookup finds for the M-th object, counted for visitor F under the M-th
+        //  hierarchy if instrumentation is on.
+        //
+        template <typename F, std::size_t M, typename Lookup, typename Obj>
+        static auto counted_lookup(Lookup& lookup, const Obj& obj) -> std::size_t
+        {
+#if JOSA_VISITOR_INSTRUMENT
+            return detail::instrument<meta::at_t<M, hierarchies_t>, detail::unhooked_t<F>>::lookup([&] { return lookup(meta::size_constant<M>{}, obj); });
+#else
+            return lookup(meta::size_constant<M>{}, obj);
+#endif
+        }
+    };
+
+    template <typename Handler, typename Hierarchy1, typename Hierarchy2, typename Hierarchy3, typename... Hierarchies>
+    struct enable_dispatch<Handler, Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>
+    {
+        using dispatcher_t = dispatcher<Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>;
+
+        template <typename... ObjsAndArgs>
+        auto visit(ObjsAndArgs&&... objs_and_args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(handler(), std::forward<ObjsAndArgs>(objs_and_args)...);
+        }
+
+        template <typename... ObjsAndArgs>
+        auto visit(ObjsAndArgs&&... objs_and_args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(handler(), std::forward<ObjsAndArgs>(objs_and_args)...);
+        }
+
+        template <std::size_t Ways, typename... ObjsAndArgs>
+        auto visit(basic_inline_cache<Ways, Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>& cache,
+                   ObjsAndArgs&&... objs_and_args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), std::forward<ObjsAndArgs>(objs_and_args)...);
+        }
+
+        template <std::size_t Ways, typename... ObjsAndArgs>
+        auto visit(basic_inline_cache<Ways, Hierarchy1, Hierarchy2, Hierarchy3, Hierarchies...>& cache,
+                   ObjsAndArgs&&... objs_and_args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, handler(), std::forward<ObjsAndArgs>(objs_and_args)...);
+        }
+
+    private:
+
+        auto handler() const -> const Handler& { check_hooks(); return static_cast<const Handler&>(*this); }
+        auto handler() -> Handler& { check_hooks(); return static_cast<Handler&>(*this); }
+
+        //  Hooks are called around the handlers of one object; there is no ordinal to pass for two.
+        //
+        static constexpr auto check_hooks() -> void
+        {
+            static_assert(std::is_void_v<detail::handler_hooks_t<Handler>>,
+                          "visit_hooks are only supported by single dispatch");
+        }
+    };
+}
@@ -0,0 +1,819 @@
+#pragma once
+#include "hierarchy.hpp"
+#include "list.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+
+//  Whether RTTI is enabled. Without it only hierarchies with a tag_accessor can be dispatched on.
+//
+#if !defined(JOSA_VISITOR_RTTI)
+#   if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+#       define JOSA_VISITOR_RTTI 1
+#   else
+#       define JOSA_VISITOR_RTTI 0
+#   endif
+#endif
+
+namespace josa::visitor
+{
+    namespace detail
+    {
+        //  Ordinal returned for a dynamic type that is not one of a hierarchy's concrete types.
+        //
+        inline constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        //  Largest number of cases dispatched through a switch unless an option says otherwise. Past
+        //  a handful of types the switch's jump table is no better predicted than a function pointer,
+        //  and its range checks make it slightly slower (see bench/bench-inline-dispatch.cpp).
+        //
+        inline constexpr std::size_t switch_dispatch_limit = 8;
+
+        template <typename Option>
+        struct tag_option : std::false_type {};
+
+        template <auto Accessor>
+        struct tag_option<tag_accessor<Accessor>> : std::true_type
+        {
+            static constexpr auto accessor = Accessor;
+        };
+
+        template <typename... Options>
+        struct find_tag_option { using type = tag_option<void>; };
+
+        template <typename Option, typename... Options>
+        struct find_tag_option<Option, Options...>
+        {
+            using type = std::conditional_t<tag_option<Option>::value, tag_option<Option>,
+                typename find_tag_option<Options...>::type>;
+        };
+
+        template <typename Hierarchy> struct hierarchy_traits;
+
+        template <typename Base, typename... Concretes, typename... Options>
+        struct hierarchy_traits<hierarchy<base_type<Base>, concrete_types<Concretes...>, Options...>>
+        {
+            static_assert(meta::all_unique<meta::list<Concretes...>>::value,
+                "concrete_types<...> must not contain duplicate types");
+
+            using base_t = Base;
+            using concrete_types_t = meta::list<Concretes...>;
+            using options_t = meta::list<Options...>;
+
+            static constexpr std::size_t size = sizeof...(Concretes);
+            static constexpr bool vtable_key = meta::contains<visitor::vtable_key, options_t>::value;
+            static constexpr bool switch_dispatch = meta::contains<visitor::switch_dispatch, options_t>::value;
+            static constexpr bool table_dispatch = meta::contains<visitor::table_dispatch, options_t>::value;
+            static constexpr bool resolve_derived = meta::contains<visitor::resolve_derived, options_t>::value;
+
+            static_assert(!(switch_dispatch && table_dispatch), "switch_dispatch and table_dispatch are exclusive");
+
+            static constexpr bool use_switch = switch_dispatch || (!table_dispatch && size <= switch_dispatch_limit);
+
+            using tag_option_t = typename find_tag_option<Options...>::type;
+            static constexpr bool tag_dispatch = tag_option_t::value;
+
+            static_assert((std::size_t{0} + ... + tag_option<Options>::value) <= 1, "a hierarchy can have only one tag_accessor");
+            static_assert(!(tag_dispatch && vtable_key), "tag_accessor and vtable_key are exclusive");
+            static_assert(!(tag_dispatch && resolve_derived), "tag_accessor and resolve_derived are exclusive");
+        };
+
+        //  Multiple dispatch goes through a switch over the flattened index of the hierarchies'
+        //  ordinals when every hierarchy asks for one, or when none asks for a table and the number
+        //  of combinations is small. There are fewer combinations than pairs of concrete types when
+        //  the handler's overload_types group them into classes.
+        //
+        template <typename... Hierarchies>
+        constexpr auto dispatch_uses_switch(const std::size_t combinations = (std::size_t{1} * ... * hierarchy_traits<Hierarchies>::size)) -> bool
+        {
+            if constexpr ((hierarchy_traits<Hierarchies>::table_dispatch || ...))
+                return false;
+            else if constexpr ((hierarchy_traits<Hierarchies>::switch_dispatch && ...))
+                return true;
+            else
+                return combinations <= switch_dispatch_limit;
+        }
+
+        //  Smallest power of two that keeps an open-addressed table of n entries at most half full.
+        //
+        constexpr auto table_capacity(const std::size_t n) -> std::size_t
+        {
+            std::size_t capacity = 1;
+
+            while (capacity < 2 * n)
+                capacity <<= 1;
+
+            return capacity;
+        }
+
+        //  Fibonacci hash of an address; the low bits of an address are mostly alignment.
+        //
+        inline auto address_hash(const void* p) -> std::size_t
+        {
+            const auto x = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p));
+            return static_cast<std::size_t>((x * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        //  Reads the vtable pointer of a polymorphic object. Under the Itanium C++ ABI it is the first
+        //  word of every polymorphic subobject, and it is distinct for every concrete type.
+        //
+        template <typename Base>
+        auto vtable_of(const Base& obj) -> const void*
+        {
+            static_assert(std::is_polymorphic_v<Base>, "vtable_key requires a polymorphic base type");
+#if defined(__GXX_ABI_VERSION)
+            const void* vptr;
+            std::memcpy(&vptr, static_cast<const void*>(&obj), sizeof(vptr));
+            return vptr;
+#else
+            static_assert(meta::always_false<Base>::value, "vtable_key requires the Itanium C++ ABI");
+            return nullptr;
+#endif
+        }
+
+        //  An insert-only map from addresses to pointers, read without locks. Its slots are in a
+        //  table published with a single atomic store, and a slot's value is written before its
+        //  key, so a reader that finds a key also finds its value. Inserts, which only happen on
+        //  slow paths, take a lock, and once the table is half full replace it with one twice the
+        //  size. Replaced tables are kept until the memo is destroyed, as a reader may still be
+        //  using one; together they are smaller than the current table.
+        //
+        //  A memo has a constant initializer and no table until the first insert, so it can be
+        //  used during static initialization.
+        //
+        template <typename Value, std::size_t InitialCapacity>
+        class address_memo
+        {
+            static_assert(InitialCapacity >= 2 && (InitialCapacity & (InitialCapacity - 1)) == 0,
+                "capacity must be a power of two");
+
+            struct slot
+            {
+                std::atomic<const void*> key{nullptr};
+                std::atomic<const Value*> value{nullptr};
+            };
+
+            struct table
+            {
+                explicit table(const std::size_t capacity, table* replaced)
+                    :   mask{capacity - 1},
+                        slots{new slot[capacity]},
+                        previous{replaced}
+                {
+                }
+
+                auto put(const void* key, const Value* value) -> void
+                {
+                    auto i = address_hash(key) & mask;
+
+                    for (; const auto k = slots[i].key.load(std::memory_order_relaxed); i = (i + 1) & mask)
+                    {
+                        if (k == key)
+                            return;
+                    }
+
+                    slots[i].value.store(value, std::memory_order_relaxed);
+                    slots[i].key.store(key, std::memory_order_release);
+                    ++size;
+                }
+
+                std::size_t mask;
+                std::unique_ptr<slot[]> slots;
+                std::unique_ptr<table> previous;
+                std::size_t size = 0;
+            };
+
+        public:
+
+            constexpr address_memo() = default;
+
+            address_memo(const address_memo&) = delete;
+            auto operator=(const address_memo&) -> address_memo& = delete;
+
+            ~address_memo()
+            {
+                delete current_.exchange(nullptr, std::memory_order_acq_rel);
+            }
+
+            auto find(const void* key) const -> const Value*
+            {
+                const auto t = current_.load(std::memory_order_acquire);
+
+                if (!t)
+                    return nullptr;
+
+                for (auto i = address_hash(key) & t->mask; const auto k = t->slots[i].key.load(std::memory_order_acquire); i = (i + 1) & t->mask)
+                {
+                    if (k == key)
+                        return t->slots[i].value.load(std::memory_order_relaxed);
+                }
+
+                return nullptr;
+            }
+
+            //  Keeps the first value inserted for a key.
+            //
+            auto insert(const void* key, const Value* value) -> void
+            {
+                const auto lock = std::lock_guard{mutex_};
+                auto t = current_.load(std::memory_order_relaxed);
+
+                if (!t || 2 * (t->size + 1) > t->mask + 1)
+                {
+                    auto next = std::make_unique<table>(t ? 2 * (t->mask + 1) : InitialCapacity, t);
+
+                    if (t)
+                    {
+                        for (std::size_t i = 0; i <= t->mask; ++i)
+                        {
+                            if (const auto k = t->slots[i].key.load(std::memory_order_relaxed))
+                                next->put(k, t->slots[i].value.load(std::memory_order_relaxed));
+                        }
+                    }
+
+                    t = next.release();
+                    current_.store(t, std::memory_order_release);
+                }
+
+                t->put(key, value);
+            }
+
+            //  Bytes taken by the memo and its tables.
+            //
+            auto bytes() const -> std::size_t
+            {
+                auto n = sizeof(*this);
+
+                for (auto t = current_.load(std::memory_order_acquire); t; t = t->previous.get())
+                    n += sizeof(table) + (t->mask + 1) * sizeof(slot);
+
+                return n;
+            }
+
+        private:
+
+            std::atomic<table*> current_{nullptr};
+            std::mutex mutex_;
+        };
+
+#if JOSA_VISITOR_RTTI
+
+        //  Number of other types in Concretes that Concrete derives from.
+        //
+        template <typename Concrete, typename... Concretes>
+        constexpr auto ancestor_count() -> std::size_t
+        {
+            return meta::detail::count_true({(std::is_base_of_v<Concretes, Concrete> && !std::is_same_v<Concretes, Concrete>)..., false});
+        }
+
+        //  Ordinals sorted by decreasing number of ancestors, so that a type is always listed before
+        //  the listed types it derives from.
+        //
+        template <std::size_t N>
+        constexpr auto most_derived_first(const std::array<std::size_t, N>& ancestors) -> std::array<std::size_t, N>
+        {
+            std::array<std::size_t, N> order{};
+
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                auto j = i;
+
+                for (; j > 0 && ancestors[order[j - 1]] < ancestors[i]; --j)
+                    order[j] = order[j - 1];
+
+                order[j] = i;
+            }
+
+            return order;
+        }
+
+        //  Finds the ordinal of the nearest listed ancestor of an object's dynamic type by trying a
+        //  dynamic_cast to each listed type, most derived first.
+        //
+        template <typename Base, typename ConcreteTL>
+        struct nearest_concrete;
+
+        template <typename Base, typename... Concretes>
+        struct nearest_concrete<Base, meta::list<Concretes...>>
+        {
+            static_assert(std::is_polymorphic_v<Base>, "resolve_derived requires a polymorphic base type");
+
+            static constexpr auto order = most_derived_first<sizeof...(Concretes)>({ancestor_count<Concretes, Concretes...>()...});
+
+            template <typename Concrete>
+            static auto is_a(const Base& obj) -> bool
+            {
+                return dynamic_cast<const Concrete*>(&obj) != nullptr;
+            }
+
+            static auto of(const Base& obj) -> std::size_t
+            {
+                static constexpr std::array<bool (*)(const Base&), sizeof...(Concretes)> probes = {&is_a<Concretes>...};
+
+                for (const auto i : order)
+                {
+                    if (probes[i](obj))
+                        return i;
+                }
+
+                return npos;
+            }
+        };
+
+        //  Maps the dynamic type of an object to its ordinal, i.e. its position within the hierarchy's
+        //  concrete_types<...> list. The mapping is built once per hierarchy and shared by every
+        //  visitor of that hierarchy; its tables have a fixed size so a lookup of a listed type never
+        //  touches the heap.
+        //
+        //  Types are looked up by the address of their std::type_info, which avoids hashing and
+        //  comparing mangled names. A type_info object that is not found by address may still
+        //  describe a concrete type if it was emitted by another shared object; only then is the
+        //  type looked up by name, and the address remembered, found or not, so that the next
+        //  lookup of that type_info is fast.
+        //
+        //  With the vtable_key option the object's vtable pointer is tried first, and each vtable is
+        //  remembered, found or not, the first time it is resolved through RTTI.
+        //
+        //  With the resolve_derived option a type that is found neither way is resolved to its
+        //  nearest listed ancestor, given an object of that type. The result, including a failure,
+        //  is kept in a registry of entries for derived types, fronted by a memo that grows with the
+        //  number of types and is read without locks, so only the first visit of a type is slow.
+        //
+        template <typename Hierarchy>
+        class type_ordinal
+        {
+            using traits = hierarchy_traits<Hierarchy>;
+
+            static constexpr std::size_t capacity = table_capacity(traits::size);
+            static constexpr std::size_t mask = capacity - 1;
+
+        public:
+
+            //  The type is published after the ordinal, so an entry whose type is seen is complete.
+            //
+            struct entry
+            {
+                std::atomic<const std::type_info*> type{nullptr};
+                std::size_t ordinal = npos;
+
+                auto type_info() const -> const std::type_info*
+                {
+                    return type.load(std::memory_order_acquire);
+                }
+            };
+
+        private:
+
+            using table_t = std::array<entry, capacity>;
+            using memo_t = address_memo<entry, 16>;
+
+            struct tables
+            {
+                table_t by_address;
+                table_t by_name;
+            };
+
+            template <typename ConcreteTL> struct tables_filler;
+
+            template <typename... Concretes>
+            struct tables_filler<meta::list<Concretes...>>
+            {
+                static constexpr std::array<const std::type_info*, sizeof...(Concretes)> types = {&typeid(Concretes)...};
+
+                static auto fill(tables& t) -> void
+                {
+                    for (std::size_t ordinal = 0; ordinal < types.size(); ++ordinal)
+                        insert(t, *types[ordinal], ordinal);
+                }
+            };
+
+            static auto insert(tables& t, const std::type_info& type, const std::size_t ordinal) -> void
+            {
+                auto i = address_hash(&type) & mask;
+
+                while (t.by_address[i].type_info())
+                    i = (i + 1) & mask;
+
+                t.by_address[i].ordinal = ordinal;
+                t.by_address[i].type.store(&type, std::memory_order_release);
+
+                auto j = type.hash_code() & mask;
+
+                while (t.by_name[j].type_info())
+                    j = (j + 1) & mask;
+
+                t.by_name[j].ordinal = ordinal;
+                t.by_name[j].type.store(&type, std::memory_order_release);
+            }
+
+            static auto find_by_name(const std::type_info& type) -> const entry*
+            {
+                for (auto i = type.hash_code() & mask; tables_.by_name[i].type_info(); i = (i + 1) & mask)
+                {
+                    if (*tables_.by_name[i].type_info() == type)
+                        return &tables_.by_name[i];
+                }
+
+                return nullptr;
+            }
+
+            //  The tables are constant-initialized (empty) and filled during dynamic initialization,
+            //  before main or when a shared object is loaded, so the lookup path has no
+            //  function-local static and no guard check. A lookup that runs before then misses, sees
+            //  that the tables are not ready, and fills them itself.
+            //
+            inline static tables tables_{};
+            inline static std::atomic<bool> ready_{false};
+
+            //  What the memos remember for a type that is not listed; its ordinal is npos.
+            //
+            inline static const entry unlisted_{};
+
+            inline static memo_t foreign_types_{};
+            inline static memo_t vtables_{};
+            inline static memo_t derived_types_{};
+
+            //  Resolves a type that is not listed, and not known under another type_info object, to
+            //  the nearest listed ancestor of obj's type. Entries are created once per type, under a
+            //  lock, and never move.
+            //
+            static auto find_derived(const std::type_info& type, const typename traits::base_t& obj) -> const entry*
+            {
+                static auto mutex = std::mutex{};
+                static auto registry = std::unordered_map<const std::type_info*, entry>{};
+
+                const auto lock = std::lock_guard{mutex};
+                const auto [it, inserted] = registry.try_emplace(&type);
+                auto& e = it->second;
+
+                if (inserted)
+                {
+                    e.ordinal = nearest_concrete<typename traits::base_t, typename traits::concrete_types_t>::of(obj);
+                    e.type.store(&type, std::memory_order_release);
+                }
+
+                derived_types_.insert(&type, &e);
+
+                return e.ordinal != npos ? &e : nullptr;
+            }
+
+        public:
+
+            static constexpr std::size_t size = traits::size;
+
+            //  Fills the tables if that has not happened yet. Safe to call from any thread, any
+            //  number of times.
+            //
+            static auto warm_up() -> bool
+            {
+                static const auto filled = [] {
+                    tables_filler<typename traits::concrete_types_t>::fill(tables_);
+                    ready_.store(true, std::memory_order_release);
+                    return true;
+                }();
+
+                return filled;
+            }
+
+            //  Returns the table entry for a type, or nullptr if it is not one of the concrete types.
+            //  Entries live for the duration of the program. With resolve_derived, passing an object
+            //  of the type also finds types derived from a concrete type.
+            //
+            static auto find(const std::type_info& type, const typename traits::base_t* obj = nullptr) -> const entry*
+            {
+                static_cast<void>(&filled_at_startup_);
+
+                for (auto i = address_hash(&type) & mask; const auto p = tables_.by_address[i].type_info(); i = (i + 1) & mask)
+                {
+                    if (p == &type)
+                        return &tables_.by_address[i];
+                }
+
+                if (!ready_.load(std::memory_order_acquire))
+                {
+                    warm_up();
+                    return find(type, obj);
+                }
+
+                auto p = foreign_types_.find(&type);
+
+                if (!p)
+                {
+                    p = find_by_name(type);
+                    foreign_types_.insert(&type, p ? p : &unlisted_);
+                }
+                else if (p == &unlisted_)
+                {
+                    p = nullptr;
+                }
+
+                if constexpr (traits::resolve_derived)
+                {
+                    if (p)
+                        return p;
+
+                    if (const auto d = derived_types_.find(&type))
+                        return d->ordinal != npos ? d : nullptr;
+
+                    if (obj)
+                        return find_derived(type, *obj);
+                }
+
+                return p;
+            }
+
+            //  Bytes taken by the lookup tables and memos of the hierarchy, as the memos stand.
+            //
+            static auto table_bytes() -> std::size_t
+            {
+                return sizeof(tables_) + foreign_types_.bytes()
+                    + (traits::vtable_key ? vtables_.bytes() : 0)
+                    + (traits::resolve_derived ? derived_types_.bytes() : 0);
+            }
+
+            static auto of(const std::type_info& type) -> std::size_t
+            {
+                const auto p = find(type);
+                return p ? p->ordinal : npos;
+            }
+
+            static auto of(const typename traits::base_t& obj) -> std::size_t
+            {
+                if constexpr (traits::vtable_key)
+                {
+                    const auto vptr = vtable_of(obj);
+
+                    if (const auto p = vtables_.find(vptr))
+                        return p->ordinal;
+
+                    const auto p = find(typeid(obj), &obj);
+                    vtables_.insert(vptr, p ? p : &unlisted_);
+
+                    return p ? p->ordinal : npos;
+                }
+                else
+                {
+                    const auto p = find(typeid(obj), &obj);
+                    return p ? p->ordinal : npos;
+                }
+            }
+
+        private:
+
+            inline static const bool filled_at_startup_ = warm_up();
+        };
+
+#else
+
+        template <typename Hierarchy>
+        class type_ordinal
+        {
+            static_assert(meta::always_false<Hierarchy>::value,
+                "without RTTI a hierarchy needs a tag_accessor to be dispatched on");
+        };
+
+#endif
+
+        //  The integer type of a tag, which may be an enum.
+        //
+        template <typename Tag, bool = std::is_enum_v<Tag>>
+        struct tag_integer { using type = Tag; };
+
+        template <typename Tag>
+        struct tag_integer<Tag, true> { using type = std::underlying_type_t<Tag>; };
+
+        template <typename Concrete, typename = void>
+        struct has_type_tag : std::false_type {};
+
+        template <typename Concrete>
+        struct has_type_tag<Concrete, std::void_t<decltype(type_tag<Concrete>::value)>> : std::true_type {};
+
+        template <typename Concrete>
+        struct checked_type_tag : type_tag<Concrete>
+        {
+            static_assert(has_type_tag<Concrete>::value,
+                "every concrete type of a hierarchy with a tag_accessor needs a tag: "
+                "give it a static constexpr member `tag` or specialize josa::visitor::type_tag");
+        };
+
+        template <typename Integer>
+        struct tag_entry
+        {
+            Integer tag;
+            std::size_t ordinal;
+        };
+
+        //  Compile-time helpers over the tags of a hierarchy's concrete types, in ordinal order.
+        //
+        template <typename Integer, std::size_t N>
+        constexpr auto tags_unique(const std::array<Integer, N>& tags) -> bool
+        {
+            for (std::size_t i = 0; i < N; ++i)
+                for (std::size_t j = i + 1; j < N; ++j)
+                    if (tags[i] == tags[j])
+                        return false;
+
+            return true;
+        }
+
+        template <typename Integer, std::size_t N>
+        constexpr auto tags_are_ordinals(const std::array<Integer, N>& tags) -> bool
+        {
+            for (std::size_t i = 0; i < N; ++i)
+                if (static_cast<std::uint64_t>(tags[i]) != i)
+                    return false;
+
+            return true;
+        }
+
+        template <typename Integer, std::size_t N>
+        constexpr auto min_tag(const std::array<Integer, N>& tags) -> Integer
+        {
+            auto m = tags[0];
+
+            for (const auto t : tags)
+                m = t < m ? t : m;
+
+            return m;
+        }
+
+        //  Offsets are computed modulo 2^64, so that a tag below the minimum wraps to a large offset
+        //  and one comparison rejects tags on either side of the range.
+        //
+        template <typename Integer>
+        constexpr auto tag_offset(const Integer t, const Integer min) -> std::uint64_t
+        {
+            return static_cast<std::uint64_t>(t) - static_cast<std::uint64_t>(min);
+        }
+
+        template <typename Integer, std::size_t N>
+        constexpr auto tag_span(const std::array<Integer, N>& tags) -> std::uint64_t
+        {
+            std::uint64_t span = 0;
+
+            for (const auto t : tags)
+            {
+                const auto o = tag_offset(t, min_tag(tags));
+                span = o >= span ? o + 1 : span;
+            }
+
+            return span;
+        }
+
+        template <std::size_t Span, typename Integer, std::size_t N>
+        constexpr auto make_tag_table(const std::array<Integer, N>& tags) -> std::array<std::size_t, Span>
+        {
+            std::array<std::size_t, Span> by_tag{};
+
+            for (auto& ordinal : by_tag)
+                ordinal = npos;
+
+            if constexpr (Span > 0)
+            {
+                for (std::size_t i = 0; i < N; ++i)
+                    by_tag[tag_offset(tags[i], min_tag(tags))] = i;
+            }
+
+            return by_tag;
+        }
+
+        template <typename Integer, std::size_t N>
+        constexpr auto make_sorted_tags(const std::array<Integer, N>& tags) -> std::array<tag_entry<Integer>, N>
+        {
+            std::array<tag_entry<Integer>, N> sorted{};
+
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                auto j = i;
+
+                for (; j > 0 && sorted[j - 1].tag > tags[i]; --j)
+                    sorted[j] = sorted[j - 1];
+
+                sorted[j] = tag_entry<Integer>{tags[i], i};
+            }
+
+            return sorted;
+        }
+
+        //  Maps the tag of an object to its ordinal, for hierarchies with a tag_accessor. The tags of
+        //  the concrete types are known at compile time, so the mapping is a constant: the tag itself
+        //  when the tags are 0, 1, 2, ... in the order of concrete_types<...>, a table indexed by the
+        //  tag when they are close together, and a binary search otherwise.
+        //
+        template <typename Hierarchy>
+        class tag_ordinal
+        {
+            using traits = hierarchy_traits<Hierarchy>;
+            using base_t = typename traits::base_t;
+
+            static constexpr auto accessor = traits::tag_option_t::accessor;
+
+        public:
+
+            using tag_t = std::decay_t<std::invoke_result_t<decltype(accessor), const base_t&>>;
+
+            static_assert(std::is_integral_v<tag_t> || std::is_enum_v<tag_t>, "a tag_accessor must yield an integer or an enum");
+
+            using integer_t = typename tag_integer<tag_t>::type;
+
+            static constexpr std::size_t size = traits::size;
+
+        private:
+
+            template <typename ConcreteTL> struct tags_of;
+
+            template <typename... Concretes>
+            struct tags_of<meta::list<Concretes...>>
+            {
+                static constexpr std::array<integer_t, sizeof...(Concretes)> value =
+                    {static_cast<integer_t>(static_cast<tag_t>(checked_type_tag<Concretes>::value))...};
+            };
+
+            static constexpr auto tags = tags_of<typename traits::concrete_types_t>::value;
+
+            static_assert(tags_unique(tags), "the concrete types of a hierarchy must have distinct tags");
+
+            static constexpr bool identity = tags_are_ordinals(tags);
+            static constexpr integer_t min = min_tag(tags);
+            static constexpr std::uint64_t span = tag_span(tags);
+            static constexpr bool dense = !identity && span <= 2 * size + 64;
+
+            static constexpr auto by_tag_ = make_tag_table<dense ? span : 0>(tags);
+            static constexpr auto sorted_ = make_sorted_tags(tags);
+
+        public:
+
+            static auto tag_of(const base_t& obj) -> integer_t
+            {
+                return static_cast<integer_t>(std::invoke(accessor, obj));
+            }
+
+            static auto of(const base_t& obj) -> std::size_t
+            {
+                const auto t = tag_of(obj);
+
+                if constexpr (identity)
+                {
+                    return static_cast<std::uint64_t>(t) < size ? static_cast<std::size_t>(t) : npos;
+                }
+                else if constexpr (dense)
+                {
+                    const auto i = tag_offset(t, min);
+                    return i < span ? by_tag_[i] : npos;
+                }
+                else
+                {
+                    const auto it = std::lower_bound(sorted_.begin(), sorted_.end(), t,
+                        [](const tag_entry<integer_t>& e, const integer_t tag) { return e.tag < tag; });
+
+                    return it != sorted_.end() && it->tag == t ? it->ordinal : npos;
+                }
+            }
+
+            static constexpr auto table_bytes() -> std::size_t
+            {
+                return identity ? 0 : dense ? sizeof(by_tag_) : sizeof(sorted_);
+            }
+
+            //  There is nothing to fill.
+            //
+            static auto warm_up() -> bool
+            {
+                return true;
+            }
+        };
+
+        //  The ordinal lookup for a hierarchy: by tag if it has a tag_accessor, by type otherwise.
+        //
+        template <typename Hierarchy>
+        using hierarchy_ordinal_t = std::conditional_t<hierarchy_traits<Hierarchy>::tag_dispatch,
+            tag_ordinal<Hierarchy>, type_ordinal<Hierarchy>>;
+
+        //  Describes the dynamic type of an object for an unhandled_type error, without RTTI for
+        //  hierarchies with a tag_accessor.
+        //
+        template <typename Hierarchy>
+        auto type_name_of(const typename hierarchy_traits<Hierarchy>::base_t& obj) -> std::string
+        {
+            if constexpr (hierarchy_traits<Hierarchy>::tag_dispatch)
+                return "tag " + std::to_string(+tag_ordinal<Hierarchy>::tag_of(obj));
+#if JOSA_VISITOR_RTTI
+            else
+                return typeid(obj).name();
+#else
+            else
+                return {};
+#endif
+        }
+    }
+}
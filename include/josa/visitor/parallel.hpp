@@ -0,0 +1,128 @@
+#pragma once
+#include "common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace josa::visitor
+{
+    namespace detail
+    {
+        //  The size assumed for a cache line when keeping the state of different threads apart.
+        //  std::hardware_destructive_interference_size would do, but is missing from some standard
+        //  libraries and warns on others.
+        //
+        inline constexpr std::size_t cache_line_size = 64;
+
+        //  A value alone on its cache line(s), so that threads writing to neighbouring values do
+        //  not contend for the same line.
+        //
+        template <typename T>
+        struct alignas(cache_line_size) padded
+        {
+            T value;
+        };
+
+        inline auto default_thread_count() -> std::size_t
+        {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        //  Number of objects a worker claims at a time when count objects are shared among the
+        //  given number of threads: a multiple of the batch chunk size, and small enough that each
+        //  thread gets several grains, so that threads that finish early take work from the rest.
+        //
+        constexpr auto parallel_grain_size(const std::size_t count, const std::size_t threads, const std::size_t chunk_size) -> std::size_t
+        {
+            const auto share = count / (threads * 8);
+            constexpr auto max_grain = std::size_t{65536};
+
+            return std::max(chunk_size, std::min(max_grain - max_grain % chunk_size, share - share % chunk_size));
+        }
+
+        //  Calls work(worker, begin, end) for consecutive grains of [0, count), from the calling
+        //  thread and threads - 1 others. Each worker claims its next grain from a shared counter,
+        //  so the load balances itself whatever the cost of each object. If work throws, workers
+        //  stop claiming grains and the first exception is rethrown once all threads have joined.
+        //
+        template <typename Work>
+        auto parallel_grains(const std::size_t count, const std::size_t grain, const std::size_t threads, Work&& work) -> void
+        {
+            auto next = std::atomic<std::size_t>{0};
+            auto stop = std::atomic<bool>{false};
+#if JOSA_VISITOR_EXCEPTIONS
+            auto error = std::exception_ptr{};
+            auto error_mutex = std::mutex{};
+#endif
+
+            const auto claim = [&](const std::size_t worker) {
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    const auto begin = next.fetch_add(grain, std::memory_order_relaxed);
+
+                    if (begin >= count)
+                        break;
+
+                    work(worker, begin, std::min(count, begin + grain));
+                }
+            };
+
+            const auto run = [&](const std::size_t worker) {
+#if JOSA_VISITOR_EXCEPTIONS
+                try
+                {
+                    claim(worker);
+                }
+                catch (...)
+                {
+                    stop = true;
+
+                    const auto lock = std::lock_guard{error_mutex};
+
+                    if (!error)
+                        error = std::current_exception();
+                }
+#else
+                claim(worker);
+#endif
+            };
+
+            auto others = std::vector<std::thread>{};
+            others.reserve(threads - 1);
+
+#if JOSA_VISITOR_EXCEPTIONS
+            try
+            {
+                for (std::size_t worker = 1; worker < threads; ++worker)
+                    others.emplace_back(run, worker);
+            }
+            catch (...)
+            {
+                stop = true;
+
+                for (auto& t : others)
+                    t.join();
+
+                throw;
+            }
+#else
+            for (std::size_t worker = 1; worker < threads; ++worker)
+                others.emplace_back(run, worker);
+#endif
+
+            run(0);
+
+            for (auto& t : others)
+                t.join();
+
+#if JOSA_VISITOR_EXCEPTIONS
+            if (error)
+                std::rethrow_exception(error);
+#endif
+        }
+    }
+}
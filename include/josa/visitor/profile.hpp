@@ -0,0 +1,369 @@
+#pragma once
+#include "hooks.hpp"
+#include "instrument.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace josa::visitor
+{
+    //  A histogram of durations in nanoseconds, in the manner of an HDR histogram: exact below 8 ns,
+    //  and above that in 8 buckets per power of two, so that any value is known to within 12.5%.
+    //  Values from 2^45 ns (about 10 hours) up share the last bucket. Recording is a relaxed atomic
+    //  increment, safe from any number of threads.
+    //
+    class latency_histogram
+    {
+    public:
+
+        static constexpr std::size_t sub_buckets = 8;
+        static constexpr std::size_t max_exponent = 44;
+        static constexpr std::size_t buckets = sub_buckets * (max_exponent - 1);
+
+        auto record(const std::uint64_t ns) -> void
+        {
+            counts_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+            total_.fetch_add(ns, std::memory_order_relaxed);
+
+            auto max = max_.load(std::memory_order_relaxed);
+            while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+        }
+
+        auto count() const -> std::uint64_t
+        {
+            auto n = std::uint64_t{0};
+
+            for (const auto& c : counts_)
+                n += c.load(std::memory_order_relaxed);
+
+            return n;
+        }
+
+        auto total() const -> std::uint64_t { return total_.load(std::memory_order_relaxed); }
+        auto max() const -> std::uint64_t { return max_.load(std::memory_order_relaxed); }
+
+        //  The smallest value that at least the given percentage of recorded values do not exceed,
+        //  as the upper bound of its bucket, or 0 if nothing has been recorded.
+        //
+        auto percentile(const double percent) const -> std::uint64_t
+        {
+            const auto n = count();
+
+            if (n == 0)
+                return 0;
+
+            const auto rank = std::max(std::uint64_t{1}, static_cast<std::uint64_t>(percent / 100 * static_cast<double>(n) + 0.5));
+            auto seen = std::uint64_t{0};
+
+            for (std::size_t i = 0; i < buckets; ++i)
+            {
+                seen += counts_[i].load(std::memory_order_relaxed);
+
+                if (seen >= rank)
+                    return std::min(upper_bound_of(i), max());
+            }
+
+            return max();
+        }
+
+        static constexpr auto bucket_of(const std::uint64_t ns) -> std::size_t
+        {
+            if (ns < sub_buckets)
+                return static_cast<std::size_t>(ns);
+
+            auto exponent = std::size_t{3};
+
+            while (exponent < max_exponent && (ns >> (exponent + 1)) != 0)
+                ++exponent;
+
+            if ((ns >> (exponent + 1)) != 0)
+                return buckets - 1;
+
+            return sub_buckets * (exponent - 2) + static_cast<std::size_t>((ns >> (exponent - 3)) & (sub_buckets - 1));
+        }
+
+        static constexpr auto upper_bound_of(const std::size_t bucket) -> std::uint64_t
+        {
+            if (bucket < sub_buckets)
+                return bucket;
+
+            const auto exponent = bucket / sub_buckets + 2;
+            const auto lower = (sub_buckets + bucket % sub_buckets) << (exponent - 3);
+
+            return lower + (std::uint64_t{1} << (exponent - 3)) - 1;
+        }
+
+    private:
+
+        std::array<std::atomic<std::uint64_t>, buckets> counts_{};
+        std::atomic<std::uint64_t> total_{0};
+        std::atomic<std::uint64_t> max_{0};
+    };
+
+    //  The time spent in the handlers for one concrete type of one visitor, including any visits
+    //  they make in turn.
+    //
+    struct handler_latency
+    {
+        std::string visitor;
+        std::string hierarchy;
+        std::string type;
+        const latency_histogram* histogram;
+    };
+
+    //  A hook policy that records how long each handler of a visitor takes, per concrete type, in a
+    //  latency_histogram, and can also record each call as an event for a Chrome trace:
+    //
+    //      struct Evaluator : josa::visitor::enable_dispatch<Evaluator, ExprHierarchy>
+    //      {
+    //          using visit_hooks = josa::visitor::profile_hooks;
+    //          ...
+    //      };
+    //
+    //  Histograms are kept for the life of the program. Tracing is off until start_trace() and
+    //  keeps every event in memory, up to max_events across all threads, until clear_trace().
+    //
+    class profile_hooks
+    {
+        using clock_t = std::chrono::steady_clock;
+
+        struct trace_event
+        {
+            const std::string* visitor;
+            const std::string* type;
+            std::uint64_t start_ns;
+            std::uint64_t duration_ns;
+            std::size_t depth;
+        };
+
+        struct thread_trace
+        {
+            std::size_t thread;
+            std::vector<trace_event> events;
+        };
+
+        struct state
+        {
+            std::mutex mutex;
+            std::vector<auto (*)() -> std::vector<handler_latency>> visitors;
+            std::vector<std::shared_ptr<thread_trace>> traces;
+            std::atomic<bool> tracing{false};
+            std::atomic<std::size_t> max_events{0};
+            std::atomic<std::size_t> events{0};
+            std::size_t threads = 0;
+            const clock_t::time_point epoch = clock_t::now();
+
+            static auto get() -> state&
+            {
+                static auto s = state{};
+                return s;
+            }
+        };
+
+        template <typename Handler, typename Hierarchy>
+        struct visitor_profile
+        {
+            using traits_t = detail::hierarchy_traits<Hierarchy>;
+
+            inline static std::array<latency_histogram, traits_t::size> histograms;
+            inline static const std::string visitor = detail::type_name<Handler>();
+            inline static const std::vector<std::string> types = detail::type_names<typename traits_t::concrete_types_t>::get();
+
+            static auto report() -> std::vector<handler_latency>
+            {
+                auto latencies = std::vector<handler_latency>{};
+                const auto hierarchy = detail::type_name<typename traits_t::base_t>();
+
+                for (std::size_t i = 0; i < traits_t::size; ++i)
+                    latencies.push_back({visitor, hierarchy, types[i], &histograms[i]});
+
+                return latencies;
+            }
+
+            inline static const bool registered = [] {
+                auto& s = state::get();
+                const auto lock = std::lock_guard{s.mutex};
+                s.visitors.push_back(&report);
+                return true;
+            }();
+        };
+
+        static auto starts() -> std::vector<clock_t::time_point>&
+        {
+            thread_local auto times = std::vector<clock_t::time_point>{};
+            return times;
+        }
+
+        static auto this_thread_trace() -> thread_trace&
+        {
+            thread_local const auto trace = [] {
+                auto& s = state::get();
+                const auto lock = std::lock_guard{s.mutex};
+                s.traces.push_back(std::make_shared<thread_trace>(thread_trace{++s.threads, {}}));
+                return s.traces.back();
+            }();
+
+            return *trace;
+        }
+
+        static auto since_epoch(const clock_t::time_point t) -> std::uint64_t
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t - state::get().epoch).count());
+        }
+
+        static auto append_microseconds(std::string& out, const std::uint64_t ns) -> void
+        {
+            out += std::to_string(ns / 1000) + '.';
+            const auto fraction = std::to_string(ns % 1000);
+            out += std::string(3 - fraction.size(), '0') + fraction;
+        }
+
+    public:
+
+        template <typename Handler, typename Hierarchy>
+        static auto before(std::size_t, const std::size_t depth) -> void
+        {
+            auto& times = starts();
+
+            if (times.size() <= depth)
+                times.resize(depth + 1);
+
+            times[depth] = clock_t::now();
+        }
+
+        template <typename Handler, typename Hierarchy>
+        static auto after(const std::size_t ordinal, const std::size_t depth) -> void
+        {
+            using profile_t = visitor_profile<Handler, Hierarchy>;
+
+            const auto end = clock_t::now();
+            const auto start = starts()[depth];
+            const auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+            static_cast<void>(&profile_t::registered);
+            profile_t::histograms[ordinal].record(ns);
+
+            auto& s = state::get();
+
+            if (!s.tracing.load(std::memory_order_relaxed))
+                return;
+
+            //  Once the budget is spent, only the load runs, so that full traces do not contend on
+            //  the counter.
+            //
+            const auto max_events = s.max_events.load(std::memory_order_relaxed);
+
+            if (s.events.load(std::memory_order_relaxed) >= max_events || s.events.fetch_add(1, std::memory_order_relaxed) >= max_events)
+                return;
+
+            this_thread_trace().events.push_back({&profile_t::visitor, &profile_t::types[ordinal], since_epoch(start), ns, depth});
+        }
+
+        //  The histogram of every concrete type of every visitor that has used these hooks.
+        //
+        static auto latencies() -> std::vector<handler_latency>
+        {
+            auto& s = state::get();
+            const auto lock = std::lock_guard{s.mutex};
+            auto all = std::vector<handler_latency>{};
+
+            for (const auto report : s.visitors)
+            {
+                auto latencies = report();
+                all.insert(all.end(), latencies.begin(), latencies.end());
+            }
+
+            return all;
+        }
+
+        static auto start_trace(const std::size_t max_events = 1 << 20) -> void
+        {
+            auto& s = state::get();
+            s.max_events.store(max_events, std::memory_order_relaxed);
+            s.tracing.store(true, std::memory_order_relaxed);
+        }
+
+        static auto stop_trace() -> void
+        {
+            state::get().tracing.store(false, std::memory_order_relaxed);
+        }
+
+        //  Discards the events recorded so far, freeing their memory along with the traces of
+        //  threads that have exited, and restores the budget of max_events. Call it only while no
+        //  thread is visiting.
+        //
+        static auto clear_trace() -> void
+        {
+            auto& s = state::get();
+            const auto lock = std::lock_guard{s.mutex};
+
+            //  A trace no thread_local refers to any more belongs to a thread that has exited.
+            //
+            s.traces.erase(std::remove_if(s.traces.begin(), s.traces.end(), [](const auto& trace) { return trace.use_count() == 1; }),
+                           s.traces.end());
+
+            for (const auto& trace : s.traces)
+                std::vector<trace_event>{}.swap(trace->events);
+
+            s.events.store(0, std::memory_order_relaxed);
+        }
+
+        //  Writes the events recorded so far to a file in the Chrome trace event format, which
+        //  chrome://tracing and Perfetto open, as one complete event per handler call named by the
+        //  concrete type, with the visitor as its category. Call it only while no thread is
+        //  visiting. Returns false if the file cannot be written.
+        //
+        static auto write_trace(const char* path) -> bool
+        {
+            auto& s = state::get();
+            const auto lock = std::lock_guard{s.mutex};
+
+            auto* file = std::fopen(path, "w");
+
+            if (!file)
+                return false;
+
+            auto out = std::string{"{\"displayTimeUnit\":\"ns\",\"traceEvents\":["};
+            auto first = true;
+
+            for (const auto& trace : s.traces)
+            {
+                for (const auto& event : trace->events)
+                {
+                    out += first ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+                    detail::append_escaped(out, *event.type);
+                    out += "\",\"cat\":\"";
+                    detail::append_escaped(out, *event.visitor);
+                    out += "\",\"ph\":\"X\",\"ts\":";
+                    append_microseconds(out, event.start_ns);
+                    out += ",\"dur\":";
+                    append_microseconds(out, event.duration_ns);
+                    out += ",\"pid\":1,\"tid\":" + std::to_string(trace->thread);
+                    out += ",\"args\":{\"depth\":" + std::to_string(event.depth) + "}}";
+                    first = false;
+
+                    if (out.size() > 65536)
+                        std::fputs(std::exchange(out, {}).c_str(), file);
+                }
+            }
+
+            out += "\n]}\n";
+            std::fputs(out.c_str(), file);
+
+            //  The error indicator is sticky, so this also catches a failure of an earlier write.
+            //
+            const auto written = !std::ferror(file);
+
+            return std::fclose(file) == 0 && written;
+        }
+    };
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include "common.hpp"
+#include "ordinal.hpp"
+#include "single_dispatch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if JOSA_VISITOR_RTTI
+
+namespace josa::visitor
+{
+    template <typename Hierarchy, typename Signature>
+    class dispatch_registry;
+
+    //  Handlers for types that are not known at compile time, e.g. types added by plugins loaded
+    //  after startup, layered on the dispatcher of a hierarchy. visit dispatches an object of one
+    //  of the hierarchy's concrete types as usual, and any other object to the handler registered
+    //  for its type.
+    //
+    //  The signature is that of a registered handler, with the object as its first parameter,
+    //  e.g. std::string(const Shape&) or void(Shape&, int).
+    //
+    //  Lookups do not wait for registrations: each registration builds a new immutable table and
+    //  publishes it with a single atomic store, so readers never see a table being changed. Tables
+    //  replaced by later registrations are kept until the registry is destroyed, as a reader may
+    //  still be using one, and so are the handlers they point to. Memory therefore grows with every
+    //  call of add, including one that registers a type again: n calls hold O(n^2) table entries,
+    //  which is negligible for the few hundred types a plugin system typically adds, but rules out
+    //  replacing handlers over and over. A registry must outlive every visit through it.
+    //
+    //  As for the hierarchy's own types, a type is looked up by the address of its std::type_info,
+    //  and only if that is not registered by name, to find a type registered under a type_info
+    //  object emitted by another shared object. Each table remembers the addresses it has looked
+    //  up by name, whether or not they were found, in a memo that grows as needed and is read
+    //  without locks, so a type is only looked up by name, under the memo's lock, once per table.
+    //
+    template <typename Base, typename... Concretes, typename... Options, typename R, typename Obj, typename... Args>
+    class dispatch_registry<hierarchy<base_type<Base>, concrete_types<Concretes...>, Options...>, R(Obj&, Args...)>
+    {
+        static_assert(std::is_same_v<std::remove_const_t<Obj>, Base>,
+            "the first parameter of a registered handler must be a reference to the base type");
+
+        using hierarchy_t = hierarchy<base_type<Base>, concrete_types<Concretes...>, Options...>;
+        using dispatcher_t = dispatcher<hierarchy_t>;
+
+    public:
+
+        using handler_t = std::function<R(Obj&, Args...)>;
+
+        dispatch_registry()
+        {
+            tables_.push_back(std::make_unique<table>(std::size_t{16}));
+            current_.store(tables_.back().get(), std::memory_order_release);
+        }
+
+        dispatch_registry(const dispatch_registry&) = delete;
+        auto operator=(const dispatch_registry&) -> dispatch_registry& = delete;
+
+        //  Registers a handler for objects of type T, replacing any earlier handler for T. The
+        //  handler is called with the object as a T. Safe to call while other threads visit.
+        //
+        template <typename T, typename Handler>
+        auto add(Handler&& handler) -> void
+        {
+            static_assert(std::is_base_of_v<Base, T>, "registered types must derive from the base type");
+
+            add(typeid(T), [handler = std::forward<Handler>(handler)](Obj& obj, Args... args) -> R {
+                return handler(static_cast<detail::mk_const_t<std::is_const_v<Obj>, T>&>(obj), std::forward<Args>(args)...); });
+        }
+
+        //  Registers a handler for objects whose dynamic type is type, called with the object as a
+        //  reference to the base type.
+        //
+        auto add(const std::type_info& type, handler_t handler) -> void
+        {
+            const auto lock = std::lock_guard{mutex_};
+
+            handlers_.push_back(std::move(handler));
+
+            const auto& last = *current_.load(std::memory_order_relaxed);
+            const auto capacity = detail::table_capacity(last.size + 1);
+
+            auto next = std::make_unique<table>(std::max(capacity, last.entries.size()));
+
+            for (const auto& e : last.entries)
+            {
+                if (e.type && e.type != &type)
+                    next->insert(e.type, e.handler);
+            }
+
+            next->insert(&type, &handlers_.back());
+
+            current_.store(next.get(), std::memory_order_release);
+            tables_.push_back(std::move(next));
+        }
+
+        //  The handler registered for a type, or nullptr.
+        //
+        auto find(const std::type_info& type) const -> const handler_t*
+        {
+            return current_.load(std::memory_order_acquire)->find(&type);
+        }
+
+        //  Number of registered types.
+        //
+        auto size() const -> std::size_t
+        {
+            return current_.load(std::memory_order_acquire)->size;
+        }
+
+        //  Calls f if the object is of one of the hierarchy's concrete types, as
+        //  dispatcher<Hierarchy>::visit does, and otherwise the handler registered for its type.
+        //  The hierarchy is checked first, so a listed type costs one lookup, as without a
+        //  registry; a handler registered for a listed type is only called by visit_registered.
+        //  With resolve_derived, a type derived from a listed type is visited as that type.
+        //
+        template <typename F>
+        auto visit(F&& f, Obj& obj, Args... args) const -> R
+        {
+            const auto registered = [this](Obj& unlisted, Args... rest) -> R {
+                return visit_registered(unlisted, std::forward<Args>(rest)...); };
+
+            return dispatcher_t::visit_or(registered, std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
+
+        //  Calls the handler registered for the object's type, bypassing the hierarchy's
+        //  concrete types.
+        //
+        auto visit_registered(Obj& obj, Args... args) const -> R
+        {
+            const auto handler = find(typeid(obj));
+
+            if (!handler)
+                detail::unhandled([&obj] { return std::string{typeid(obj).name()}; });
+
+            return (*handler)(obj, std::forward<Args>(args)...);
+        }
+
+    private:
+
+        //  Open-addressed tables by address and by name, at most half full, that are never changed
+        //  once published, with a memo of the addresses looked up by name.
+        //
+        struct table
+        {
+            struct entry
+            {
+                const std::type_info* type = nullptr;
+                const handler_t* handler = nullptr;
+            };
+
+            explicit table(const std::size_t capacity) : entries(capacity), by_name(capacity) {}
+
+            auto insert(const std::type_info* type, const handler_t* handler) -> void
+            {
+                const auto mask = entries.size() - 1;
+                auto i = detail::address_hash(type) & mask;
+
+                while (entries[i].type)
+                    i = (i + 1) & mask;
+
+                entries[i] = {type, handler};
+
+                auto j = type->hash_code() & mask;
+
+                while (by_name[j].type)
+                    j = (j + 1) & mask;
+
+                by_name[j] = {type, handler};
+                ++size;
+            }
+
+            auto find(const std::type_info* type) const -> const handler_t*
+            {
+                const auto mask = entries.size() - 1;
+
+                for (auto i = detail::address_hash(type) & mask; entries[i].type; i = (i + 1) & mask)
+                {
+                    if (entries[i].type == type)
+                        return entries[i].handler;
+                }
+
+                if (const auto handler = foreign.find(type))
+                    return handler != &unregistered ? handler : nullptr;
+
+                const auto handler = find_by_name(type);
+                foreign.insert(type, handler ? handler : &unregistered);
+
+                return handler;
+            }
+
+            auto find_by_name(const std::type_info* type) const -> const handler_t*
+            {
+                const auto mask = by_name.size() - 1;
+
+                for (auto i = type->hash_code() & mask; by_name[i].type; i = (i + 1) & mask)
+                {
+                    if (*by_name[i].type == *type)
+                        return by_name[i].handler;
+                }
+
+                return nullptr;
+            }
+
+            std::vector<entry> entries;
+            std::vector<entry> by_name;
+            std::size_t size = 0;
+            mutable detail::address_memo<handler_t, 8> foreign;
+        };
+
+        //  Remembered for a type that is not registered.
+        //
+        inline static const handler_t unregistered{};
+
+        std::mutex mutex_;
+        std::deque<handler_t> handlers_;
+        std::vector<std::unique_ptr<table>> tables_;
+        std::atomic<const table*> current_{nullptr};
+    };
+}
+
+#endif
@@ -1,76 +1,135 @@
 #pragma once
+#include "batch.hpp"
 #include "common.hpp"
 #include "list.hpp"
 #include "hierarchy.hpp"
+#include "hooks.hpp"
+#include "index_switch.hpp"
+#include "inline_cache.hpp"
+#include "instrument.hpp"
+#include "ordinal.hpp"
 #include "overload.hpp"
-#include <unordered_map>
-#include <typeindex>
+#include "parallel.hpp"
+#include "table_stats.hpp"
+#include "tagged_ptr.hpp"
+#include <array>
+#include <iterator>
+#include <optional>
+#include <typeinfo>
+#include <vector>
 
 namespace josa::visitor
 {
     namespace detail
     {
         template <bool Const, typename F, typename Base, typename Concrete, typename... Args>
-        auto make_dispatcher()
+        struct dispatch_case
         {
-            struct dispatcher
+            static auto dispatch(F&& f, mk_const_t<Const, Base>& obj, Args&&... args) -> decltype(auto)
             {
-                static auto dispatch(F&& f, mk_const_t<Const, Base>& obj, Args&&... args) -> decltype(auto)
-                {
-                    //  A compile-error on the following line probably means a case is missing from a visitor
-                    //  class or overloaded function.
-                    //
-                    return f(static_cast<mk_const_t<Const, Concrete>&>(obj), std::forward<Args>(args)...);
-                }
-            };
+                //  A compile-error on the following line probably means a case is missing from a visitor
+                //  class or overloaded function.
+                //
+                return f(static_cast<mk_const_t<Const, Concrete>&>(obj), std::forward<Args>(args)...);
+            }
+        };
 
-            return &dispatcher::dispatch;
+        template <bool Const, typename F, typename Base, typename Concrete, typename... Args>
+        constexpr auto make_dispatcher()
+        {
+            return &dispatch_case<Const, F, Base, Concrete, Args...>::dispatch;
         }
 
+        //  Builds an array of dispatch functions, indexed by the ordinal of each concrete type.
+        //
         template <bool Const, typename F, typename Base, typename ConcreteTL, typename ArgTL>
-        struct dispatch_map_maker;
+        struct dispatch_table_maker;
 
         template <bool Const, typename F, typename Base, typename... Concretes, typename... Args>
-        struct dispatch_map_maker<Const, F, Base, meta::list<Concretes...>, meta::list<Args...>>
+        struct dispatch_table_maker<Const, F, Base, meta::list<Concretes...>, meta::list<Args...>>
         {
-            using value_t = std::common_type_t<decltype(make_dispatcher<Const, F, Base, Concretes, Args...>())...>;
-            using key_t = std::type_index;
-            using map_t = std::unordered_map<key_t, value_t>;
+            //  Every dispatch function has the same signature; std::common_type_t would check this too,
+            //  but its recursion depth grows with the number of concrete types.
+            //
+            using value_t = decltype(make_dispatcher<Const, F, Base, meta::head_t<meta::list<Concretes...>>, Args...>());
+            using table_t = std::array<value_t, sizeof...(Concretes)>;
 
-            static auto make() -> map_t
+            static constexpr auto make() -> table_t
             {
-                return {{std::type_index(typeid(Concretes)), make_dispatcher<Const, F, Base, Concretes, Args...>()}...};
+                return {make_dispatcher<Const, F, Base, Concretes, Args...>()...};
             }
         };
     }
 
-    template <typename Base, typename... Concretes>
-    struct dispatcher<hierarchy<base_type<Base>, concrete_types<Concretes...>>>
+    template <typename Base, typename... Concretes, typename... Options>
+    struct dispatcher<hierarchy<base_type<Base>, concrete_types<Concretes...>, Options...>>
     {
+        using Hierarchy = hierarchy<base_type<Base>, concrete_types<Concretes...>, Options...>;
         using ConcreteTypeList = meta::list<Concretes...>;
+        using Ordinal = detail::hierarchy_ordinal_t<Hierarchy>;
 
         template <typename F, typename... Args>
         static auto visit(F&& f, const Base& obj, Args&&... args) -> decltype(auto)
         {
-            static const auto dispatch_map =
-                detail::dispatch_map_maker<true, F, Base, ConcreteTypeList, meta::list<Args...>>::make();
-                
-            if (const auto it = dispatch_map.find(std::type_index(typeid(obj))); it != dispatch_map.end())
-                return it->second(std::forward<F>(f), obj, std::forward<Args>(args)...);
-
-            throw unhandled_type{typeid(obj).name()};
+            return visit_ordinal(lookup<F>(obj), std::forward<F>(f), obj, std::forward<Args>(args)...);
         }
 
         template <typename F, typename... Args>
         static auto visit(F&& f, Base& obj, Args&&... args) -> decltype(auto)
         {
-            static const auto dispatch_map =
-                detail::dispatch_map_maker<false, F, Base, ConcreteTypeList, meta::list<Args...>>::make();
+            return visit_ordinal(lookup<F>(obj), std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
 
-            if (const auto it = dispatch_map.find(std::type_index(typeid(obj))); it != dispatch_map.end())
-                return it->second(std::forward<F>(f), obj, std::forward<Args>(args)...);
+        template <std::size_t Ways, typename F, typename... Args>
+        static auto visit(basic_inline_cache<Ways, Hierarchy>& cache, F&& f, const Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinal(lookup<F>(cache, obj), std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
 
-            throw unhandled_type{typeid(obj).name()};
+        template <std::size_t Ways, typename F, typename... Args>
+        static auto visit(basic_inline_cache<Ways, Hierarchy>& cache, F&& f, Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinal(lookup<F>(cache, obj), std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
+
+        //  Visits the object of a non-null tagged_ptr or tagged_unique_ptr by the ordinal it carries,
+        //  without RTTI and without reading the object before the handler does.
+        //
+        template <typename F, typename Tagged, typename = std::enable_if_t<detail::is_tagged_v<Tagged, Hierarchy>>, typename... Args>
+        static auto visit(F&& f, const Tagged& p, Args&&... args) -> decltype(auto)
+        {
+#if JOSA_VISITOR_INSTRUMENT
+            detail::instrument<Hierarchy, detail::unhooked_t<F>>::count(p.ordinal());
+#endif
+            return dispatch_ordinal(p.ordinal(), std::forward<F>(f), *p, std::forward<Args>(args)...);
+        }
+
+        //  As visit, but an object of an unhandled type is not an error: try_visit then returns an
+        //  empty std::optional, or false if the handler returns void, and visit_or returns
+        //  fallback(obj, args...). Neither throws or allocates on that path.
+        //
+        template <typename F, typename... Args>
+        static auto try_visit(F&& f, const Base& obj, Args&&... args)
+        {
+            return try_visit_ordinal(lookup<F>(obj), std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename... Args>
+        static auto try_visit(F&& f, Base& obj, Args&&... args)
+        {
+            return try_visit_ordinal(lookup<F>(obj), std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename F, typename... Args>
+        static auto visit_or(Fallback&& fallback, F&& f, const Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinal_or(lookup<F>(obj), std::forward<Fallback>(fallback), std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename F, typename... Args>
+        static auto visit_or(Fallback&& fallback, F&& f, Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return visit_ordinal_or(lookup<F>(obj), std::forward<Fallback>(fallback), std::forward<F>(f), obj, std::forward<Args>(args)...);
         }
 
         static auto match(const Base& obj) -> decltype(auto)
@@ -84,40 +143,489 @@ namespace josa::visitor
             return [&obj](auto&&... fs) -> decltype(auto) {
                 return visit(overload(std::forward<decltype(fs)>(fs)...), obj); };
         }
+
+        template <std::size_t Ways>
+        static auto match(basic_inline_cache<Ways, Hierarchy>& cache, const Base& obj) -> decltype(auto)
+        {
+            return [&cache, &obj](auto&&... fs) -> decltype(auto) {
+                return visit(cache, overload(std::forward<decltype(fs)>(fs)...), obj); };
+        }
+
+        template <std::size_t Ways>
+        static auto match(basic_inline_cache<Ways, Hierarchy>& cache, Base& obj) -> decltype(auto)
+        {
+            return [&cache, &obj](auto&&... fs) -> decltype(auto) {
+                return visit(cache, overload(std::forward<decltype(fs)>(fs)...), obj); };
+        }
+
+        //  Visits every object of a range, which may hold objects of the hierarchy, (smart) pointers
+        //  to them, or tagged pointers, whose objects are grouped by the ordinals the pointers carry
+        //  without being read until they are visited. Objects are taken a cache-sized chunk at a time and grouped by concrete
+        //  type, so each handler is called in a tight loop; the order in which objects are visited is
+        //  therefore unspecified. An object of an unhandled type throws unhandled_type before any
+        //  object of its chunk is visited. PrefetchDistance is how many objects ahead to prefetch,
+        //  or 0 for none.
+        //
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename F, typename InputIt>
+        static auto visit_all(F&& f, InputIt first, InputIt last) -> void
+        {
+            const auto items = detail::batch_items<Hierarchy>(first, last);
+
+            detail::batch_visit<sizeof...(Concretes), PrefetchDistance>::run(items.data(), items.size(), batch_ordinal<F>(), batch_case(f), batch_count<F>(), nullptr);
+        }
+
+        //  As above, and writes the result for each object to out, in the order of the range.
+        //
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename F, typename InputIt, typename OutputIt>
+        static auto visit_all(F&& f, InputIt first, InputIt last, OutputIt out) -> OutputIt
+        {
+            const auto items = detail::batch_items<Hierarchy>(first, last);
+
+            using obj_t = detail::batch_item_object_t<typename decltype(items)::value_type>;
+            using result_t = decltype(detail::dispatch_case<std::is_const_v<obj_t>, F&, Base, meta::head_t<ConcreteTypeList>>
+                ::dispatch(f, std::declval<obj_t&>()));
+
+            static_assert(!std::is_void_v<result_t>, "visit_all with an output iterator needs handlers that return a value");
+
+            using batch_t = detail::batch_visit<sizeof...(Concretes), PrefetchDistance>;
+
+            auto results = detail::batch_results<result_t, OutputIt>{batch_t::chunk_size, out};
+            batch_t::run(items.data(), items.size(), batch_ordinal<F>(), batch_case(f), batch_count<F>(), results);
+
+            return results.out();
+        }
+
+        //  Visits every object of a random-access range across the given number of threads, the
+        //  calling thread included. Each thread visits with its own copy of f, so a stateful
+        //  handler needs no locking, and the copies are then combined into the result with
+        //  reduce(F, F) -> F, in an unspecified order. The threads claim grains of the range as they
+        //  go, and visit each grain as visit_all does. If a visit throws, the other threads stop at
+        //  their next grain and the exception is rethrown. A handler wrapped in its hooks is copied
+        //  and reduced unwrapped, and each copy is wrapped in turn.
+        //
+        //  The threads other than the caller's are started on every call, which takes some tens of
+        //  microseconds each: as long as visit_all takes for a few thousand objects with a light
+        //  handler. With fewer than about 2000 objects per thread, visit_all is faster.
+        //
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename F, typename RandomIt, typename Reduce>
+        static auto parallel_visit_all(const F& f, RandomIt first, RandomIt last, Reduce&& reduce,
+                                       std::size_t threads = detail::default_thread_count()) -> detail::unhooked_t<F>
+        {
+            static_assert(std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<RandomIt>::iterator_category>,
+                "parallel_visit_all needs a random-access range");
+
+            using batch_t = detail::batch_visit<sizeof...(Concretes), PrefetchDistance>;
+            using item_t = detail::batch_item_t<Hierarchy, RandomIt>;
+
+            using handler_t = detail::unhooked_t<F>;
+
+            struct worker_state
+            {
+                handler_t f;
+                decltype(batch_ordinal<F>()) ordinal;
+                std::vector<item_t> items;
+            };
+
+            const auto count = static_cast<std::size_t>(last - first);
+            const auto grain = detail::parallel_grain_size(count, std::max(threads, std::size_t{1}), batch_t::chunk_size);
+
+            threads = std::clamp(threads, std::size_t{1}, std::max(std::size_t{1}, (count + grain - 1) / grain));
+
+            auto states = std::vector<detail::padded<worker_state>>{};
+            states.reserve(threads);
+
+            for (std::size_t worker = 0; worker < threads; ++worker)
+                states.push_back({{detail::unhook(f), batch_ordinal<F>(), {}}});
+
+            detail::parallel_grains(count, grain, threads, [&](const std::size_t worker, const std::size_t begin, const std::size_t end) {
+                auto& state = states[worker].value;
+
+                state.items.clear();
+
+                for (auto i = begin; i < end; ++i)
+                    state.items.push_back(detail::batch_item<Hierarchy>(first[static_cast<std::ptrdiff_t>(i)]));
+
+                if constexpr (detail::is_hooked_v<F>)
+                {
+                    auto hooked = detail::hooked_handler<Hierarchy, handler_t&>{state.f};
+                    batch_t::run(state.items.data(), state.items.size(), state.ordinal, batch_case(hooked), batch_count<F>(), nullptr);
+                }
+                else
+                {
+                    batch_t::run(state.items.data(), state.items.size(), state.ordinal, batch_case(state.f), batch_count<F>(), nullptr);
+                }
+            });
+
+            //  Handlers such as overload sets of lambdas cannot be assigned, so each partial result
+            //  is constructed in place of the last.
+            //
+            auto result = std::optional<handler_t>{std::move(states[0].value.f)};
+
+            for (std::size_t worker = 1; worker < threads; ++worker)
+                result.emplace(reduce(std::move(*result), std::move(states[worker].value.f)));
+
+            return std::move(*result);
+        }
+
+        static auto warm_up() -> void
+        {
+            Ordinal::warm_up();
+        }
+
+    private:
+
+        //  The ordinal of the concrete type of obj, counted for visitor F if instrumentation is on.
+        //
+        template <typename F>
+        static auto lookup(const Base& obj) -> std::size_t
+        {
+#if JOSA_VISITOR_INSTRUMENT
+            return detail::instrument<Hierarchy, detail::unhooked_t<F>>::lookup([&obj] { return Ordinal::of(obj); });
+#else
+            return Ordinal::of(obj);
+#endif
+        }
+
+        template <typename F, std::size_t Ways>
+        static auto lookup(basic_inline_cache<Ways, Hierarchy>& cache, const Base& obj) -> std::size_t
+        {
+#if JOSA_VISITOR_INSTRUMENT
+            return detail::instrument<Hierarchy, detail::unhooked_t<F>>::lookup([&] { return cache.template ordinal_of<0>(obj); });
+#else
+            return cache.template ordinal_of<0>(obj);
+#endif
+        }
+
+        //  The ordinal of obj for a batch visit, whose objects are counted a chunk at a time, so
+        //  only an unhandled type is counted here.
+        //
+        template <typename F>
+        static auto checked_ordinal(const Base& obj) -> std::size_t
+        {
+            const auto i = Ordinal::of(obj);
+
+            if (i == detail::npos)
+            {
+#if JOSA_VISITOR_INSTRUMENT
+                detail::instrument<Hierarchy, detail::unhooked_t<F>>::count(i);
+#endif
+                detail::unhandled([&obj] { return detail::type_name_of<Hierarchy>(obj); });
+            }
+
+            return i;
+        }
+
+        //  Looks up ordinals for visit_all, through a small direct-mapped memo when the hierarchy
+        //  is keyed by type: a hit is one well-predicted comparison, where the shared table may
+        //  need a varying number of probes.
+        //
+        template <typename F>
+        static auto batch_ordinal()
+        {
+            if constexpr (detail::hierarchy_traits<Hierarchy>::tag_dispatch)
+            {
+                return &checked_ordinal<F>;
+            }
+#if JOSA_VISITOR_RTTI
+            else
+            {
+                return [memo = detail::batch_memo<sizeof...(Concretes)>{}](const Base& obj) mutable -> std::size_t {
+                    const auto& type = typeid(obj);
+                    auto& slot = memo.slot(&type);
+
+                    if (slot.key != &type)
+                        slot = {&type, checked_ordinal<F>(obj)};
+
+                    return slot.ordinal;
+                };
+            }
+#endif
+        }
+
+        //  Counts the objects of each chunk of a batch visit for visitor F if instrumentation is
+        //  on.
+        //
+        template <typename F>
+        static auto batch_count()
+        {
+            return [](const std::size_t* counts) {
+#if JOSA_VISITOR_INSTRUMENT
+                detail::instrument<Hierarchy, detail::unhooked_t<F>>::count_chunk(counts);
+#else
+                static_cast<void>(counts);
+#endif
+            };
+        }
+
+        template <typename F>
+        static auto batch_case(F& f)
+        {
+            return [&f](auto ordinal, auto& obj) -> decltype(auto) {
+                return detail::dispatch_case<std::is_const_v<std::remove_reference_t<decltype(obj)>>, F&, Base,
+                    meta::at_t<decltype(ordinal)::value, ConcreteTypeList>>::dispatch(f, obj); };
+        }
+
+        template <typename F, typename Obj, typename... Args>
+        using result_t = decltype(detail::dispatch_case<std::is_const_v<Obj>, F, Base, meta::head_t<ConcreteTypeList>, Args...>
+            ::dispatch(std::declval<F>(), std::declval<Obj&>(), std::declval<Args>()...));
+
+        template <typename F, typename Obj, typename... Args>
+        static auto visit_ordinal(const std::size_t i, F&& f, Obj& obj, Args&&... args) -> decltype(auto)
+        {
+            if (i == detail::npos)
+                detail::unhandled([&obj] { return detail::type_name_of<Hierarchy>(obj); });
+
+            return dispatch_ordinal(i, std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename F, typename Obj, typename... Args>
+        static auto try_visit_ordinal(const std::size_t i, F&& f, Obj& obj, Args&&... args)
+        {
+            using try_result = detail::try_result<result_t<F, Obj, Args...>>;
+
+            if (i == detail::npos)
+                return try_result::none();
+
+            return try_result::of([&]() -> result_t<F, Obj, Args...> {
+                return dispatch_ordinal(i, std::forward<F>(f), obj, std::forward<Args>(args)...); });
+        }
+
+        template <typename Fallback, typename F, typename Obj, typename... Args>
+        static auto visit_ordinal_or(const std::size_t i, Fallback&& fallback, F&& f, Obj& obj, Args&&... args) -> decltype(auto)
+        {
+            if (i == detail::npos)
+                return static_cast<result_t<F, Obj, Args...>>(std::forward<Fallback>(fallback)(obj, std::forward<Args>(args)...));
+
+            return dispatch_ordinal(i, std::forward<F>(f), obj, std::forward<Args>(args)...);
+        }
+
+        //  Calls the handler for the concrete type with ordinal i, which must be valid.
+        //
+        template <typename F, typename Obj, typename... Args>
+        static auto dispatch_ordinal(const std::size_t i, F&& f, Obj& obj, Args&&... args) -> result_t<F, Obj, Args...>
+        {
+            constexpr auto is_const = std::is_const_v<Obj>;
+
+            if constexpr (detail::hierarchy_traits<Hierarchy>::use_switch)
+            {
+                return detail::index_switch<result_t<F, Obj, Args...>, sizeof...(Concretes)>(i, [&](auto index) -> result_t<F, Obj, Args...> {
+                    using case_t = detail::dispatch_case<is_const, F, Base, meta::at_t<decltype(index)::value, ConcreteTypeList>, Args...>;
+                    static_assert(detail::case_returns_v<result_t<F, Obj, Args...>, case_t>, "every case of a visitor must return the same type");
+
+                    return case_t::dispatch(std::forward<F>(f), obj, std::forward<Args>(args)...); });
+            }
+            else
+            {
+                using maker_t = detail::dispatch_table_maker<is_const, F, Base, ConcreteTypeList, meta::list<Args...>>;
+                static constexpr auto dispatch_table = maker_t::make();
+                static_cast<void>(&detail::counted_table<maker_t, Hierarchy>::counted);
+
+                return dispatch_table[i](std::forward<F>(f), obj, std::forward<Args>(args)...);
+            }
+        }
     };
 
-    template <typename Handler, typename Base, typename... Concretes>
-    struct enable_dispatch<Handler, hierarchy<base_type<Base>, concrete_types<Concretes...>>>
+    namespace detail
     {
-        using dispatcher_t = dispatcher<hierarchy<base_type<Base>, concrete_types<Concretes...>>>;
+        template <bool Enabled, typename F, typename Obj, typename... Args>
+        struct visit_entry_result
+        {
+            using type = void;
+        };
+
+        template <typename F, typename Obj, typename... Args>
+        struct visit_entry_result<true, F, Obj, Args...> : std::invoke_result<F, Obj&, Args...> {};
+
+        //  The visit of enable_dispatch for one handler type F (const Handler& or Handler&), object
+        //  constness and list of argument types. Its function is defined outside the class, so is not
+        //  inline, and JOSA_VISITOR_EXTERN can keep a translation unit from instantiating it, and the
+        //  dispatch table behind it, for JOSA_VISITOR_INSTANTIATE to do in one other. The result type
+        //  is that of the first concrete type's case; if the handler has no such case the entry is
+        //  disabled and enable_dispatch calls the dispatcher directly, which reports the error.
+        //
+        template <typename F, bool Const, typename Hierarchy, typename... Args>
+        struct visit_entry
+        {
+            using base_t = mk_const_t<Const, typename hierarchy_traits<Hierarchy>::base_t>;
+            using head_t = mk_const_t<Const, meta::head_t<typename hierarchy_traits<Hierarchy>::concrete_types_t>>;
+
+            static constexpr bool enabled = std::is_invocable_v<F, head_t&, Args...>;
+
+            using result_t = typename visit_entry_result<enabled, F, head_t, Args...>::type;
+
+            static auto visit(F f, base_t& obj, Args&&... args) -> result_t;
+        };
+
+        template <typename F, bool Const, typename Hierarchy, typename... Args>
+        auto visit_entry<F, Const, Hierarchy, Args...>::visit(F f, base_t& obj, Args&&... args) -> result_t
+        {
+            if constexpr (enabled)
+                return dispatcher<Hierarchy>::visit(hooked<Hierarchy>(f), obj, std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename Handler, typename Base, typename... Concretes, typename... Options>
+    struct enable_dispatch<Handler, hierarchy<base_type<Base>, concrete_types<Concretes...>, Options...>>
+    {
+        using hierarchy_t = hierarchy<base_type<Base>, concrete_types<Concretes...>, Options...>;
+        using dispatcher_t = dispatcher<hierarchy_t>;
 
         template <typename... Args>
         auto visit(const Base& obj, Args&&... args) const -> decltype(auto)
         {
-            return dispatcher_t::visit(handler(), obj, std::forward<Args>(args)...);
+            return visit_by_entry<const Handler&>(handler(), obj, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         auto visit(const Base& obj, Args&&... args) -> decltype(auto)
         {
-            return dispatcher_t::visit(handler(), obj, std::forward<Args>(args)...);
+            return visit_by_entry<Handler&>(handler(), obj, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         auto visit(Base& obj, Args&&... args) const -> decltype(auto)
         {
-            return dispatcher_t::visit(handler(), obj, std::forward<Args>(args)...);       
+            return visit_by_entry<const Handler&>(handler(), obj, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         auto visit(Base& obj, Args&&... args) -> decltype(auto)
         {
-            return dispatcher_t::visit(handler(), obj, std::forward<Args>(args)...);
+            return visit_by_entry<Handler&>(handler(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename Tagged, typename = std::enable_if_t<detail::is_tagged_v<Tagged, hierarchy_t>>, typename... Args>
+        auto visit(const Tagged& p, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(hooked(), p, std::forward<Args>(args)...);
+        }
+
+        template <typename Tagged, typename = std::enable_if_t<detail::is_tagged_v<Tagged, hierarchy_t>>, typename... Args>
+        auto visit(const Tagged& p, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(hooked(), p, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy_t>& cache, const Base& obj, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy_t>& cache, const Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy_t>& cache, Base& obj, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t Ways, typename... Args>
+        auto visit(basic_inline_cache<Ways, hierarchy_t>& cache, Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit(cache, hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(const Base& obj, Args&&... args) const
+        {
+            return dispatcher_t::try_visit(hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(const Base& obj, Args&&... args)
+        {
+            return dispatcher_t::try_visit(hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(Base& obj, Args&&... args) const
+        {
+            return dispatcher_t::try_visit(hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename... Args>
+        auto try_visit(Base& obj, Args&&... args)
+        {
+            return dispatcher_t::try_visit(hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, const Base& obj, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, const Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, Base& obj, Args&&... args) const -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <typename Fallback, typename... Args>
+        auto visit_or(Fallback&& fallback, Base& obj, Args&&... args) -> decltype(auto)
+        {
+            return dispatcher_t::visit_or(std::forward<Fallback>(fallback), hooked(), obj, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename InputIt>
+        auto visit_all(InputIt first, InputIt last) const -> void
+        {
+            dispatcher_t::template visit_all<PrefetchDistance>(hooked(), first, last);
+        }
+
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename InputIt>
+        auto visit_all(InputIt first, InputIt last) -> void
+        {
+            dispatcher_t::template visit_all<PrefetchDistance>(hooked(), first, last);
+        }
+
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename InputIt, typename OutputIt>
+        auto visit_all(InputIt first, InputIt last, OutputIt out) const -> OutputIt
+        {
+            return dispatcher_t::template visit_all<PrefetchDistance>(hooked(), first, last, out);
+        }
+
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename InputIt, typename OutputIt>
+        auto visit_all(InputIt first, InputIt last, OutputIt out) -> OutputIt
+        {
+            return dispatcher_t::template visit_all<PrefetchDistance>(hooked(), first, last, out);
+        }
+
+        template <std::size_t PrefetchDistance = detail::default_prefetch_distance, typename RandomIt, typename Reduce>
+        auto parallel_visit_all(RandomIt first, RandomIt last, Reduce&& reduce,
+                                std::size_t threads = detail::default_thread_count()) const -> Handler
+        {
+            return dispatcher_t::template parallel_visit_all<PrefetchDistance>(hooked(), first, last, std::forward<Reduce>(reduce), threads);
         }
 
     private:
 
+        template <typename F, typename Obj, typename... Args>
+        static auto visit_by_entry(F f, Obj& obj, Args&&... args) -> decltype(auto)
+        {
+            using entry_t = detail::visit_entry<F, std::is_const_v<Obj>, hierarchy_t, Args...>;
+
+            if constexpr (entry_t::enabled)
+                return entry_t::visit(f, obj, std::forward<Args>(args)...);
+            else
+                return dispatcher_t::visit(detail::hooked<hierarchy_t>(f), obj, std::forward<Args>(args)...);
+        }
+
         auto handler() const -> const Handler& { return static_cast<const Handler&>(*this); }
         auto handler() -> Handler& { return static_cast<Handler&>(*this); }
+
+        auto hooked() const -> decltype(auto) { return detail::hooked<hierarchy_t>(handler()); }
+        auto hooked() -> decltype(auto) { return detail::hooked<hierarchy_t>(handler()); }
     };
 }
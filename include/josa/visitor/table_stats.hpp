@@ -0,0 +1,66 @@
+#pragma once
+#include "ordinal.hpp"
+#include <atomic>
+#include <cstddef>
+
+namespace josa::visitor
+{
+    //  Static memory used by the tables behind a dispatcher. The type lookup tables of a hierarchy
+    //  are shared by every visitor of it; a dispatch table, an array of one function pointer per
+    //  concrete type or combination of types, exists for each handler type, extra argument types
+    //  and constness of the objects that the program visits with. Dispatches through a switch need
+    //  no table.
+    //
+    struct table_stats
+    {
+        std::size_t lookup_bytes = 0;
+        std::size_t dispatch_tables = 0;
+        std::size_t dispatch_table_bytes = 0;
+
+        auto total_bytes() const -> std::size_t
+        {
+            return lookup_bytes + dispatch_table_bytes;
+        }
+    };
+
+    namespace detail
+    {
+        template <typename... Hierarchies>
+        struct dispatch_table_count
+        {
+            inline static std::atomic<std::size_t> tables{0};
+            inline static std::atomic<std::size_t> bytes{0};
+        };
+
+        //  Adds the table built by Maker to the count of its dispatcher, once, during static
+        //  initialization. Taking the address of counted where the table is used is enough for
+        //  every table in the program to be counted, whether or not it has been used yet.
+        //
+        template <typename Maker, typename... Hierarchies>
+        struct counted_table
+        {
+            inline static const bool counted = [] {
+                dispatch_table_count<Hierarchies...>::tables.fetch_add(1, std::memory_order_relaxed);
+                dispatch_table_count<Hierarchies...>::bytes.fetch_add(sizeof(decltype(Maker::make())), std::memory_order_relaxed);
+                return true;
+            }();
+        };
+    }
+
+    //  Reports the tables behind dispatcher<Hierarchies...>: the lookup tables of each hierarchy,
+    //  and the dispatch tables instantiated for that dispatcher anywhere in the program. Dispatch
+    //  tables are counted during static initialization, so the report is complete once main has
+    //  started.
+    //
+    template <typename... Hierarchies>
+    auto table_usage() -> table_stats
+    {
+        auto stats = table_stats{};
+
+        stats.lookup_bytes = (std::size_t{0} + ... + detail::hierarchy_ordinal_t<Hierarchies>::table_bytes());
+        stats.dispatch_tables = detail::dispatch_table_count<Hierarchies...>::tables.load(std::memory_order_relaxed);
+        stats.dispatch_table_bytes = detail::dispatch_table_count<Hierarchies...>::bytes.load(std::memory_order_relaxed);
+
+        return stats;
+    }
+}
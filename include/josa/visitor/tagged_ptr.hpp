@@ -0,0 +1,255 @@
+#pragma once
+#include "common.hpp"
+#include "list.hpp"
+#include "ordinal.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+//  Whether tagged pointers keep the ordinal in the upper 16 bits of the pointer, which user-space
+//  addresses leave clear on the 64-bit targets in common use; otherwise they keep it alongside.
+//  Define it as 0 where the upper bits are in use, e.g. with hardware pointer tagging (MTE,
+//  HWASan) or 5-level paging.
+//
+#if !defined(JOSA_VISITOR_TAGGED_PTR_PACKED)
+#   if UINTPTR_MAX == 0xFFFFFFFFFFFFFFFFu
+#       define JOSA_VISITOR_TAGGED_PTR_PACKED 1
+#   else
+#       define JOSA_VISITOR_TAGGED_PTR_PACKED 0
+#   endif
+#endif
+
+namespace josa::visitor
+{
+    namespace detail
+    {
+        //  Whether a type in the list other than T derives from T, so that a T* may point to an
+        //  object of another listed type.
+        //
+        template <typename T, typename List> struct has_listed_derived;
+
+        template <typename T, typename... Concretes>
+        struct has_listed_derived<T, meta::list<Concretes...>>
+            :   std::bool_constant<meta::detail::count_true({(std::is_base_of_v<T, Concretes> && !std::is_same_v<T, Concretes>)..., false}) != 0> {};
+    }
+
+    //  A pointer to an object of a hierarchy that carries the ordinal of the object's concrete type,
+    //  so that visiting it needs neither RTTI nor a read of the object to find the handler, and a
+    //  batch of them can be grouped by type touching only the pointers. The ordinal is found when
+    //  the pointer is made: from the static type of a pointer to a concrete type that no other
+    //  listed type derives from, or by one lookup of the object's dynamic type with of(). Element
+    //  is the base type or the const base type.
+    //
+    template <typename Hierarchy, typename Element = typename detail::hierarchy_traits<Hierarchy>::base_t>
+    class tagged_ptr
+    {
+        using base_t = typename detail::hierarchy_traits<Hierarchy>::base_t;
+        using concrete_types_t = typename detail::hierarchy_traits<Hierarchy>::concrete_types_t;
+
+        static_assert(std::is_same_v<std::remove_const_t<Element>, base_t>, "a tagged_ptr points to the base type of its hierarchy");
+
+    public:
+
+        using element_type = Element;
+
+        tagged_ptr() = default;
+        tagged_ptr(std::nullptr_t) {}
+
+        //  A pointer to an object whose dynamic type is T, a concrete type of the hierarchy that no
+        //  other listed type derives from; a T* to a type with listed derived types takes of().
+        //
+        template <typename T, typename = std::enable_if_t<meta::contains<std::remove_const_t<T>, concrete_types_t>::value &&
+                                                          !detail::has_listed_derived<std::remove_const_t<T>, concrete_types_t>::value>>
+        tagged_ptr(T* obj) : tagged_ptr{exactly(obj)} {}
+
+        template <typename E, typename = std::enable_if_t<std::is_const_v<Element> && !std::is_const_v<E>>>
+        tagged_ptr(const tagged_ptr<Hierarchy, E>& p) : tagged_ptr{p.get(), p.ordinal()} {}
+
+        //  A pointer to an object of any concrete type of the hierarchy, whose type is looked up
+        //  once, here; an unhandled type is an error as it is for dispatcher::visit.
+        //
+        static auto of(Element& obj) -> tagged_ptr
+        {
+            const auto i = detail::hierarchy_ordinal_t<Hierarchy>::of(obj);
+
+            if (i == detail::npos)
+                detail::unhandled([&obj] { return detail::type_name_of<Hierarchy>(obj); });
+
+            return {&obj, i};
+        }
+
+        //  A pointer to an object whose dynamic type is exactly T, a concrete type of the hierarchy,
+        //  as when the caller has just made it; checked only by an assert.
+        //
+        template <typename T, typename = std::enable_if_t<meta::contains<std::remove_const_t<T>, concrete_types_t>::value>>
+        static auto exactly(T* obj) -> tagged_ptr
+        {
+            constexpr auto ordinal = meta::index_of<std::remove_const_t<T>, concrete_types_t>::value;
+
+            assert((!obj || detail::hierarchy_ordinal_t<Hierarchy>::of(*obj) == ordinal) && "object is not exactly of the pointer's type");
+
+            return {static_cast<Element*>(obj), ordinal};
+        }
+
+        auto get() const -> Element*
+        {
+#if JOSA_VISITOR_TAGGED_PTR_PACKED
+            return reinterpret_cast<Element*>(bits_ & address_mask);
+#else
+            return ptr_;
+#endif
+        }
+
+        //  The ordinal of the object's concrete type; unspecified for a null pointer.
+        //
+        auto ordinal() const -> std::size_t
+        {
+#if JOSA_VISITOR_TAGGED_PTR_PACKED
+            return static_cast<std::size_t>(bits_ >> address_bits);
+#else
+            return ordinal_;
+#endif
+        }
+
+        auto operator*() const -> Element& { return *get(); }
+        auto operator->() const -> Element* { return get(); }
+
+        explicit operator bool() const { return get() != nullptr; }
+
+        friend auto operator==(const tagged_ptr& a, const tagged_ptr& b) -> bool { return a.get() == b.get(); }
+        friend auto operator!=(const tagged_ptr& a, const tagged_ptr& b) -> bool { return a.get() != b.get(); }
+
+    private:
+
+        tagged_ptr(Element* obj, const std::size_t ordinal)
+#if JOSA_VISITOR_TAGGED_PTR_PACKED
+            : bits_{reinterpret_cast<std::uintptr_t>(obj) | static_cast<std::uintptr_t>(ordinal) << address_bits}
+        {
+            assert((reinterpret_cast<std::uintptr_t>(obj) & ~address_mask) == 0 && "address uses the bits of a tagged_ptr's ordinal");
+        }
+#else
+            : ptr_{obj}, ordinal_{ordinal} {}
+#endif
+
+#if JOSA_VISITOR_TAGGED_PTR_PACKED
+        static constexpr unsigned address_bits = 48;
+        static constexpr std::uintptr_t address_mask = (std::uintptr_t{1} << address_bits) - 1;
+
+        static_assert(detail::hierarchy_traits<Hierarchy>::size <= (std::size_t{1} << (64 - address_bits)),
+            "too many concrete types for the bits of a tagged_ptr");
+
+        std::uintptr_t bits_ = 0;
+#else
+        Element* ptr_ = nullptr;
+        std::size_t ordinal_ = 0;
+#endif
+    };
+
+    //  A std::unique_ptr to an object of a hierarchy that carries the ordinal of its concrete type,
+    //  as tagged_ptr does. The object is deleted through the base type.
+    //
+    template <typename Hierarchy>
+    class tagged_unique_ptr
+    {
+        using base_t = typename detail::hierarchy_traits<Hierarchy>::base_t;
+
+    public:
+
+        using element_type = base_t;
+
+        tagged_unique_ptr() = default;
+        tagged_unique_ptr(std::nullptr_t) {}
+
+        template <typename T, typename = std::enable_if_t<std::is_constructible_v<tagged_ptr<Hierarchy>, T*>>>
+        tagged_unique_ptr(std::unique_ptr<T> obj) : ptr_{obj.release()} {}
+
+        tagged_unique_ptr(tagged_unique_ptr&& other) noexcept : ptr_{std::exchange(other.ptr_, nullptr)} {}
+
+        auto operator=(tagged_unique_ptr&& other) noexcept -> tagged_unique_ptr&
+        {
+            reset(std::exchange(other.ptr_, nullptr));
+            return *this;
+        }
+
+        ~tagged_unique_ptr()
+        {
+            static_assert(std::has_virtual_destructor_v<base_t>, "the base type of a tagged_unique_ptr needs a virtual destructor");
+
+            delete ptr_.get();
+        }
+
+        //  Takes ownership of an object of any concrete type of the hierarchy, looking up its type
+        //  once, here.
+        //
+        static auto of(std::unique_ptr<base_t> obj) -> tagged_unique_ptr
+        {
+            auto p = tagged_unique_ptr{};
+
+            if (obj)
+                p.ptr_ = tagged_ptr<Hierarchy>::of(*obj);
+
+            obj.release();
+            return p;
+        }
+
+        auto get() const -> base_t* { return ptr_.get(); }
+        auto ordinal() const -> std::size_t { return ptr_.ordinal(); }
+        auto tagged() const -> tagged_ptr<Hierarchy> { return ptr_; }
+
+        auto operator*() const -> base_t& { return *ptr_; }
+        auto operator->() const -> base_t* { return ptr_.get(); }
+
+        explicit operator bool() const { return static_cast<bool>(ptr_); }
+
+        auto release() -> base_t*
+        {
+            return std::exchange(ptr_, nullptr).get();
+        }
+
+        auto reset(tagged_ptr<Hierarchy> obj = nullptr) -> void
+        {
+            delete std::exchange(ptr_, obj).get();
+        }
+
+    private:
+
+        tagged_ptr<Hierarchy> ptr_;
+    };
+
+    //  Makes an object of concrete type T owned by a tagged_unique_ptr.
+    //
+    template <typename Hierarchy, typename T, typename... Args>
+    auto make_tagged(Args&&... args) -> tagged_unique_ptr<Hierarchy>
+    {
+        auto p = tagged_unique_ptr<Hierarchy>{};
+        p.reset(tagged_ptr<Hierarchy>::exactly(std::make_unique<T>(std::forward<Args>(args)...).release()));
+
+        return p;
+    }
+
+    namespace detail
+    {
+        template <typename T, typename Hierarchy>
+        struct is_tagged : std::false_type {};
+
+        template <typename Hierarchy, typename Element>
+        struct is_tagged<tagged_ptr<Hierarchy, Element>, Hierarchy> : std::true_type {};
+
+        template <typename Hierarchy>
+        struct is_tagged<tagged_unique_ptr<Hierarchy>, Hierarchy> : std::true_type {};
+
+        //  Whether T is a tagged_ptr or tagged_unique_ptr of the hierarchy.
+        //
+        template <typename T, typename Hierarchy>
+        inline constexpr bool is_tagged_v = is_tagged<std::remove_cv_t<std::remove_reference_t<T>>, Hierarchy>::value;
+
+        template <typename Hierarchy, typename Element>
+        auto tagged_of(const tagged_ptr<Hierarchy, Element>& p) -> tagged_ptr<Hierarchy, Element> { return p; }
+
+        template <typename Hierarchy>
+        auto tagged_of(const tagged_unique_ptr<Hierarchy>& p) -> tagged_ptr<Hierarchy> { return p.tagged(); }
+    }
+}
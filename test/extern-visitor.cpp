@@ -0,0 +1,6 @@
+#include "extern-visitor.hpp"
+
+JOSA_VISITOR_INSTANTIATE(ShapeNamer, ShapeHierarchy);
+JOSA_VISITOR_INSTANTIATE(ShapeNamer, ShapeHierarchy, const std::string&);
+JOSA_VISITOR_INSTANTIATE(ShapeNamer, ShapeHierarchy, std::string);
+JOSA_VISITOR_INSTANTIATE(ShapeCounter, ShapeHierarchy);
@@ -0,0 +1,31 @@
+#pragma once
+#include <josa/visitor.hpp>
+#include "types.hpp"
+#include <string>
+
+//  Visitors whose dispatch is instantiated in extern-visitor.cpp only.
+//
+struct ShapeNamer : josa::visitor::enable_dispatch<ShapeNamer, ShapeHierarchy>
+{
+    auto operator () (const Square&) const -> std::string { return "square"; }
+    auto operator () (const Circle&) const -> std::string { return "circle"; }
+    auto operator () (const Square&, const std::string& prefix) const -> std::string { return prefix + "square"; }
+    auto operator () (const Circle&, const std::string& prefix) const -> std::string { return prefix + "circle"; }
+};
+
+//  Handles non-const shapes only, with a non-const call operator, so only one of the four
+//  combinations JOSA_VISITOR_EXTERN covers applies to it.
+//
+struct ShapeCounter : josa::visitor::enable_dispatch<ShapeCounter, ShapeHierarchy>
+{
+    auto operator () (Square&) -> void { ++squares; }
+    auto operator () (Circle&) -> void { ++circles; }
+
+    int squares = 0;
+    int circles = 0;
+};
+
+JOSA_VISITOR_EXTERN(ShapeNamer, ShapeHierarchy);
+JOSA_VISITOR_EXTERN(ShapeNamer, ShapeHierarchy, const std::string&);
+JOSA_VISITOR_EXTERN(ShapeNamer, ShapeHierarchy, std::string);
+JOSA_VISITOR_EXTERN(ShapeCounter, ShapeHierarchy);
@@ -1,7 +1,10 @@
 #include <josa/visitor.hpp>
 #include "types.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace jv = josa::visitor;
@@ -250,4 +253,368 @@ TEST_CASE("visitor double dispatch (non-const, non-const)")
     );
 
     CHECK(t == true);
-}
\ No newline at end of file
+}
+TEST_CASE("visitor double dispatch with hierarchies of different sizes")
+{
+    using namespace MathAst;
+    using Dispatcher = jv::dispatcher<ColorHierarchy, MathAst::Hierarchy>;
+
+    const auto f = jv::overload
+    (
+        [](const Red&, const Value&)    { return "red value"s; },
+        [](const Red&, const Negate&)   { return "red negate"s; },
+        [](const Red&, const Plus&)     { return "red plus"s; },
+        [](const Red&, const Times&)    { return "red times"s; },
+        [](const Blue&, const Value&)   { return "blue value"s; },
+        [](const Blue&, const Negate&)  { return "blue negate"s; },
+        [](const Blue&, const Plus&)    { return "blue plus"s; },
+        [](const Blue&, const Times&)   { return "blue times"s; }
+    );
+
+    const auto red = Red{};
+    const auto blue = Blue{};
+    const auto pValue = value(1);
+    const auto pTimes = times(value(1), value(2));
+
+    CHECK(Dispatcher::visit(f, red, *pValue) == "red value");
+    CHECK(Dispatcher::visit(f, red, *pTimes) == "red times");
+    CHECK(Dispatcher::visit(f, blue, *pValue) == "blue value");
+    CHECK(Dispatcher::visit(f, blue, *pTimes) == "blue times");
+}
+
+TEST_CASE("visitor double dispatch through a table")
+{
+    using namespace MathAst;
+    using TableColorHierarchy = jv::hierarchy<jv::base_type<Color>, jv::concrete_types<Red, Blue>, jv::table_dispatch>;
+    using Dispatcher = jv::dispatcher<TableColorHierarchy, MathAst::Hierarchy>;
+
+    const auto f = jv::overload
+    (
+        [](const Red&, const Expr&)     { return "red expr"s; },
+        [](const Blue&, const Value&)   { return "blue value"s; },
+        [](const Blue&, const Expr&)    { return "blue expr"s; }
+    );
+
+    const auto pValue = value(1);
+    const auto pPlus = plus(value(1), value(2));
+
+    CHECK(Dispatcher::visit(f, Red{}, *pPlus) == "red expr");
+    CHECK(Dispatcher::visit(f, Blue{}, *pValue) == "blue value");
+    CHECK(Dispatcher::visit(f, Blue{}, *pPlus) == "blue expr");
+}
+
+TEST_CASE("double dispatch with an inline cache")
+{
+    struct ColorShapeNamer : jv::enable_dispatch<ColorShapeNamer, ColorHierarchy, ShapeHierarchy>
+    {
+        auto operator()(const Red&, const Square&) const -> std::string { return "red square"s; }
+        auto operator()(const Red&, const Circle&) const -> std::string { return "red circle"s; }
+        auto operator()(const Blue&, const Shape&) const -> std::string { return "blue shape"s; }
+    };
+
+    jv::inline_cache<ColorHierarchy, ShapeHierarchy> cache;
+
+    const auto red = Red{};
+    const auto blue = Blue{};
+    const auto circle = Circle{};
+
+    const ColorShapeNamer visitor;
+
+    CHECK(visitor.visit(cache, red, circle) == "red circle"s);
+    CHECK(visitor.visit(cache, red, circle) == "red circle"s);
+    CHECK(visitor.visit(cache, blue, circle) == "blue shape"s);
+
+    //  Each visit looks up one type per hierarchy
+    //
+    CHECK(cache.misses() == 3);
+    CHECK(cache.hits() == 3);
+
+    const auto t = jv::dispatcher<ColorHierarchy, ShapeHierarchy>::match(cache, red, circle)
+    (
+        [](const Red&, const Circle&)   { return true; },
+        [](const Color&, const Shape&)  { return false; }
+    );
+
+    CHECK(t == true);
+    CHECK(cache.hits() == 5);
+}
+
+TEST_CASE("warm_up a double dispatcher")
+{
+    using Dispatcher = jv::dispatcher<ColorHierarchy, ShapeHierarchy>;
+
+    jv::warm_up<Dispatcher>();
+    jv::warm_up<ShapeHierarchy>();
+
+    const auto t = Dispatcher::match(Blue{}, Square{})
+    (
+        [](const Blue&, const Square&)  { return true; },
+        [](const Color&, const Shape&)  { return false; }
+    );
+
+    CHECK(t == true);
+}
+
+TEST_CASE("double dispatch try_visit and visit_or")
+{
+    struct ColorShapeNamer : jv::enable_dispatch<ColorShapeNamer, ColorHierarchy, ShapeHierarchy>
+    {
+        auto operator()(const Red&, const Square&) const -> std::string  { return "red square"s; }
+        auto operator()(const Red&, const Circle&) const -> std::string  { return "red circle"s; }
+        auto operator()(const Blue&, const Square&) const -> std::string { return "blue square"s; }
+        auto operator()(const Blue&, const Circle&) const -> std::string { return "blue circle"s; }
+    };
+
+    const auto red = Red{};
+    const auto circle = Circle{};
+    const auto bad = BadShape{};
+
+    const auto named = ColorShapeNamer{}.try_visit(red, circle);
+    REQUIRE(named.has_value());
+    CHECK(*named == "red circle"s);
+    CHECK_FALSE(ColorShapeNamer{}.try_visit(red, bad).has_value());
+
+    const auto unknown = [](const Color&, const Shape&) { return "unknown"s; };
+    CHECK(ColorShapeNamer{}.visit_or(unknown, red, circle) == "red circle"s);
+    CHECK(ColorShapeNamer{}.visit_or(unknown, red, bad) == "unknown"s);
+
+    auto visited = 0;
+    const auto count = jv::overload([&](const Color&, const Square&) { ++visited; }, [&](const Color&, const Circle&) { ++visited; });
+
+    CHECK(jv::dispatcher<ColorHierarchy, ShapeHierarchy>::try_visit(count, red, circle));
+    CHECK_FALSE(jv::dispatcher<ColorHierarchy, ShapeHierarchy>::try_visit(count, red, bad));
+    CHECK(visited == 1);
+}
+
+namespace
+{
+    //  Message and state hierarchies where most pairs select a few catch-all overloads
+    //
+    struct Message { virtual ~Message() = default; };
+    struct ControlMessage : Message {};
+    struct DataMessage : Message {};
+
+    struct Ping final : ControlMessage {};
+    struct Pong final : ControlMessage {};
+    struct Text final : DataMessage {};
+    struct Binary final : DataMessage {};
+    struct Chunk final : DataMessage {};
+    struct Orphan final : Message {};
+
+    struct State { virtual ~State() = default; };
+    struct Idle final : State {};
+    struct Busy final : State {};
+    struct Closed final : State {};
+
+    using MessageHierarchy = jv::hierarchy
+    <
+        jv::base_type<Message>,
+        jv::concrete_types<Ping, Text, Pong, Binary, Orphan, Chunk>,
+        jv::table_dispatch
+    >;
+
+    using StateHierarchy = jv::hierarchy<jv::base_type<State>, jv::concrete_types<Idle, Busy, Closed>, jv::table_dispatch>;
+
+    struct Router : jv::enable_dispatch<Router, MessageHierarchy, StateHierarchy>
+    {
+        using overload_types = jv::overload_types<jv::types<ControlMessage, DataMessage>, jv::types<Closed>>;
+
+        auto operator()(const Message&, const State&) const -> std::string { return "other"s; }
+        auto operator()(const ControlMessage&, const State&) const -> std::string { return "control"s; }
+        auto operator()(const DataMessage&, const State&) const -> std::string { return "data"s; }
+        auto operator()(const DataMessage&, const Closed&) const -> std::string { return "data, closed"s; }
+    };
+}
+
+TEST_CASE("double dispatch through classes of types declared by overload_types")
+{
+    const auto router = Router{};
+
+    CHECK(router.visit(Ping{}, Idle{}) == "control"s);
+    CHECK(router.visit(Pong{}, Closed{}) == "control"s);
+    CHECK(router.visit(Text{}, Busy{}) == "data"s);
+    CHECK(router.visit(Chunk{}, Closed{}) == "data, closed"s);
+    CHECK(router.visit(Binary{}, Closed{}) == "data, closed"s);
+    CHECK(router.visit(Orphan{}, Closed{}) == "other"s);
+    CHECK(router.visit(Orphan{}, Idle{}) == "other"s);
+
+    //  3 classes of messages (control, data, other) by 2 of states (closed, other), instead of
+    //  6 by 3 concrete types
+    //
+    const auto stats = jv::table_usage<MessageHierarchy, StateHierarchy>();
+
+    CHECK(stats.dispatch_tables == 1);
+    CHECK(stats.dispatch_table_bytes == 3 * 2 * sizeof(void(*)()));
+}
+
+namespace
+{
+    struct Body { virtual ~Body() = default; };
+    struct Ball final : Body {};
+    struct Box final : Body {};
+    struct Wall final : Body {};
+
+    using BodyHierarchy = jv::hierarchy<jv::base_type<Body>, jv::concrete_types<Ball, Box, Wall>, jv::table_dispatch>;
+
+    struct Collide : jv::enable_dispatch<Collide, BodyHierarchy, BodyHierarchy>
+    {
+        static constexpr bool symmetric = true;
+
+        auto operator()(const Ball&, const Ball&, int& calls) const -> std::string { ++calls; return "ball, ball"s; }
+        auto operator()(const Ball&, const Box&, int& calls) const -> std::string { ++calls; return "ball, box"s; }
+        auto operator()(const Ball&, const Wall&, int& calls) const -> std::string { ++calls; return "ball, wall"s; }
+        auto operator()(const Box&, const Body&, int& calls) const -> std::string { ++calls; return "box, body"s; }
+        auto operator()(const Wall&, const Wall&, int& calls) const -> std::string { ++calls; return "wall, wall"s; }
+    };
+}
+
+TEST_CASE("symmetric double dispatch")
+{
+    const auto collide = Collide{};
+    auto calls = 0;
+
+    CHECK(collide.visit(Ball{}, Ball{}, calls) == "ball, ball"s);
+    CHECK(collide.visit(Ball{}, Box{}, calls) == "ball, box"s);
+    CHECK(collide.visit(Box{}, Ball{}, calls) == "ball, box"s);
+    CHECK(collide.visit(Wall{}, Ball{}, calls) == "ball, wall"s);
+    CHECK(collide.visit(Box{}, Wall{}, calls) == "box, body"s);
+    CHECK(collide.visit(Wall{}, Box{}, calls) == "box, body"s);
+    CHECK(collide.visit(Wall{}, Wall{}, calls) == "wall, wall"s);
+    CHECK(calls == 7);
+
+    //  6 pairs of 3 types in either order, instead of 9
+    //
+    const auto stats = jv::table_usage<BodyHierarchy, BodyHierarchy>();
+
+    CHECK(stats.dispatch_tables == 1);
+    CHECK(stats.dispatch_table_bytes == 6 * sizeof(void(*)()));
+}
+
+namespace
+{
+    //  Listed in another order, so that the tables counted are only those of Sparse
+    //
+    using SparseStateHierarchy = jv::hierarchy<jv::base_type<State>, jv::concrete_types<Closed, Idle, Busy>, jv::table_dispatch>;
+
+    struct Sparse : jv::enable_dispatch<Sparse, MessageHierarchy, SparseStateHierarchy>
+    {
+        using handled_pairs = jv::handled_pairs<jv::types<Ping, Idle>, jv::types<Text, Closed>, jv::types<Orphan, Busy>>;
+
+        auto operator()(const Ping&, const Idle&) const -> std::string { return "ping, idle"s; }
+        auto operator()(const DataMessage&, const Closed&) const -> std::string { return "data, closed"s; }
+        auto operator()(const Orphan&, const Busy&) const -> std::string { return "orphan, busy"s; }
+        auto operator()(const Message&, const State&) const -> std::string { return "default"s; }
+    };
+}
+
+TEST_CASE("sparse double dispatch through handled_pairs")
+{
+    const auto sparse = Sparse{};
+
+    CHECK(sparse.visit(Ping{}, Idle{}) == "ping, idle"s);
+    CHECK(sparse.visit(Text{}, Closed{}) == "data, closed"s);
+    CHECK(sparse.visit(Orphan{}, Busy{}) == "orphan, busy"s);
+    CHECK(sparse.visit(Ping{}, Busy{}) == "default"s);
+    CHECK(sparse.visit(Chunk{}, Closed{}) == "default"s);
+    CHECK(sparse.try_visit(Pong{}, Idle{}) == "default"s);
+
+    //  A table numbering the dispatch function of each of the 6 x 3 pairs, and one of the 3
+    //  listed pairs and the default
+    //
+    const auto stats = jv::table_usage<MessageHierarchy, SparseStateHierarchy>();
+
+    CHECK(stats.dispatch_tables == 2);
+    CHECK(stats.dispatch_table_bytes == 6 * 3 + 4 * sizeof(void(*)()));
+}
+
+namespace
+{
+    struct PairCounter
+    {
+        auto operator()(const Red&, const Square&) -> void { ++red_squares; }
+        auto operator()(const Color&, const Shape&) -> void { ++others; }
+
+        int red_squares = 0;
+        int others = 0;
+    };
+
+    struct Touch
+    {
+        static constexpr bool symmetric = true;
+
+        auto operator()(const Ball&, const Box&) -> void { ++ball_box; }
+        auto operator()(const Body&, const Body&) -> void { ++other; }
+
+        int ball_box = 0;
+        int other = 0;
+    };
+}
+
+TEST_CASE("visit_pairs over the cross product of two ranges")
+{
+    using Dispatcher = jv::dispatcher<ColorHierarchy, ShapeHierarchy>;
+
+    auto colors = std::vector<std::unique_ptr<Color>>{};
+    auto shapes = std::vector<std::unique_ptr<Shape>>{};
+
+    for (auto i = 0; i < 300; ++i)
+    {
+        colors.push_back(i % 3 == 0 ? std::unique_ptr<Color>{std::make_unique<Red>()} : std::make_unique<Blue>());
+        shapes.push_back(i % 2 == 0 ? std::unique_ptr<Shape>{std::make_unique<Square>()} : std::make_unique<Circle>());
+    }
+
+    auto counter = PairCounter{};
+    Dispatcher::visit_pairs(counter, colors.begin(), colors.end(), shapes.begin(), shapes.end());
+
+    CHECK(counter.red_squares == 100 * 150);
+    CHECK(counter.others == 300 * 300 - 100 * 150);
+
+    const auto sum = Dispatcher::parallel_visit_pairs(PairCounter{}, colors.begin(), colors.end(), shapes.begin(), shapes.end(),
+        [](PairCounter a, const PairCounter& b) { a.red_squares += b.red_squares; a.others += b.others; return a; }, 3);
+
+    CHECK(sum.red_squares == counter.red_squares);
+    CHECK(sum.others == counter.others);
+
+    shapes.push_back(std::make_unique<BadShape>());
+    counter = PairCounter{};
+
+    CHECK_THROWS_AS(Dispatcher::visit_pairs(counter, colors.begin(), colors.end(), shapes.begin(), shapes.end()), jv::unhandled_type);
+    CHECK(counter.red_squares + counter.others == 0);
+}
+
+TEST_CASE("visit_pairs over a list of pairs")
+{
+    using Dispatcher = jv::dispatcher<ColorHierarchy, ShapeHierarchy>;
+
+    const auto red = Red{};
+    const auto blue = Blue{};
+    const auto square = Square{};
+    const auto circle = Circle{};
+
+    const auto pairs = std::vector<std::pair<const Color*, const Shape*>>
+        {{&red, &square}, {&blue, &square}, {&red, &circle}, {&red, &square}, {&blue, &circle}};
+
+    auto names = std::vector<std::string>{};
+
+    Dispatcher::visit_pairs(jv::overload(
+        [&](const Red&, const Square&) { names.push_back("red square"s); },
+        [&](const Color&, const Shape&) { names.push_back("other"s); }), pairs.begin(), pairs.end());
+
+    std::sort(names.begin(), names.end());
+
+    CHECK(names == std::vector{"other"s, "other"s, "other"s, "red square"s, "red square"s});
+
+    //  A symmetric handler is dispatched pair by pair
+    //
+    const auto ball = Ball{};
+    const auto box = Box{};
+    const auto bodies = std::vector<std::pair<const Body*, const Body*>>{{&box, &ball}, {&ball, &box}, {&box, &box}};
+    auto touch = Touch{};
+
+    using TouchHierarchy = jv::hierarchy<jv::base_type<Body>, jv::concrete_types<Ball, Box, Wall>>;
+
+    jv::dispatcher<TouchHierarchy, TouchHierarchy>::visit_pairs(touch, bodies.begin(), bodies.end());
+
+    CHECK(touch.ball_box == 2);
+    CHECK(touch.other == 1);
+}
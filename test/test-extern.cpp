@@ -0,0 +1,31 @@
+#include "extern-visitor.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+
+TEST_CASE("visitor dispatch instantiated in another translation unit")
+{
+    std::vector<std::unique_ptr<Shape>> shapeVec;
+
+    shapeVec.push_back(std::make_unique<Square>());
+    shapeVec.push_back(std::make_unique<Circle>());
+    shapeVec.push_back(std::make_unique<Circle>());
+
+    const auto namer = ShapeNamer{};
+    const auto prefix = std::string{"a "};
+    auto counter = ShapeCounter{};
+
+    CHECK(namer.visit(*shapeVec[0]) == "square");
+    CHECK(ShapeNamer{}.visit(static_cast<const Shape&>(*shapeVec[1])) == "circle");
+    CHECK(namer.visit(*shapeVec[0], prefix) == "a square");
+    CHECK(namer.visit(*shapeVec[1], std::string{"the "}) == "the circle");
+
+    for (const auto& pShape : shapeVec)
+        counter.visit(*pShape);
+
+    CHECK(counter.squares == 1);
+    CHECK(counter.circles == 2);
+
+    const auto badShape = BadShape{};
+    CHECK_THROWS_AS(namer.visit(badShape), josa::visitor::unhandled_type);
+}
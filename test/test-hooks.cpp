@@ -0,0 +1,269 @@
+#include <josa/visitor.hpp>
+#include "types.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace jv = josa::visitor;
+
+namespace
+{
+    //  (hook, ordinal, depth) of each hook call, with hook 'b' for before and 'a' for after.
+    //
+    std::vector<std::tuple<char, std::size_t, std::size_t>> hookCalls;
+
+    struct RecordingHooks
+    {
+        template <typename Handler, typename Hierarchy>
+        static auto before(const std::size_t ordinal, const std::size_t depth) -> void
+        {
+            hookCalls.emplace_back('b', ordinal, depth);
+        }
+
+        template <typename Handler, typename Hierarchy>
+        static auto after(const std::size_t ordinal, const std::size_t depth) -> void
+        {
+            hookCalls.emplace_back('a', ordinal, depth);
+        }
+    };
+
+    //  Safe to call from several threads.
+    //
+    struct CountingHooks
+    {
+        static inline std::atomic<int> befores{0};
+        static inline std::atomic<int> afters{0};
+
+        template <typename Handler, typename Hierarchy>
+        static auto before(std::size_t, std::size_t) -> void { ++befores; }
+
+        template <typename Handler, typename Hierarchy>
+        static auto after(std::size_t, std::size_t) -> void { ++afters; }
+    };
+
+    //  Records like RecordingHooks, but before throws while throwBefore is set.
+    //
+    struct ThrowingHooks
+    {
+        static inline bool throwBefore = false;
+
+        template <typename Handler, typename Hierarchy>
+        static auto before(const std::size_t ordinal, const std::size_t depth) -> void
+        {
+            if (throwBefore)
+                throw std::runtime_error{"before"};
+
+            RecordingHooks::before<Handler, Hierarchy>(ordinal, depth);
+        }
+
+        template <typename Handler, typename Hierarchy>
+        static auto after(const std::size_t ordinal, const std::size_t depth) -> void
+        {
+            RecordingHooks::after<Handler, Hierarchy>(ordinal, depth);
+        }
+    };
+
+    template <typename Hooks>
+    struct HookedEvaluator : jv::enable_dispatch<HookedEvaluator<Hooks>, MathAst::Hierarchy>
+    {
+        using visit_hooks = Hooks;
+
+        auto operator()(const MathAst::Value& node) const -> int { return node.value(); }
+        auto operator()(const MathAst::Negate& node) const -> int { return -this->visit(node.expr()); }
+        auto operator()(const MathAst::Plus& node) const -> int { return this->visit(node.expr1()) + this->visit(node.expr2()); }
+        auto operator()(const MathAst::Times& node) const -> int { return this->visit(node.expr1()) * this->visit(node.expr2()); }
+    };
+}
+
+TEST_CASE("visit hooks run around each handler with the ordinal and depth")
+{
+    using namespace MathAst;
+    const auto pExpr = negate(plus(value(3), value(4)));
+
+    hookCalls.clear();
+    CHECK(HookedEvaluator<RecordingHooks>{}.visit(*pExpr) == -7);
+
+    using call = std::tuple<char, std::size_t, std::size_t>;
+
+    CHECK(hookCalls == std::vector<call>{
+        {'b', 1, 0}, {'b', 2, 1}, {'b', 0, 2}, {'a', 0, 2}, {'b', 0, 2}, {'a', 0, 2}, {'a', 2, 1}, {'a', 1, 0}});
+
+    hookCalls.clear();
+    CHECK(HookedEvaluator<RecordingHooks>{}.try_visit(*value(5)) == 5);
+    CHECK(hookCalls.size() == 2);
+}
+
+TEST_CASE("visit hooks keep the depth when before throws")
+{
+    using namespace MathAst;
+    const auto pExpr = value(5);
+
+    hookCalls.clear();
+    ThrowingHooks::throwBefore = true;
+    CHECK_THROWS_AS(HookedEvaluator<ThrowingHooks>{}.visit(*pExpr), std::runtime_error);
+    ThrowingHooks::throwBefore = false;
+
+    CHECK(HookedEvaluator<ThrowingHooks>{}.visit(*pExpr) == 5);
+
+    using call = std::tuple<char, std::size_t, std::size_t>;
+
+    CHECK(hookCalls == std::vector<call>{{'b', 0, 0}, {'a', 0, 0}});
+}
+
+TEST_CASE("visit hooks run around each handler of a batch visit")
+{
+    using namespace MathAst;
+
+    auto exprs = std::vector<ExprPtr>{};
+
+    for (int i = 0; i < 1000; ++i)
+        exprs.push_back(i % 2 ? value(i) : negate(value(i)));
+
+    auto evaluator = HookedEvaluator<CountingHooks>{};
+
+    evaluator.visit_all(exprs.begin(), exprs.end());
+
+    CHECK(CountingHooks::befores == 1500);
+    CHECK(CountingHooks::afters == 1500);
+
+    auto results = std::vector<int>{};
+    evaluator.visit_all(exprs.begin(), exprs.end(), std::back_inserter(results));
+
+    CHECK(results.size() == 1000);
+    CHECK(CountingHooks::befores == 3000);
+
+    const auto reduce = [](HookedEvaluator<CountingHooks> a, const HookedEvaluator<CountingHooks>&) { return a; };
+    evaluator.parallel_visit_all(exprs.begin(), exprs.end(), reduce, 2);
+
+    CHECK(CountingHooks::befores == 4500);
+    CHECK(CountingHooks::afters == 4500);
+}
+
+TEST_CASE("profile hooks record latency histograms and a Chrome trace")
+{
+    using namespace MathAst;
+    const auto pExpr = times(value(2), plus(value(3), value(4)));
+
+    jv::profile_hooks::start_trace();
+
+    for (int i = 0; i < 10; ++i)
+        CHECK(HookedEvaluator<jv::profile_hooks>{}.visit(*pExpr) == 14);
+
+    jv::profile_hooks::stop_trace();
+
+    auto counts = std::vector<std::pair<std::string, std::uint64_t>>{};
+
+    for (const auto& latency : jv::profile_hooks::latencies())
+    {
+        if (latency.visitor.find("HookedEvaluator") != std::string::npos)
+        {
+            counts.emplace_back(latency.type, latency.histogram->count());
+            CHECK(latency.histogram->percentile(50) <= latency.histogram->percentile(99));
+            CHECK(latency.histogram->percentile(100) == latency.histogram->max());
+        }
+    }
+
+    CHECK(counts == std::vector<std::pair<std::string, std::uint64_t>>{
+        {"MathAst::Value", 30}, {"MathAst::Negate", 0}, {"MathAst::Plus", 10}, {"MathAst::Times", 10}});
+
+    const auto path = std::string{"josa-visitor-test-trace.json"};
+    REQUIRE(jv::profile_hooks::write_trace(path.c_str()));
+
+    auto file = std::ifstream{path};
+    const auto trace = std::string{std::istreambuf_iterator<char>{file}, {}};
+    file.close();
+    std::remove(path.c_str());
+
+    CHECK(trace.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n{\"name\":\"MathAst::Value\"", 0) == 0);
+    CHECK(trace.find("\"ph\":\"X\"") != std::string::npos);
+    CHECK(trace.find("\"args\":{\"depth\":1}") != std::string::npos);
+
+#if defined(__linux__)
+    CHECK_FALSE(jv::profile_hooks::write_trace("/dev/full"));
+#endif
+    CHECK_FALSE(jv::profile_hooks::write_trace("no-such-directory/trace.json"));
+
+    jv::profile_hooks::clear_trace();
+}
+
+namespace
+{
+    auto tracedEvents() -> std::size_t
+    {
+        const auto path = std::string{"josa-visitor-test-budget.json"};
+        REQUIRE(jv::profile_hooks::write_trace(path.c_str()));
+
+        auto file = std::ifstream{path};
+        const auto trace = std::string{std::istreambuf_iterator<char>{file}, {}};
+        file.close();
+        std::remove(path.c_str());
+
+        auto events = std::size_t{0};
+
+        for (auto i = trace.find("\"ph\":\"X\""); i != std::string::npos; i = trace.find("\"ph\":\"X\"", i + 1))
+            ++events;
+
+        return events;
+    }
+}
+
+TEST_CASE("profile trace keeps at most max_events across all threads")
+{
+    using namespace MathAst;
+    const auto pExpr = times(value(2), plus(value(3), value(4)));
+    const auto visit = [&] {
+        for (int i = 0; i < 10; ++i)
+            HookedEvaluator<jv::profile_hooks>{}.visit(*pExpr);
+    };
+
+    jv::profile_hooks::start_trace(7);
+
+    auto threads = std::vector<std::thread>{};
+    for (int i = 0; i < 3; ++i)
+        threads.emplace_back(visit);
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(tracedEvents() == 7);
+
+    jv::profile_hooks::clear_trace();
+    CHECK(tracedEvents() == 0);
+
+    HookedEvaluator<jv::profile_hooks>{}.visit(*pExpr);
+    CHECK(tracedEvents() == 5);
+
+    jv::profile_hooks::stop_trace();
+    jv::profile_hooks::clear_trace();
+}
+
+TEST_CASE("latency histogram buckets")
+{
+    using h = jv::latency_histogram;
+
+    for (std::uint64_t ns : {0, 7, 8, 15, 16, 100, 1000, 123456789})
+    {
+        const auto bucket = h::bucket_of(ns);
+        CHECK(h::upper_bound_of(bucket) >= ns);
+        CHECK(h::upper_bound_of(bucket) - ns <= ns / 8);
+    }
+
+    CHECK(h::bucket_of(~std::uint64_t{0}) == h::buckets - 1);
+
+    auto histogram = h{};
+    for (std::uint64_t ns = 1; ns <= 100; ++ns)
+        histogram.record(ns);
+
+    CHECK(histogram.count() == 100);
+    CHECK(histogram.total() == 5050);
+    CHECK(histogram.max() == 100);
+    CHECK(histogram.percentile(50) >= 50);
+    CHECK(histogram.percentile(50) <= 55);
+}
@@ -0,0 +1,190 @@
+//  Built as its own executable, with JOSA_VISITOR_INSTRUMENT=1 and every lookup timed.
+//
+#include <josa/visitor.hpp>
+#include "types.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jv = josa::visitor;
+
+namespace
+{
+    struct ShapeNamer : jv::enable_dispatch<ShapeNamer, ShapeHierarchy>
+    {
+        auto operator () (const Square&) const -> std::string { return "square"; }
+        auto operator () (const Circle&) const -> std::string { return "circle"; }
+    };
+
+    struct ColorCounter : jv::enable_dispatch<ColorCounter, ColorHierarchy>
+    {
+        auto operator () (const Red&) const -> void {}
+        auto operator () (const Blue&) const -> void {}
+    };
+
+    struct ShapeTally : jv::enable_dispatch<ShapeTally, ShapeHierarchy>
+    {
+        int count = 0;
+
+        auto operator () (const Square&) -> void { ++count; }
+        auto operator () (const Circle&) -> void { ++count; }
+    };
+
+    struct PaintNamer : jv::enable_dispatch<PaintNamer, ShapeHierarchy, ColorHierarchy>
+    {
+        template <typename S, typename C>
+        auto operator () (const S&, const C&) const -> int { return 2; }
+    };
+
+    struct PaintMatcher : jv::enable_dispatch<PaintMatcher, ShapeHierarchy, ColorHierarchy, ShapeHierarchy>
+    {
+        template <typename S1, typename C, typename S2>
+        auto operator () (const S1&, const C&, const S2&) const -> int { return 3; }
+    };
+
+    auto find_stats(const jv::dispatch_snapshot& snapshot, const std::string& visitor) -> const jv::visitor_stats*
+    {
+        const auto it = std::find_if(snapshot.visitors.begin(), snapshot.visitors.end(),
+            [&](const jv::visitor_stats& v) { return v.visitor.find(visitor) != std::string::npos; });
+
+        return it == snapshot.visitors.end() ? nullptr : &*it;
+    }
+}
+
+TEST_CASE("instrumented dispatch counts visits by visitor and concrete type")
+{
+    static_assert(JOSA_VISITOR_INSTRUMENT);
+
+    const auto square = Square{};
+    const auto circle = Circle{};
+    const auto badShape = BadShape{};
+    const auto namer = ShapeNamer{};
+
+    CHECK(namer.visit(square) == "square");
+    CHECK(namer.visit(circle) == "circle");
+    CHECK(namer.visit(circle) == "circle");
+    CHECK(namer.try_visit(badShape) == std::nullopt);
+    CHECK_THROWS_AS(namer.visit(badShape), jv::unhandled_type);
+
+    auto threads = std::vector<std::thread>{};
+
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([] { for (int i = 0; i < 1000; ++i) ColorCounter{}.visit(Red{}); });
+
+    for (auto& thread : threads)
+        thread.join();
+
+    ColorCounter{}.visit(Blue{});
+
+    const auto snapshot = jv::instrumentation_snapshot();
+    const auto* shapes = find_stats(snapshot, "ShapeNamer");
+    const auto* colors = find_stats(snapshot, "ColorCounter");
+
+    REQUIRE(shapes);
+    REQUIRE(colors);
+
+    CHECK(shapes->hierarchy == "Shape");
+    CHECK(shapes->types == std::vector<std::string>{"Square", "Circle"});
+    CHECK(shapes->calls == std::vector<std::uint64_t>{1, 2});
+    CHECK(shapes->misses == 2);
+    CHECK(shapes->lookup_samples == 5);
+    CHECK(shapes->lookup_nanoseconds_max <= shapes->lookup_nanoseconds);
+    CHECK(colors->calls == std::vector<std::uint64_t>{4000, 1});
+    CHECK(colors->misses == 0);
+
+    const auto json = jv::to_json(snapshot);
+    CHECK(json.find("\"calls\":{\"Square\":1,\"Circle\":2},\"misses\":2,") != std::string::npos);
+
+    const auto text = jv::to_prometheus(snapshot);
+    CHECK(text.find("# TYPE josa_visitor_calls_total counter\n") != std::string::npos);
+    CHECK(text.find("hierarchy=\"Color\",type=\"Red\"} 4000\n") != std::string::npos);
+    CHECK(text.find("hierarchy=\"Shape\"} 2\n") != std::string::npos);
+}
+
+TEST_CASE("instrumented dispatch counts batch visits")
+{
+    auto shapes = std::vector<std::unique_ptr<Shape>>{};
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        shapes.push_back(std::make_unique<Square>());
+        shapes.push_back(std::make_unique<Circle>());
+    }
+
+    shapes.push_back(std::make_unique<Circle>());
+
+    auto tally = ShapeTally{};
+    tally.visit_all(shapes.begin(), shapes.end());
+
+    const auto total = ShapeTally{}.parallel_visit_all(shapes.begin(), shapes.end(),
+        [](ShapeTally a, const ShapeTally& b) { a.count += b.count; return a; }, 2);
+
+    auto bad = std::vector<std::unique_ptr<Shape>>{};
+    bad.push_back(std::make_unique<BadShape>());
+
+    CHECK_THROWS_AS(tally.visit_all(bad.begin(), bad.end()), jv::unhandled_type);
+
+    CHECK(tally.count == 2001);
+    CHECK(total.count == 2001);
+
+    const auto snapshot = jv::instrumentation_snapshot();
+    const auto* stats = find_stats(snapshot, "ShapeTally");
+
+    REQUIRE(stats);
+    CHECK(stats->calls == std::vector<std::uint64_t>{2000, 2002});
+    CHECK(stats->misses == 1);
+}
+
+TEST_CASE("instrumentation reports escape control characters")
+{
+    auto out = std::string{};
+    jv::detail::append_escaped(out, "a\"b\\c\nd\te\x01");
+
+    CHECK(out == "a\\\"b\\\\c\\nd\\u0009e\\u0001");
+}
+
+TEST_CASE("instrumented dispatch counts each object of a multiple dispatch under its hierarchy")
+{
+    const auto square = Square{};
+    const auto circle = Circle{};
+    const auto badShape = BadShape{};
+    const auto red = Red{};
+    const auto blue = Blue{};
+
+    CHECK(PaintNamer{}.visit(square, red) == 2);
+    CHECK(PaintNamer{}.try_visit(circle, blue) == 2);
+    CHECK(PaintNamer{}.visit_or([](const Shape&, const Color&) { return 0; }, badShape, red) == 0);
+    CHECK(PaintMatcher{}.visit(square, blue, circle) == 3);
+
+    const auto snapshot = jv::instrumentation_snapshot();
+
+    const auto stats = [&](const std::string& visitor, const std::string& hierarchy) -> const jv::visitor_stats* {
+        for (const auto& v : snapshot.visitors)
+        {
+            if (v.visitor.find(visitor) != std::string::npos && v.hierarchy == hierarchy)
+                return &v;
+        }
+
+        return nullptr;
+    };
+
+    const auto* pairShapes = stats("PaintNamer", "Shape");
+    const auto* pairColors = stats("PaintNamer", "Color");
+    const auto* tripleShapes = stats("PaintMatcher", "Shape");
+    const auto* tripleColors = stats("PaintMatcher", "Color");
+
+    REQUIRE(pairShapes);
+    REQUIRE(pairColors);
+    REQUIRE(tripleShapes);
+    REQUIRE(tripleColors);
+
+    CHECK(pairShapes->calls == std::vector<std::uint64_t>{1, 1});
+    CHECK(pairShapes->misses == 1);
+    CHECK(pairColors->calls == std::vector<std::uint64_t>{2, 1});
+    CHECK(pairColors->misses == 0);
+    CHECK(tripleShapes->calls == std::vector<std::uint64_t>{1, 1});
+    CHECK(tripleColors->calls == std::vector<std::uint64_t>{0, 1});
+}
@@ -0,0 +1,104 @@
+#include <josa/visitor/list.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+using namespace josa::meta;
+
+namespace
+{
+    struct A {};
+    struct B {};
+    struct C {};
+
+    template <std::size_t I> struct t {};
+
+    template <typename IS> struct make_long;
+
+    template <std::size_t... I> struct make_long<std::index_sequence<I...>> { using type = list<t<I>...>; };
+
+    //  Longer than the 256 operands some compilers allow in a fold expression.
+    //
+    using long_t = make_long<std::make_index_sequence<300>>::type;
+
+    template <typename T> using is_class_b = std::is_same<T, B>;
+
+    template <typename T>
+    struct append_name
+    {
+        auto operator()(std::string& s) const -> void { s += std::is_same_v<T, A> ? "A" : std::is_same_v<T, B> ? "B" : "C"; }
+    };
+}
+
+TEST_CASE("type list algorithms")
+{
+    static_assert(size<list<>>::value == 0);
+    static_assert(size<list<A, B, A>>::value == 3);
+    static_assert(empty<list<>>::value && !empty<list<A>>::value);
+
+    static_assert(!contains<A, list<>>::value);
+    static_assert(contains<B, list<A, B, C>>::value);
+    static_assert(!contains<C, list<A, B, A>>::value);
+    static_assert(contains<t<299>, long_t>::value && !contains<A, long_t>::value);
+
+    static_assert(count<A, list<>>::value == 0);
+    static_assert(count<A, list<A, B, A, C, A>>::value == 3);
+    static_assert(count<t<7>, long_t>::value == 1);
+
+    static_assert(all_unique<list<>>::value);
+    static_assert(all_unique<list<A, B, C>>::value);
+    static_assert(!all_unique<list<A, B, C, B>>::value);
+    static_assert(all_unique<long_t>::value);
+
+    static_assert(each_of<list<>, std::is_class>::value && !any_of<list<>, std::is_class>::value);
+    static_assert(each_of<list<A, B>, std::is_class>::value && !each_of<list<A, int>, std::is_class>::value);
+    static_assert(any_of<list<A, B, C>, is_class_b>::value && !any_of<list<A, C>, is_class_b>::value);
+
+    static_assert(index_of<A, list<A, B, C>>::value == 0);
+    static_assert(index_of<C, list<A, B, C>>::value == 2);
+    static_assert(index_of<B, list<A, B, C, B>>::value == 1);
+    static_assert(index_of<t<299>, long_t>::value == 299);
+
+    static_assert(std::is_same_v<at_t<0, list<A, B, C>>, A>);
+    static_assert(std::is_same_v<at_t<2, list<A, B, C>>, C>);
+    static_assert(std::is_same_v<at_t<299, long_t>, t<299>>);
+    static_assert(std::is_same_v<div_at_t<5, 2, list<A, B, C>>, C>);
+    static_assert(std::is_same_v<mod_at_t<5, 2, list<A, B, C>>, B>);
+    static_assert(std::is_same_v<head_t<list<A, B>>, A>);
+    static_assert(std::is_same_v<tail_t<list<A, B, C>>, list<B, C>>);
+    static_assert(std::is_same_v<tail_t<list<>>, list<>>);
+
+    static_assert(std::is_same_v<prepend_t<A, list<B>>, list<A, B>>);
+    static_assert(std::is_same_v<append_t<list<B>, A>, list<B, A>>);
+    static_assert(std::is_same_v<remove_t<A, list<>>, list<>>);
+    static_assert(std::is_same_v<remove_t<A, list<A, B, A, C, A>>, list<B, C>>);
+    static_assert(std::is_same_v<remove_t<A, list<B, C>>, list<B, C>>);
+    static_assert(std::is_same_v<uniques_t<list<>>, list<>>);
+    static_assert(std::is_same_v<uniques_t<list<A, B, A, C, B, C>>, list<A, B, C>>);
+    static_assert(std::is_same_v<reverse_t<list<>>, list<>>);
+    static_assert(std::is_same_v<reverse_t<list<A, B, C>>, list<C, B, A>>);
+    static_assert(std::is_same_v<at_t<0, reverse_t<long_t>>, t<299>>);
+
+    static_assert(std::is_same_v<concat_t<>, list<>>);
+    static_assert(std::is_same_v<concat_t<list<A>, list<>, list<B, C>>, list<A, B, C>>);
+    static_assert(std::is_same_v<concat_t<list<A>, list<B>, list<C>, list<A>, list<B>, list<C>, list<A>, list<B>, list<C>, list<A>>,
+        list<A, B, C, A, B, C, A, B, C, A>>);
+
+    static_assert(std::is_same_v<transform_t<list<A, B>, std::add_const>, list<const A, const B>>);
+    static_assert(std::is_same_v<wrap_t<list<A, B>, std::add_pointer_t>, list<A*, B*>>);
+    static_assert(std::is_same_v<convert_t<list<A, B>, std::pair>, std::pair<A, B>>);
+    static_assert(std::is_same_v<indexed_t<list<A, B>>, list<indexed_type<0, A>, indexed_type<1, B>>>);
+    static_assert(std::is_same_v<indexed_t<list<A, B>, 3>, list<indexed_type<3, A>, indexed_type<4, B>>>);
+
+    static_assert(std::is_same_v<cartesian_product_t<>, list<list<>>>);
+    static_assert(std::is_same_v<cartesian_product_t<list<A, B>, list<>>, list<>>);
+    static_assert(std::is_same_v<all_pairs_t<list<A, B>, list<C, A>>,
+        list<list<A, C>, list<A, A>, list<B, C>, list<B, A>>>);
+    static_assert(size<all_pairs_t<long_t, list<A, B, C>>>::value == 900);
+    static_assert(std::is_same_v<at_t<599, all_pairs_t<long_t, list<A, B>>>, list<t<299>, B>>);
+
+    auto names = std::string{};
+    for_each<list<A, B, C, A>, append_name>(names);
+    CHECK(names == "ABCA");
+}
@@ -0,0 +1,88 @@
+#include <josa/visitor.hpp>
+#include "types.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+
+namespace jv = josa::visitor;
+using namespace std::string_literals;
+
+TEST_CASE("triple dispatch with an overload set")
+{
+    using namespace MathAst;
+    using Dispatcher = jv::dispatcher<ColorHierarchy, ShapeHierarchy, MathAst::Hierarchy>;
+
+    const auto f = jv::overload
+    (
+        [](const Red&, const Square&, const Value&)   { return "red square value"s; },
+        [](const Red&, const Circle&, const Plus&)    { return "red circle plus"s; },
+        [](const Blue&, const Shape&, const Times&)   { return "blue shape times"s; },
+        [](const Color&, const Shape&, const Expr&)   { return "other"s; }
+    );
+
+    const auto pValue = value(1);
+    const auto pPlus = plus(value(1), value(2));
+    const auto pTimes = times(value(1), value(2));
+
+    CHECK(Dispatcher::visit(f, Red{}, Square{}, *pValue) == "red square value");
+    CHECK(Dispatcher::visit(f, Red{}, Circle{}, *pPlus) == "red circle plus");
+    CHECK(Dispatcher::visit(f, Blue{}, Circle{}, *pTimes) == "blue shape times");
+    CHECK(Dispatcher::visit(f, Blue{}, Square{}, *pValue) == "other");
+    CHECK_THROWS_AS(Dispatcher::visit(f, Red{}, BadShape{}, *pValue), jv::unhandled_type);
+
+    const auto t = Dispatcher::match(Blue{}, Square{}, *pTimes)
+    (
+        [](const Blue&, const Square&, const Times&)  { return true; },
+        [](const Color&, const Shape&, const Expr&)   { return false; }
+    );
+
+    CHECK(t == true);
+}
+
+TEST_CASE("triple dispatch enabled visitor class with non-const objects and extra arguments")
+{
+    struct Painter : jv::enable_dispatch<Painter, ColorHierarchy, ShapeHierarchy, ColorHierarchy>
+    {
+        auto operator()(Red& c1, const Square&, const Color& c2, int& count) const -> void
+        {
+            count += c1.isConst() ? 100 : 1;
+            count += c2.isConst() ? 10 : 1000;
+        }
+
+        auto operator()(const Color&, const Shape&, const Color&, int&) const -> void {}
+    };
+
+    auto red = Red{};
+    const auto blue = Blue{};
+    auto count = 0;
+
+    Painter{}.visit(red, Square{}, blue, count);
+    CHECK(count == 11);
+
+    Painter{}.visit(blue, Square{}, red, count);
+    CHECK(count == 11);
+
+    jv::inline_cache<ColorHierarchy, ShapeHierarchy, ColorHierarchy> cache;
+
+    Painter{}.visit(cache, red, Square{}, blue, count);
+    Painter{}.visit(cache, red, Square{}, blue, count);
+    CHECK(count == 33);
+    CHECK(cache.misses() == 3);
+    CHECK(cache.hits() == 3);
+}
+
+TEST_CASE("quadruple dispatch through a table")
+{
+    using TableColorHierarchy = jv::hierarchy<jv::base_type<Color>, jv::concrete_types<Red, Blue>, jv::table_dispatch>;
+    using Dispatcher = jv::dispatcher<TableColorHierarchy, ColorHierarchy, ShapeHierarchy, ColorHierarchy>;
+
+    const auto f = jv::overload
+    (
+        [](const Blue&, const Red&, const Circle&, const Blue&) { return 1; },
+        [](const Color&, const Color&, const Shape&, const Color&) { return 0; }
+    );
+
+    CHECK(Dispatcher::visit(f, Blue{}, Red{}, Circle{}, Blue{}) == 1);
+    CHECK(Dispatcher::visit(f, Blue{}, Red{}, Circle{}, Red{}) == 0);
+    CHECK(Dispatcher::visit(f, Red{}, Red{}, Circle{}, Blue{}) == 0);
+}
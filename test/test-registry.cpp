@@ -0,0 +1,158 @@
+#include <josa/visitor.hpp>
+#include "types.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jv = josa::visitor;
+using namespace std::string_literals;
+
+namespace
+{
+    //  Types unknown to ShapeHierarchy, as if loaded from plugins
+    //
+    struct Triangle final : Shape {};
+    struct Hexagon final : Shape { int sides = 6; };
+}
+
+TEST_CASE("dispatch registry for types added at runtime")
+{
+    auto registry = jv::dispatch_registry<ShapeHierarchy, std::string(const Shape&)>{};
+
+    const auto namer = jv::overload
+    (
+        [](const Square&) { return "square"s; },
+        [](const Circle&) { return "circle"s; }
+    );
+
+    CHECK(registry.size() == 0);
+    CHECK(registry.visit(namer, Square{}) == "square"s);
+    CHECK_THROWS_AS(registry.visit(namer, Triangle{}), jv::unhandled_type);
+
+    registry.add<Triangle>([](const Triangle&) { return "triangle"s; });
+    registry.add<Hexagon>([](const Hexagon& h) { return std::to_string(h.sides) + "-gon"; });
+
+    CHECK(registry.size() == 2);
+    CHECK(registry.visit(namer, Circle{}) == "circle"s);
+    CHECK(registry.visit(namer, Triangle{}) == "triangle"s);
+    CHECK(registry.visit(namer, Hexagon{}) == "6-gon"s);
+    CHECK(registry.find(typeid(Square)) == nullptr);
+
+    //  A later registration replaces the handler
+    //
+    registry.add<Triangle>([](const Triangle&) { return "three sides"s; });
+
+    CHECK(registry.size() == 2);
+    CHECK(registry.visit(namer, Triangle{}) == "three sides"s);
+}
+
+#if defined(__GLIBCXX__)
+//  With external linkage, as only such types can be shared with another shared object
+//
+struct PluginTriangle final : Shape {};
+struct PluginHexagon final : Shape {};
+
+template <int Sides>
+struct PluginPolygon final : Shape {};
+
+TEST_CASE("dispatch registry finds a type under a type_info from another shared object")
+{
+    auto registry = jv::dispatch_registry<ShapeHierarchy, std::string(const Shape&)>{};
+    registry.add<PluginTriangle>([](const PluginTriangle&) { return "triangle"s; });
+
+    const auto foreignTriangle = ForeignTypeInfo{typeid(PluginTriangle)};
+    const auto foreignHexagon = ForeignTypeInfo{typeid(PluginHexagon)};
+
+    REQUIRE(&foreignTriangle != &typeid(PluginTriangle));
+
+    const auto* handler = registry.find(foreignTriangle);
+
+    REQUIRE(handler);
+    CHECK((*handler)(PluginTriangle{}) == "triangle"s);
+    CHECK(registry.find(foreignTriangle) == handler);
+    CHECK(registry.find(foreignHexagon) == nullptr);
+    CHECK(registry.find(foreignHexagon) == nullptr);
+
+    //  Remembered lookups, found or not, are dropped with the table they were made in
+    //
+    registry.add<PluginHexagon>([](const PluginHexagon&) { return "hexagon"s; });
+    registry.add<PluginTriangle>([](const PluginTriangle&) { return "three sides"s; });
+
+    REQUIRE(registry.find(foreignHexagon));
+    CHECK((*registry.find(foreignHexagon))(PluginHexagon{}) == "hexagon"s);
+    CHECK((*registry.find(foreignTriangle))(PluginTriangle{}) == "three sides"s);
+}
+
+template <int... Sides>
+auto checkManyPolygons(std::integer_sequence<int, Sides...>) -> void
+{
+    auto registry = jv::dispatch_registry<ShapeHierarchy, int(const Shape&)>{};
+
+    (registry.add<PluginPolygon<Sides>>([](const PluginPolygon<Sides>&) { return Sides; }), ...);
+
+    const auto namer = jv::overload([](const Square&) { return -4; }, [](const Circle&) { return 0; });
+    const auto foreignTypes = std::array<ForeignTypeInfo, sizeof...(Sides)>{ForeignTypeInfo{typeid(PluginPolygon<Sides>)}...};
+    const auto types = std::array<const std::type_info*, sizeof...(Sides)>{&typeid(PluginPolygon<Sides>)...};
+
+    for (auto repeat = 0; repeat < 2; ++repeat)
+    {
+        CHECK(((registry.visit(namer, PluginPolygon<Sides>{}) == Sides) && ...));
+        CHECK(registry.visit(namer, Square{}) == -4);
+        CHECK(registry.visit(namer, Circle{}) == 0);
+
+        for (std::size_t i = 0; i < types.size(); ++i)
+        {
+            REQUIRE(registry.find(foreignTypes[i]));
+            CHECK(registry.find(foreignTypes[i]) == registry.find(*types[i]));
+        }
+    }
+
+    CHECK_THROWS_AS(registry.visit(namer, BadShape{}), jv::unhandled_type);
+}
+
+TEST_CASE("dispatch registry with more types than a small memo holds")
+{
+    checkManyPolygons(std::make_integer_sequence<int, 48>{});
+}
+#endif
+
+TEST_CASE("dispatch registry lookups while types are being registered")
+{
+    auto registry = jv::dispatch_registry<ShapeHierarchy, int(const Shape&, int)>{};
+    registry.add<Triangle>([](const Triangle&, const int x) { return x + 3; });
+
+    const auto count = jv::overload
+    (
+        [](const Square&, const int x) { return x + 4; },
+        [](const Circle&, const int x) { return x; }
+    );
+
+    auto stop = std::atomic<bool>{false};
+    auto wrong = std::atomic<int>{0};
+    auto readers = std::vector<std::thread>{};
+
+    for (auto t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&] {
+            while (!stop)
+            {
+                if (registry.visit(count, Triangle{}, 1) != 4 || registry.visit(count, Square{}, 1) != 5)
+                    ++wrong;
+            }
+        });
+    }
+
+    for (auto i = 0; i < 200; ++i)
+        registry.add<Hexagon>([i](const Hexagon&, const int x) { return x + i; });
+
+    stop = true;
+
+    for (auto& t : readers)
+        t.join();
+
+    CHECK(wrong == 0);
+    CHECK(registry.visit(count, Hexagon{}, 1) == 200);
+}
@@ -1,7 +1,11 @@
 #include <josa/visitor.hpp>
 #include "types.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <atomic>
+#include <iterator>
 #include <memory>
+#include <thread>
 #include <vector>
 
 namespace jv = josa::visitor;
@@ -155,3 +159,687 @@ TEST_CASE("visitor non-copyable non-moveable temporary handler")
     Red red;
     jv::dispatcher<ColorHierarchy>::visit(Handler{}, red);
 }
+
+TEST_CASE("single-dispatch visit and match with an inline cache")
+{
+    using ShapeDispatcher = jv::dispatcher<ShapeHierarchy>;
+
+    const auto getShapeName = jv::overload
+    (
+        [](const Square&) { return "square"s; },
+        [](const Circle&) { return "circle"s; }
+    );
+
+    jv::inline_cache<ShapeHierarchy> cache;
+
+    const auto square = Square{};
+    const auto circle = Circle{};
+
+    CHECK(ShapeDispatcher::visit(cache, getShapeName, square) == "square");
+    CHECK(ShapeDispatcher::visit(cache, getShapeName, square) == "square");
+    CHECK(ShapeDispatcher::visit(cache, getShapeName, circle) == "circle");
+    CHECK(ShapeDispatcher::visit(cache, getShapeName, square) == "square");
+    CHECK(ShapeDispatcher::visit(cache, getShapeName, circle) == "circle");
+
+    CHECK(cache.misses() == 2);
+    CHECK(cache.hits() == 3);
+
+    const auto s = ShapeDispatcher::match(cache, circle)
+    (
+        [](const Square&) { return "square"s; },
+        [](const Circle&) { return "circle"s; }
+    );
+
+    CHECK(s == "circle");
+    CHECK(cache.hits() == 4);
+
+    const auto badShape = BadShape{};
+    CHECK_THROWS_AS(ShapeDispatcher::visit(cache, getShapeName, badShape), jv::unhandled_type);
+}
+
+TEST_CASE("monomorphic inline cache evicts on a type change")
+{
+    struct Namer : jv::enable_dispatch<Namer, ColorHierarchy>
+    {
+        auto operator()(const Red&) const -> std::string { return "red"; }
+        auto operator()(const Blue&) const -> std::string { return "blue"; }
+    };
+
+    jv::monomorphic_cache<ColorHierarchy> cache;
+
+    const auto red = Red{};
+    const auto blue = Blue{};
+
+    CHECK(Namer{}.visit(cache, red) == "red");
+    CHECK(Namer{}.visit(cache, blue) == "blue");
+    CHECK(Namer{}.visit(cache, red) == "red");
+    CHECK(Namer{}.visit(cache, red) == "red");
+
+    CHECK(cache.misses() == 3);
+    CHECK(cache.hits() == 1);
+}
+
+#if defined(__GLIBCXX__)
+TEST_CASE("inline cache hits on a type_info from another shared object")
+{
+    const auto foreign = ForeignTypeInfo{typeid(Circle)};
+    REQUIRE(foreign == typeid(Circle));
+    REQUIRE(&foreign != &typeid(Circle));
+
+    jv::detail::inline_cache_line<ShapeHierarchy, 2> line;
+
+    const auto circle = Circle{};
+
+    CHECK(line.ordinal_of(foreign, circle) == 1);
+    CHECK(line.ordinal_of(foreign, circle) == 1);
+    CHECK(line.ordinal_of(circle) == 1);
+    CHECK(line.ordinal_of(foreign, circle) == 1);
+
+    CHECK(line.misses() == 2);
+    CHECK(line.hits() == 2);
+}
+#endif
+
+TEST_CASE("inline cache shared between threads")
+{
+    static jv::inline_cache<MathAst::Hierarchy> cache;
+
+    std::vector<MathAst::ExprPtr> exprs;
+    exprs.push_back(MathAst::value(1));
+    exprs.push_back(MathAst::negate(MathAst::value(1)));
+    exprs.push_back(MathAst::plus(MathAst::value(1), MathAst::value(2)));
+    exprs.push_back(MathAst::times(MathAst::value(1), MathAst::value(2)));
+
+    const auto kind = jv::overload
+    (
+        [](const MathAst::Value&) { return 0; },
+        [](const MathAst::Negate&) { return 1; },
+        [](const MathAst::Plus&) { return 2; },
+        [](const MathAst::Times&) { return 3; }
+    );
+
+    std::atomic<int> errors{0};
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 10000; ++i)
+            {
+                const auto k = (i + t) % 4;
+                if (jv::dispatcher<MathAst::Hierarchy>::visit(cache, kind, *exprs[k]) != k)
+                    ++errors;
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(errors == 0);
+}
+
+namespace
+{
+    struct Mixin
+    {
+        virtual ~Mixin() {}
+        int value = 0;
+    };
+
+    //  Shape is not the primary base here, so a Shape reference does not point at the start of the
+    //  object.
+    //
+    struct MixedShape final : Mixin, Shape {};
+}
+
+TEST_CASE("single-dispatch with vtable_key")
+{
+    using VtableShapeHierarchy = jv::hierarchy
+    <
+        jv::base_type<Shape>,
+        jv::concrete_types<Square, Circle, MixedShape>,
+        jv::vtable_key
+    >;
+
+    using ShapeDispatcher = jv::dispatcher<VtableShapeHierarchy>;
+
+    const auto getShapeName = jv::overload
+    (
+        [](const Square&) { return "square"s; },
+        [](const Circle&) { return "circle"s; },
+        [](const MixedShape&) { return "mixed"s; }
+    );
+
+    std::vector<std::unique_ptr<Shape>> shapeVec;
+
+    shapeVec.push_back(std::make_unique<Square>());
+    shapeVec.push_back(std::make_unique<MixedShape>());
+    shapeVec.push_back(std::make_unique<Circle>());
+
+    //  The second pass is served from the vtables learned in the first
+    //
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        CHECK(ShapeDispatcher::visit(getShapeName, *shapeVec[0]) == "square");
+        CHECK(ShapeDispatcher::visit(getShapeName, *shapeVec[1]) == "mixed");
+        CHECK(ShapeDispatcher::visit(getShapeName, *shapeVec[2]) == "circle");
+        CHECK_THROWS_AS(ShapeDispatcher::visit(getShapeName, BadShape{}), jv::unhandled_type);
+    }
+}
+
+TEST_CASE("warm_up a hierarchy or a visitor before visiting")
+{
+    jv::warm_up<ShapeHierarchy>();
+    jv::warm_up<Evaluator>();
+    jv::warm_up<Evaluator>();
+
+    using namespace MathAst;
+    CHECK(evaluate(plus(value(1), value(2))) == 3);
+}
+
+namespace
+{
+    //  A hierarchy with more types than one switch statement of index_switch has cases.
+    //
+    struct Wide { virtual ~Wide() {} };
+
+    template <std::size_t I>
+    struct WideLeaf final : Wide {};
+
+    template <typename IS, typename... Options> struct WideHierarchyMaker;
+
+    template <std::size_t... I, typename... Options>
+    struct WideHierarchyMaker<std::index_sequence<I...>, Options...>
+    {
+        using type = jv::hierarchy<jv::base_type<Wide>, jv::concrete_types<WideLeaf<I>...>, Options...>;
+    };
+
+    template <typename... Options>
+    using WideHierarchy = typename WideHierarchyMaker<std::make_index_sequence<70>, Options...>::type;
+
+    struct WideIndex
+    {
+        template <std::size_t I>
+        auto operator()(const WideLeaf<I>&, const std::size_t offset) const -> std::size_t { return I + offset; }
+    };
+}
+
+TEST_CASE("single-dispatch through a switch or a table")
+{
+    const auto check = [](auto dispatcher) {
+        using Dispatcher = decltype(dispatcher);
+
+        CHECK(Dispatcher::visit(WideIndex{}, WideLeaf<0>{}, 1) == 1);
+        CHECK(Dispatcher::visit(WideIndex{}, WideLeaf<63>{}, 1) == 64);
+        CHECK(Dispatcher::visit(WideIndex{}, WideLeaf<64>{}, 1) == 65);
+        CHECK(Dispatcher::visit(WideIndex{}, WideLeaf<69>{}, 1) == 70);
+    };
+
+    check(jv::dispatcher<WideHierarchy<>>{});
+    check(jv::dispatcher<WideHierarchy<jv::switch_dispatch>>{});
+    check(jv::dispatcher<WideHierarchy<jv::table_dispatch>>{});
+
+    using TableShapeHierarchy = jv::hierarchy<jv::base_type<Shape>, jv::concrete_types<Square, Circle>, jv::table_dispatch>;
+
+    const auto getShapeName = jv::overload
+    (
+        [](const Square&) { return "square"s; },
+        [](const Circle&) { return "circle"s; }
+    );
+
+    CHECK(jv::dispatcher<TableShapeHierarchy>::visit(getShapeName, Circle{}) == "circle");
+    CHECK_THROWS_AS(jv::dispatcher<TableShapeHierarchy>::visit(getShapeName, BadShape{}), jv::unhandled_type);
+}
+
+namespace
+{
+    //  A hierarchy that stores its own type tag
+    //
+    enum class Kind : unsigned char { token = 10, word = 12, number = 40, space = 200 };
+
+    struct Lexeme
+    {
+        explicit Lexeme(const Kind kind) : kind{kind} {}
+        const Kind kind;
+    };
+
+    struct Token final : Lexeme { static constexpr auto tag = Kind::token; Token() : Lexeme{tag} {} };
+    struct Word final : Lexeme { static constexpr auto tag = Kind::word; Word() : Lexeme{tag} {} };
+    struct Number final : Lexeme { Number() : Lexeme{Kind::number} {} };
+    struct Space final : Lexeme { static constexpr auto tag = Kind::space; Space() : Lexeme{tag} {} };
+
+    //  Tags equal to the ordinals are used as they are
+    //
+    struct Ranked
+    {
+        explicit Ranked(const int rank) : rank{rank} {}
+        auto get_rank() const -> int { return rank; }
+        const int rank;
+    };
+
+    struct First final : Ranked { static constexpr int tag = 0; First() : Ranked{tag} {} };
+    struct Second final : Ranked { static constexpr int tag = 1; Second() : Ranked{tag} {} };
+}
+
+template <> struct jv::type_tag<Number> { static constexpr auto value = Kind::number; };
+
+TEST_CASE("single-dispatch with tag_accessor")
+{
+    const auto getName = jv::overload
+    (
+        [](const Token&)  { return "token"s; },
+        [](const Word&)   { return "word"s; },
+        [](const Number&) { return "number"s; },
+        [](const Space&)  { return "space"s; }
+    );
+
+    //  Tags close together are looked up in a table, scattered ones by binary search
+    //
+    using DenseHierarchy = jv::hierarchy<jv::base_type<Lexeme>, jv::concrete_types<Token, Word, Number>, jv::tag_accessor<&Lexeme::kind>>;
+    using SparseHierarchy = jv::hierarchy<jv::base_type<Lexeme>, jv::concrete_types<Space, Word, Token>, jv::tag_accessor<&Lexeme::kind>>;
+
+    CHECK(jv::dispatcher<DenseHierarchy>::visit(getName, Token{}) == "token");
+    CHECK(jv::dispatcher<DenseHierarchy>::visit(getName, Number{}) == "number");
+    CHECK_THROWS_WITH(jv::dispatcher<DenseHierarchy>::visit(getName, Space{}), "unhandled type (tag 200)");
+    CHECK_THROWS_AS(jv::dispatcher<DenseHierarchy>::visit(getName, Lexeme{static_cast<Kind>(0)}), jv::unhandled_type);
+    CHECK_THROWS_AS(jv::dispatcher<DenseHierarchy>::visit(getName, Lexeme{static_cast<Kind>(11)}), jv::unhandled_type);
+
+    CHECK(jv::dispatcher<SparseHierarchy>::visit(getName, Space{}) == "space");
+    CHECK(jv::dispatcher<SparseHierarchy>::visit(getName, Word{}) == "word");
+    CHECK(jv::dispatcher<SparseHierarchy>::visit(getName, Token{}) == "token");
+    CHECK_THROWS_WITH(jv::dispatcher<SparseHierarchy>::visit(getName, Number{}), "unhandled type (tag 40)");
+
+    using RankedHierarchy = jv::hierarchy<jv::base_type<Ranked>, jv::concrete_types<First, Second>, jv::tag_accessor<&Ranked::get_rank>>;
+
+    const auto isSecond = jv::overload
+    (
+        [](const First&)  { return false; },
+        [](const Second&) { return true; }
+    );
+
+    CHECK(jv::dispatcher<RankedHierarchy>::visit(isSecond, Second{}));
+    CHECK_THROWS_WITH(jv::dispatcher<RankedHierarchy>::visit(isSecond, Ranked{-1}), "unhandled type (tag -1)");
+}
+
+TEST_CASE("visit_all over a range of mixed objects")
+{
+    using namespace MathAst;
+
+    std::vector<std::unique_ptr<Expr>> exprs;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        if (i % 3 == 0)
+            exprs.push_back(value(i));
+        else if (i % 3 == 1)
+            exprs.push_back(negate(value(i)));
+        else
+            exprs.push_back(plus(value(i), value(1)));
+    }
+
+    auto results = std::vector<int>{};
+    Evaluator{}.visit_all(exprs.begin(), exprs.end(), std::back_inserter(results));
+
+    REQUIRE(results.size() == exprs.size());
+
+    for (int i = 0; i < 100; ++i)
+        CHECK(results[i] == (i % 3 == 0 ? i : i % 3 == 1 ? -i : i + 1));
+
+    //  Without an output iterator, and over raw pointers without prefetching
+    //
+    auto ptrs = std::vector<const Expr*>{};
+
+    for (const auto& p : exprs)
+        ptrs.push_back(p.get());
+
+    auto counts = std::array<int, 4>{};
+    const auto count = jv::overload
+    (
+        [&](const Value&)  { ++counts[0]; },
+        [&](const Negate&) { ++counts[1]; },
+        [&](const Plus&)   { ++counts[2]; },
+        [&](const Times&)  { ++counts[3]; }
+    );
+
+    jv::dispatcher<MathAst::Hierarchy>::visit_all<0>(count, ptrs.begin(), ptrs.end());
+
+    CHECK(counts == std::array<int, 4>{34, 33, 33, 0});
+
+    //  Nothing in the chunk is visited if any object is unhandled
+    //
+    std::vector<std::unique_ptr<Shape>> shapes;
+    shapes.push_back(std::make_unique<Square>());
+    shapes.push_back(std::make_unique<BadShape>());
+
+    auto visited = 0;
+    const auto countShapes = jv::overload
+    (
+        [&](const Square&) { ++visited; },
+        [&](const Circle&) { ++visited; }
+    );
+
+    CHECK_THROWS_AS(jv::dispatcher<ShapeHierarchy>::visit_all(countShapes, shapes.begin(), shapes.end()), jv::unhandled_type);
+    CHECK(visited == 0);
+}
+
+//  A grain is a whole number of chunks, even where the cap on its size is not
+//
+static_assert(jv::detail::parallel_grain_size(std::size_t{1} << 30, 4, 320) == 65280);
+static_assert(jv::detail::parallel_grain_size(std::size_t{1} << 30, 4, 64) == 65536);
+static_assert(jv::detail::parallel_grain_size(1000, 4, 320) == 320);
+
+TEST_CASE("parallel_visit_all with a per-thread handler and a reduction")
+{
+    using namespace MathAst;
+
+    struct NodeCounter : jv::enable_dispatch<NodeCounter, Hierarchy>
+    {
+        std::array<int, 4> counts{};
+        int sum = 0;
+
+        auto operator()(const Value& node) -> void   { ++counts[0]; sum += node.value(); }
+        auto operator()(const Negate&) -> void       { ++counts[1]; }
+        auto operator()(const Plus&) -> void         { ++counts[2]; }
+        auto operator()(const Times&) -> void        { ++counts[3]; }
+    };
+
+    const auto add = [](NodeCounter a, const NodeCounter& b) {
+        for (std::size_t i = 0; i < a.counts.size(); ++i)
+            a.counts[i] += b.counts[i];
+        a.sum += b.sum;
+        return a;
+    };
+
+    std::vector<std::unique_ptr<Expr>> exprs;
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        if (i % 3 == 0)
+            exprs.push_back(value(i % 7));
+        else if (i % 3 == 1)
+            exprs.push_back(negate(value(i)));
+        else
+            exprs.push_back(plus(value(i), value(1)));
+    }
+
+    auto serial = NodeCounter{};
+    serial.visit_all(exprs.begin(), exprs.end());
+
+    for (const std::size_t threads : {1, 2, 3, 8})
+    {
+        const auto parallel = NodeCounter{}.parallel_visit_all(exprs.begin(), exprs.end(), add, threads);
+
+        CHECK(parallel.counts == serial.counts);
+        CHECK(parallel.sum == serial.sum);
+    }
+
+    //  An empty range gives back a copy of the handler
+    //
+    const auto none = NodeCounter{}.parallel_visit_all(exprs.end(), exprs.end(), add, 4);
+    CHECK(none.counts == std::array<int, 4>{});
+
+    //  An unhandled object stops the visit and its exception reaches the caller
+    //
+    std::vector<std::unique_ptr<Shape>> shapes;
+
+    for (int i = 0; i < 50000; ++i)
+        shapes.push_back(std::make_unique<Square>());
+
+    shapes.push_back(std::make_unique<BadShape>());
+
+    const auto countShapes = jv::overload
+    (
+        [](const Square&) {},
+        [](const Circle&) {}
+    );
+
+    CHECK_THROWS_AS(jv::dispatcher<ShapeHierarchy>::parallel_visit_all(countShapes, shapes.begin(), shapes.end(),
+        [](auto a, auto) { return a; }, 4), jv::unhandled_type);
+}
+
+TEST_CASE("single-dispatch try_visit and visit_or")
+{
+    using namespace MathAst;
+
+    const auto expr = plus(value(2), value(3));
+    const auto bad = BadShape{};
+    const auto square = Square{};
+
+    const auto result = Evaluator{}.try_visit(*expr);
+    REQUIRE(result.has_value());
+    CHECK(*result == 5);
+
+    const auto namer = jv::overload
+    (
+        [](const Square&) { return "square"s; },
+        [](const Circle&) { return "circle"s; }
+    );
+
+    using dispatcher_t = jv::dispatcher<ShapeHierarchy>;
+
+    CHECK(dispatcher_t::try_visit(namer, square) == "square"s);
+    CHECK_FALSE(dispatcher_t::try_visit(namer, bad).has_value());
+
+    const auto unknown = [](const Shape&) { return "unknown"s; };
+    CHECK(dispatcher_t::visit_or(unknown, namer, square) == "square"s);
+    CHECK(dispatcher_t::visit_or(unknown, namer, bad) == "unknown"s);
+
+    //  Handlers returning void report whether the object was visited
+    //
+    auto visited = 0;
+    const auto count = jv::overload([&](const Square&) { ++visited; }, [&](const Circle&) { ++visited; });
+
+    CHECK(dispatcher_t::try_visit(count, square));
+    CHECK_FALSE(dispatcher_t::try_visit(count, bad));
+    CHECK(visited == 1);
+}
+
+namespace
+{
+    //  A hierarchy whose listed types have subclasses that are not listed, as if loaded from plugins
+    //
+    struct Widget { virtual ~Widget() = default; };
+    struct Button : Widget {};
+    struct Label : Widget {};
+    struct ToggleButton : Button {};
+
+    struct IconToggleButton final : ToggleButton {};
+    struct LinkLabel final : Label {};
+    struct Spacer final : Widget {};
+
+    template <std::size_t I>
+    struct NumberedLabel final : Label {};
+
+    using WidgetHierarchy = jv::hierarchy
+    <
+        jv::base_type<Widget>,
+        jv::concrete_types<Button, Label, ToggleButton>,
+        jv::resolve_derived
+    >;
+}
+
+template <typename Hierarchy>
+auto checkUnlistedRemembered() -> void
+{
+    using dispatcher_t = jv::dispatcher<Hierarchy>;
+
+    const auto name = jv::overload([](const Square&) { return "square"s; });
+    const auto unknown = [](const Shape&) { return "unknown"s; };
+
+    const auto empty = jv::table_usage<Hierarchy>().lookup_bytes;
+
+    CHECK(dispatcher_t::visit_or(unknown, name, Circle{}) == "unknown"s);
+
+    //  The miss is remembered the first time only
+    //
+    const auto remembered = jv::table_usage<Hierarchy>().lookup_bytes;
+
+    CHECK(dispatcher_t::visit_or(unknown, name, Circle{}) == "unknown"s);
+    CHECK(dispatcher_t::visit_or(unknown, name, Square{}) == "square"s);
+    CHECK(remembered > empty);
+    CHECK(jv::table_usage<Hierarchy>().lookup_bytes == remembered);
+}
+
+TEST_CASE("single-dispatch remembers types that are not listed")
+{
+    checkUnlistedRemembered<jv::hierarchy<jv::base_type<Shape>, jv::concrete_types<Square>>>();
+    checkUnlistedRemembered<jv::hierarchy<jv::base_type<Shape>, jv::concrete_types<Square>, jv::vtable_key>>();
+}
+
+TEST_CASE("single-dispatch resolves unlisted types to their nearest listed ancestor")
+{
+    const auto namer = jv::overload
+    (
+        [](const Button&) { return "button"s; },
+        [](const Label&) { return "label"s; },
+        [](const ToggleButton&) { return "toggle"s; }
+    );
+
+    using dispatcher_t = jv::dispatcher<WidgetHierarchy>;
+
+    for (auto repeat = 0; repeat < 2; ++repeat)
+    {
+        CHECK(dispatcher_t::visit(namer, Button{}) == "button"s);
+        CHECK(dispatcher_t::visit(namer, ToggleButton{}) == "toggle"s);
+        CHECK(dispatcher_t::visit(namer, IconToggleButton{}) == "toggle"s);
+        CHECK(dispatcher_t::visit(namer, LinkLabel{}) == "label"s);
+        CHECK_THROWS_AS(dispatcher_t::visit(namer, Spacer{}), jv::unhandled_type);
+    }
+
+    auto cache = jv::monomorphic_cache<WidgetHierarchy>{};
+
+    for (auto repeat = 0; repeat < 3; ++repeat)
+        CHECK(dispatcher_t::visit(cache, namer, IconToggleButton{}) == "toggle"s);
+
+    CHECK(cache.hits() == 2);
+}
+
+template <std::size_t... Is>
+auto visitNumberedLabels(std::index_sequence<Is...>) -> bool
+{
+    const auto isLabel = jv::overload
+    (
+        [](const Button&) { return false; },
+        [](const Label&) { return true; },
+        [](const ToggleButton&) { return false; }
+    );
+
+    return (jv::dispatcher<WidgetHierarchy>::visit(isLabel, NumberedLabel<Is>{}) && ...);
+}
+
+TEST_CASE("single-dispatch remembers every unlisted type it resolves")
+{
+    const auto before = jv::table_usage<WidgetHierarchy>().lookup_bytes;
+
+    CHECK(visitNumberedLabels(std::make_index_sequence<200>{}));
+    CHECK(visitNumberedLabels(std::make_index_sequence<200>{}));
+
+    //  Each of the 200 types has a slot of two pointers in the memo of derived types, which is at
+    //  most half full
+    //
+    CHECK(jv::table_usage<WidgetHierarchy>().lookup_bytes >= before + 2 * 200 * 2 * sizeof(void*));
+}
+
+TEST_CASE("table_usage reports lookup and dispatch table sizes")
+{
+    using StatsHierarchy = jv::hierarchy
+    <
+        jv::base_type<Shape>,
+        jv::concrete_types<Square, Circle>,
+        jv::table_dispatch,
+        jv::vtable_key
+    >;
+
+    const auto name = jv::overload([](const Square&) { return 1; }, [](const Circle&) { return 2; });
+    const auto sides = jv::overload([](auto& shape, int& n) { n = 0; static_cast<void>(shape); });
+
+    auto square = Square{};
+    auto n = 1;
+
+    CHECK(jv::dispatcher<StatsHierarchy>::visit(name, square) == 1);
+    CHECK(jv::dispatcher<StatsHierarchy>::visit(name, static_cast<const Shape&>(square)) == 1);
+    jv::dispatcher<StatsHierarchy>::visit(sides, square, n);
+    CHECK(n == 0);
+
+    const auto stats = jv::table_usage<StatsHierarchy>();
+
+    CHECK(stats.lookup_bytes > 0);
+    CHECK(stats.dispatch_tables == 3);
+    CHECK(stats.dispatch_table_bytes == 3 * 2 * sizeof(void(*)()));
+    CHECK(stats.total_bytes() == stats.lookup_bytes + stats.dispatch_table_bytes);
+
+    //  Small hierarchies dispatch through a switch, without a table
+    //
+    CHECK(jv::table_usage<ShapeHierarchy>().dispatch_tables == 0);
+}
+
+TEST_CASE("visit through tagged pointers")
+{
+    using Dispatcher = jv::dispatcher<ShapeHierarchy>;
+
+    const auto name = jv::overload(
+        [](const Square&) { return "square"s; },
+        [](const Circle&) { return "circle"s; });
+
+    auto square = Square{};
+    auto circle = Circle{};
+    auto bad = BadShape{};
+
+    const auto p = jv::tagged_ptr<ShapeHierarchy>{&square};
+    const auto q = jv::tagged_ptr<ShapeHierarchy, const Shape>::of(static_cast<const Shape&>(circle));
+
+    CHECK(p.get() == &square);
+    CHECK(p.ordinal() == 0);
+    CHECK(q.get() == &circle);
+    CHECK(q.ordinal() == 1);
+    CHECK(Dispatcher::visit(name, p) == "square"s);
+    CHECK(Dispatcher::visit(name, q) == "circle"s);
+    CHECK(Dispatcher::visit(name, jv::tagged_ptr<ShapeHierarchy, const Shape>{p}) == "square"s);
+    CHECK_FALSE(jv::tagged_ptr<ShapeHierarchy>{});
+    CHECK_THROWS_AS(jv::tagged_ptr<ShapeHierarchy>::of(bad), jv::unhandled_type);
+
+    auto shapes = std::vector<jv::tagged_unique_ptr<ShapeHierarchy>>{};
+
+    for (auto i = 0; i < 10; ++i)
+    {
+        if (i % 2)
+            shapes.push_back(jv::make_tagged<ShapeHierarchy, Square>());
+        else
+            shapes.push_back(jv::tagged_unique_ptr<ShapeHierarchy>::of(std::make_unique<Circle>()));
+    }
+
+    CHECK(Dispatcher::visit(name, shapes[0]) == "circle"s);
+    CHECK(Dispatcher::visit(name, shapes[1]) == "square"s);
+
+    auto names = std::vector<std::string>{};
+    Dispatcher::visit_all(name, shapes.begin(), shapes.end(), std::back_inserter(names));
+
+    CHECK(names.size() == 10);
+    CHECK(names[0] == "circle"s);
+    CHECK(names[9] == "square"s);
+
+    const auto raw = shapes[1].release();
+    shapes[0].reset(jv::tagged_ptr<ShapeHierarchy>::of(*raw));
+
+    CHECK_FALSE(shapes[1]);
+    CHECK(shapes[0].ordinal() == 0);
+    CHECK(shapes[0].get() == raw);
+}
+
+TEST_CASE("tagged pointers take the ordinal from a pointer only to a type nothing listed derives from")
+{
+    using button_ptr = jv::tagged_ptr<WidgetHierarchy>;
+
+    static_assert(std::is_constructible_v<button_ptr, Label*>);
+    static_assert(std::is_constructible_v<button_ptr, ToggleButton*>);
+    static_assert(!std::is_constructible_v<button_ptr, Button*>);
+    static_assert(!std::is_constructible_v<jv::tagged_unique_ptr<WidgetHierarchy>, std::unique_ptr<Button>>);
+
+    auto button = Button{};
+    auto toggle = ToggleButton{};
+
+    CHECK(button_ptr::exactly(&button).ordinal() == 0);
+    CHECK(button_ptr::of(static_cast<Button&>(toggle)).ordinal() == 2);
+    CHECK(jv::make_tagged<WidgetHierarchy, Button>().ordinal() == 0);
+}
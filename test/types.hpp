@@ -1,6 +1,7 @@
 #pragma once
 #include <josa/visitor/hierarchy.hpp>
 #include <memory>
+#include <typeinfo>
 
 struct Color
 {
@@ -179,3 +180,15 @@ struct NonCopyableNonMoveable
     auto operator = (NonCopyableNonMoveable&&) -> NonCopyableNonMoveable& = delete;
     ~NonCopyableNonMoveable() = default;
 };
+
+//--------------------------------------------------------------------------------------------------
+
+#if defined(__GLIBCXX__)
+//  Another type_info object for a type, as a shared object that does not merge its type_info with
+//  the program's would emit.
+//
+struct ForeignTypeInfo : std::type_info
+{
+    explicit ForeignTypeInfo(const std::type_info& type) : std::type_info{type.name()} {}
+};
+#endif